@@ -0,0 +1,305 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCAudioFrameHub.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "TRTCMpscQueue.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+constexpr uint32_t kIdleWaitMs = 100;
+constexpr uint32_t kMaxUserIdBytes = 64;
+
+// Converted copy of the frame being dispatched, reused across calls on the same SDK thread.
+struct Conversion {
+  TRTCAudioFormat format;
+  std::vector<uint8_t> data;
+  uint32_t frames = 0;
+};
+
+struct ConversionScratch {
+  std::vector<Conversion> conversions;
+  uint32_t used = 0;
+};
+
+float sampleAt(const TRTCAudioBlock& src, uint32_t frame, uint32_t channel, uint32_t dstChannels) {
+  const int16_t* samples = src.int16Samples() + static_cast<size_t>(frame) * src.channels;
+  if (dstChannels == 1 && src.channels > 1) {
+    int32_t sum = 0;
+    for (uint32_t c = 0; c < src.channels; ++c) {
+      sum += samples[c];
+    }
+    return static_cast<float>(sum) / static_cast<float>(src.channels);
+  }
+  return samples[std::min(channel, src.channels - 1)];
+}
+
+// Rate, channel and sample type conversion of an Int16 block in one pass.
+void convert(const TRTCAudioBlock& src, Conversion& dst) {
+  const TRTCAudioFormat& format = dst.format;
+  const uint32_t frames = format.sampleRate == src.sampleRate
+                              ? src.frames
+                              : static_cast<uint32_t>(static_cast<uint64_t>(src.frames) * format.sampleRate /
+                                                      src.sampleRate);
+  const bool toFloat = format.sampleType == TRTCAudioSampleType::Float32;
+  dst.frames = frames;
+  dst.data.resize(static_cast<size_t>(frames) * format.channels * (toFloat ? 4 : 2));
+  float* floatOut = reinterpret_cast<float*>(dst.data.data());
+  int16_t* int16Out = reinterpret_cast<int16_t*>(dst.data.data());
+  const double step = static_cast<double>(src.sampleRate) / format.sampleRate;
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    const double position = frame * step;
+    const uint32_t i0 = std::min(static_cast<uint32_t>(position), src.frames - 1);
+    const uint32_t i1 = std::min(i0 + 1, src.frames - 1);
+    const float frac = static_cast<float>(position - i0);
+    for (uint32_t channel = 0; channel < format.channels; ++channel) {
+      const float s0 = sampleAt(src, i0, channel, format.channels);
+      const float value = frac > 0 ? s0 + (sampleAt(src, i1, channel, format.channels) - s0) * frac : s0;
+      const size_t index = static_cast<size_t>(frame) * format.channels + channel;
+      if (toFloat) {
+        floatOut[index] = value * (1.0f / 32768.0f);
+      } else {
+        int16Out[index] = static_cast<int16_t>(std::min(32767.0f, std::max(-32768.0f, value + 0.5f)));
+      }
+    }
+  }
+}
+
+// `native` converted to `wanted`, sharing the conversion with earlier consumers of the same frame.
+TRTCAudioBlock convertedBlock(const TRTCAudioBlock& native, const TRTCAudioFormat& wanted, ConversionScratch& scratch) {
+  TRTCAudioFormat format;
+  format.sampleRate = wanted.sampleRate ? wanted.sampleRate : native.sampleRate;
+  format.channels = wanted.channels ? wanted.channels : native.channels;
+  format.sampleType = wanted.sampleType;
+  if (format.sampleRate == native.sampleRate && format.channels == native.channels &&
+      format.sampleType == native.sampleType) {
+    return native;
+  }
+  Conversion* conversion = nullptr;
+  for (uint32_t i = 0; i < scratch.used; ++i) {
+    if (scratch.conversions[i].format == format) {
+      conversion = &scratch.conversions[i];
+      break;
+    }
+  }
+  if (!conversion) {
+    if (scratch.used == scratch.conversions.size()) {
+      scratch.conversions.emplace_back();
+    }
+    conversion = &scratch.conversions[scratch.used++];
+    conversion->format = format;
+    convert(native, *conversion);
+  }
+  TRTCAudioBlock block = native;
+  block.sampleRate = format.sampleRate;
+  block.channels = format.channels;
+  block.sampleType = format.sampleType;
+  block.data = conversion->data.data();
+  block.frames = conversion->frames;
+  return block;
+}
+
+}  // namespace
+
+class TRTCAudioFrameHub::Consumer : public FRunnable {
+ public:
+  Consumer(TRTCAudioFrameConsumer* target, const TRTCAudioConsumerOptions& options)
+      : target_(target), options_(options), queue_(queued() ? std::max<uint32_t>(options.queueBlocks, 2) : 2) {
+    if (queued()) {
+      wake_ = FPlatformProcess::GetSynchEventFromPool(false);
+      thread_ = FRunnableThread::Create(this, TEXT("TRTCAudioConsumer"), 0, TPri_BelowNormal);
+    }
+  }
+
+  ~Consumer() override {
+    if (thread_) {
+      stopping_.store(true);
+      wake_->Trigger();
+      thread_->WaitForCompletion();
+      delete thread_;
+    }
+    if (wake_) {
+      FPlatformProcess::ReturnSynchEventToPool(wake_);
+    }
+  }
+
+  TRTCAudioFrameConsumer* target() const { return target_; }
+  const TRTCAudioConsumerOptions& options() const { return options_; }
+
+  TRTCAudioConsumerStats stats() const {
+    TRTCAudioConsumerStats stats;
+    stats.delivered = delivered_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  void deliver(const TRTCAudioBlock& block) {
+    if (!queued()) {
+      target_->onAudioBlock(block);
+      delivered_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    const bool pushed = queue_.tryPush([&block](Cell& cell) {
+      cell.block = block;
+      std::snprintf(cell.userId, kMaxUserIdBytes, "%s", block.userId);
+      const uint8_t* data = static_cast<const uint8_t*>(block.data);
+      cell.data.assign(data, data + block.bytes());
+    });
+    if (!pushed) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      if (options_.dropPolicy == TRTCAudioDropPolicy::DropOldest) {
+        overflowed_.store(true, std::memory_order_relaxed);
+      }
+      return;
+    }
+    wake_->Trigger();
+  }
+
+  uint32 Run() override {
+    while (!stopping_.load()) {
+      wake_->Wait(kIdleWaitMs);
+      drain();
+    }
+    return 0;
+  }
+
+ private:
+  struct Cell {
+    TRTCAudioBlock block;
+    char userId[kMaxUserIdBytes];
+    // Keeps its capacity once the queue has wrapped, so steady-state pushes do not allocate.
+    std::vector<uint8_t> data;
+  };
+
+  bool queued() const { return options_.delivery == TRTCAudioDelivery::Queued; }
+
+  void drain() {
+    if (overflowed_.exchange(false, std::memory_order_relaxed)) {
+      for (uint32_t skip = queue_.size() / 2; skip > 0 && queue_.tryPop([](Cell&) {}); --skip) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    while (!stopping_.load(std::memory_order_relaxed) && queue_.tryPop([this](Cell& cell) {
+      TRTCAudioBlock block = cell.block;
+      block.userId = cell.userId;
+      block.data = cell.data.data();
+      target_->onAudioBlock(block);
+    })) {
+      delivered_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  TRTCAudioFrameConsumer* const target_;
+  const TRTCAudioConsumerOptions options_;
+  TRTCMpscQueue<Cell> queue_;
+  FEvent* wake_ = nullptr;
+  FRunnableThread* thread_ = nullptr;
+  std::atomic<bool> stopping_{false};
+  std::atomic<bool> overflowed_{false};
+  std::atomic<uint64_t> delivered_{0};
+  std::atomic<uint64_t> dropped_{0};
+};
+
+TRTCAudioFrameHub::TRTCAudioFrameHub() = default;
+
+TRTCAudioFrameHub::~TRTCAudioFrameHub() = default;
+
+void TRTCAudioFrameHub::addConsumer(TRTCAudioFrameConsumer* consumer, const TRTCAudioConsumerOptions& options) {
+  if (!consumer) {
+    return;
+  }
+  removeConsumer(consumer);
+  std::unique_ptr<Consumer> entry = std::make_unique<Consumer>(consumer, options);
+  FWriteScopeLock lock(lock_);
+  consumers_.push_back(std::move(entry));
+}
+
+void TRTCAudioFrameHub::removeConsumer(TRTCAudioFrameConsumer* consumer) {
+  // The delivery thread is joined after the lock is released, so SDK threads never wait for a slow consumer.
+  std::unique_ptr<Consumer> removed;
+  {
+    FWriteScopeLock lock(lock_);
+    auto it = std::find_if(consumers_.begin(), consumers_.end(),
+                           [consumer](const std::unique_ptr<Consumer>& entry) { return entry->target() == consumer; });
+    if (it == consumers_.end()) {
+      return;
+    }
+    removed = std::move(*it);
+    consumers_.erase(it);
+  }
+}
+
+TRTCAudioConsumerStats TRTCAudioFrameHub::consumerStats(const TRTCAudioFrameConsumer* consumer) const {
+  FReadScopeLock lock(lock_);
+  for (const std::unique_ptr<Consumer>& entry : consumers_) {
+    if (entry->target() == consumer) {
+      return entry->stats();
+    }
+  }
+  return TRTCAudioConsumerStats();
+}
+
+void TRTCAudioFrameHub::setCaptureProcessor(TRTCAudioFrameProcessor* processor) {
+  FWriteScopeLock lock(lock_);
+  capture_processor_ = processor;
+}
+
+void TRTCAudioFrameHub::onCapturedRawAudioFrame(TRTCAudioFrame* frame) {
+  dispatch(TRTCAudioSource_Captured, frame, nullptr);
+}
+
+void TRTCAudioFrameHub::onLocalProcessedAudioFrame(TRTCAudioFrame* frame) {
+  dispatch(TRTCAudioSource_LocalProcessed, frame, nullptr);
+}
+
+void TRTCAudioFrameHub::onPlayAudioFrame(TRTCAudioFrame* frame, const char* userId) {
+  if (userId && userId[0] != '\0') {
+    dispatch(TRTCAudioSource_Remote, frame, userId);
+  }
+}
+
+void TRTCAudioFrameHub::onMixedPlayAudioFrame(TRTCAudioFrame* frame) {
+  dispatch(TRTCAudioSource_Mixed, frame, nullptr);
+}
+
+void TRTCAudioFrameHub::dispatch(TRTCAudioSource source, TRTCAudioFrame* frame, const char* userId) {
+  if (!frame || !frame->data || frame->audioFormat != TRTCAudioFrameFormatPCM || frame->channel == 0 ||
+      frame->sampleRate == 0) {
+    return;
+  }
+  TRTCAudioBlock native;
+  native.source = source;
+  native.userId = userId ? userId : "";
+  native.sampleRate = frame->sampleRate;
+  native.channels = frame->channel;
+  native.sampleType = TRTCAudioSampleType::Int16;
+  native.data = frame->data;
+  native.frames = frame->length / (2 * frame->channel);
+  native.timestamp = frame->timestamp;
+  if (native.frames == 0) {
+    return;
+  }
+  // Conversions live for one dispatch; each SDK thread has its own so the callbacks may run concurrently.
+  thread_local ConversionScratch scratch;
+  scratch.used = 0;
+  FReadScopeLock lock(lock_);
+  if (source == TRTCAudioSource_Captured && capture_processor_) {
+    capture_processor_->processCapturedAudio(reinterpret_cast<int16_t*>(frame->data), native.frames, native.channels,
+                                             native.sampleRate);
+  }
+  for (const std::unique_ptr<Consumer>& consumer : consumers_) {
+    if (consumer->options().sources & source) {
+      consumer->deliver(convertedBlock(native, consumer->options().format, scratch));
+    }
+  }
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,121 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCAudioJitterBuffer.h"
+
+#include <algorithm>
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+// The ring is sized for twice the maximum latency at this rate; faster inputs get a proportionally shorter maximum.
+constexpr uint32_t kRingSampleRate = 48000;
+// Weight of the newest fill level in the smoothed one; with 10 ms output blocks this averages over about 200 ms.
+constexpr double kFillSmoothing = 0.05;
+
+uint32_t samplesFor(uint32_t ms, uint32_t sampleRate) {
+  return static_cast<uint32_t>(static_cast<uint64_t>(ms) * sampleRate / 1000);
+}
+
+}  // namespace
+
+TRTCAudioJitterBuffer::TRTCAudioJitterBuffer(const TRTCAudioJitterConfig& config) : config_(config) {
+  const uint32_t needed = 2 * samplesFor(std::max(config.maxLatencyMs, config.targetLatencyMs), kRingSampleRate);
+  uint32_t capacity = 1024;
+  while (capacity < needed) {
+    capacity *= 2;
+  }
+  mask_ = capacity - 1;
+  ring_ = std::make_unique<float[]>(capacity);
+}
+
+void TRTCAudioJitterBuffer::push(const float* mono, uint32_t frames, uint32_t sampleRate) {
+  if (!mono || frames == 0 || sampleRate == 0) {
+    return;
+  }
+  input_rate_.store(sampleRate, std::memory_order_relaxed);
+  const uint64_t write = write_.load(std::memory_order_relaxed);
+  const uint64_t read = read_.load(std::memory_order_acquire);
+  if (write - read + frames > mask_ + 1) {
+    dropped_blocks_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    ring_[(write + frame) & mask_] = mono[frame];
+  }
+  write_.store(write + frames, std::memory_order_release);
+}
+
+void TRTCAudioJitterBuffer::pop(float* out, uint32_t frames, uint32_t outputSampleRate) {
+  if (outputSampleRate == 0) {
+    std::fill(out, out + frames, 0.0f);
+    return;
+  }
+  uint64_t read = read_.load(std::memory_order_relaxed);
+  if (reset_requested_.exchange(false, std::memory_order_acq_rel)) {
+    read = write_.load(std::memory_order_acquire);
+    priming_ = true;
+  }
+  const uint32_t inputRate = input_rate_.load(std::memory_order_relaxed);
+  const uint32_t target = std::max<uint32_t>(1, samplesFor(config_.targetLatencyMs, inputRate));
+  const uint32_t maxFill = std::min<uint32_t>(std::max(target, samplesFor(config_.maxLatencyMs, inputRate)), mask_ / 2);
+  uint32_t available = static_cast<uint32_t>(write_.load(std::memory_order_acquire) - read);
+
+  if (priming_) {
+    if (available < target) {
+      std::fill(out, out + frames, 0.0f);
+      read_.store(read, std::memory_order_release);
+      return;
+    }
+    priming_ = false;
+    phase_ = 0;
+    smoothed_fill_ = available;
+  }
+  if (available > maxFill) {
+    // A stall on the reader side (or a burst from the network) would otherwise become permanent latency.
+    const uint32_t skip = available - target;
+    read += skip;
+    available -= skip;
+    smoothed_fill_ = available;
+    skipped_samples_.fetch_add(skip, std::memory_order_relaxed);
+  }
+
+  smoothed_fill_ += (available - smoothed_fill_) * kFillSmoothing;
+  const double error = std::min(1.0, std::max(-1.0, (smoothed_fill_ - target) / target));
+  const double ratio =
+      static_cast<double>(inputRate) / outputSampleRate * (1.0 + config_.maxDriftCorrection * error);
+
+  double phase = phase_;
+  uint32_t written = 0;
+  for (; written < frames; ++written) {
+    const uint32_t index = static_cast<uint32_t>(phase);
+    if (index + 1 >= available) {
+      break;
+    }
+    const float frac = static_cast<float>(phase - index);
+    const float s0 = ring_[(read + index) & mask_];
+    const float s1 = ring_[(read + index + 1) & mask_];
+    out[written] = s0 + (s1 - s0) * frac;
+    phase += ratio;
+  }
+  if (written < frames) {
+    std::fill(out + written, out + frames, 0.0f);
+    underruns_.fetch_add(1, std::memory_order_relaxed);
+    priming_ = true;
+  }
+  const uint32_t consumed = std::min(static_cast<uint32_t>(phase), available);
+  phase_ = phase - consumed;
+  read_.store(read + consumed, std::memory_order_release);
+}
+
+TRTCAudioJitterStats TRTCAudioJitterBuffer::stats() const {
+  TRTCAudioJitterStats stats;
+  stats.underruns = underruns_.load(std::memory_order_relaxed);
+  stats.droppedBlocks = dropped_blocks_.load(std::memory_order_relaxed);
+  stats.skippedSamples = skipped_samples_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,141 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCAudioLevelBinding.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Engine/Texture2D.h"
+#include "Materials/MaterialParameterCollectionInstance.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+// Levels closer than this to their target snap to it, so smoothing settles and the texture stops being uploaded.
+constexpr float kSettleLevel = 0.5f / 255.f;
+
+float smoothing(float deltaSeconds, float timeConstant) {
+  return timeConstant > 0.f ? 1.f - std::exp(-deltaSeconds / timeConstant) : 1.f;
+}
+
+uint8_t toByte(float value) {
+  return static_cast<uint8_t>(std::min(std::max(value, 0.f), 1.f) * 255.f + 0.5f);
+}
+
+}  // namespace
+
+TRTCAudioLevelBinding::TRTCAudioLevelBinding(const TRTCRoster& roster, const TRTCAudioLevelConfig& config)
+    : roster_(roster),
+      config_(config),
+      levels_(std::max<uint32_t>(config.slots, 1), 0.f),
+      texels_(levels_.size(), FColor(0, 0, 0, 0)),
+      reported_(levels_.size()),
+      staging_(std::make_shared<Staging>()) {
+  staging_->texels.resize(texels_.size());
+  texture_ = UTexture2D::CreateTransient(static_cast<int32>(texels_.size()), 1, PF_B8G8R8A8);
+  if (texture_) {
+    texture_->SRGB = false;
+    texture_->Filter = TF_Nearest;
+    texture_->UpdateResource();
+  }
+}
+
+TRTCAudioLevelBinding::~TRTCAudioLevelBinding() = default;
+
+void TRTCAudioLevelBinding::bindCollection(UMaterialParameterCollectionInstance* collection,
+                                           uint32_t vectorCount,
+                                           const FString& prefix) {
+  collection_ = collection;
+  collection_dirty_ = true;
+  parameter_names_.clear();
+  if (!collection) {
+    return;
+  }
+  const uint32_t count = std::min<uint32_t>(vectorCount, static_cast<uint32_t>((levels_.size() + 3) / 4));
+  parameter_names_.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    parameter_names_.emplace_back(*FString::Printf(TEXT("%s%u"), *prefix, i));
+  }
+}
+
+void TRTCAudioLevelBinding::tick(float deltaSeconds) {
+  const uint32_t slots = static_cast<uint32_t>(levels_.size());
+  std::fill(reported_.begin(), reported_.end(), FColor(0, 0, 0, 0));
+  roster_.forEachUser([this, slots](TRTCUserHandle handle) {
+    const uint32_t slot = roster_.slot(handle);
+    if (slot < slots) {
+      const bool speaking = (roster_.flags(handle) & TRTCUserFlag_Speaking) != 0;
+      reported_[slot] = FColor(0, speaking ? 255 : 0, toByte(roster_.volume(handle) / 100.f), 255);
+    }
+  });
+
+  const float attack = smoothing(deltaSeconds, config_.attackSeconds);
+  const float release = smoothing(deltaSeconds, config_.releaseSeconds);
+  for (uint32_t slot = 0; slot < slots; ++slot) {
+    FColor texel = reported_[slot];
+    const float target = texel.B / 255.f;
+    float& level = levels_[slot];
+    level += (target - level) * (target > level ? attack : release);
+    if (std::abs(target - level) < kSettleLevel) {
+      level = target;
+    }
+    texel.R = toByte(level);
+    if (texel != texels_[slot]) {
+      texels_[slot] = texel;
+      texture_dirty_ = true;
+      collection_dirty_ = true;
+    }
+  }
+
+  publishTexture();
+  publishCollection();
+}
+
+void TRTCAudioLevelBinding::publishTexture() {
+  // One upload in flight at a time; a tick that finds the previous one pending leaves the texture dirty for the next.
+  // Without a resource `UpdateTextureRegions` would never run the cleanup, leaving the upload pending forever.
+  if (!texture_ || !texture_dirty_ || !texture_->GetResource() || staging_->uploading.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::copy(texels_.begin(), texels_.end(), staging_->texels.begin());
+  staging_->uploading.store(true, std::memory_order_relaxed);
+  texture_dirty_ = false;
+  const uint32_t width = static_cast<uint32_t>(texels_.size());
+  FUpdateTextureRegion2D* region = new FUpdateTextureRegion2D(0, 0, 0, 0, width, 1);
+  texture_->UpdateTextureRegions(0, 1, region, width * sizeof(FColor), sizeof(FColor),
+                                 reinterpret_cast<uint8*>(staging_->texels.data()),
+                                 [staging = staging_](uint8*, const FUpdateTextureRegion2D* regions) {
+                                   delete regions;
+                                   staging->uploading.store(false, std::memory_order_release);
+                                 });
+}
+
+void TRTCAudioLevelBinding::publishCollection() {
+  UMaterialParameterCollectionInstance* collection = collection_.Get();
+  if (!collection || !collection_dirty_) {
+    return;
+  }
+  collection_dirty_ = false;
+  // The collection sends its values to the render thread once per frame, however many are set.
+  const uint32_t slots = static_cast<uint32_t>(levels_.size());
+  for (uint32_t i = 0; i < static_cast<uint32_t>(parameter_names_.size()); ++i) {
+    float values[4] = {};
+    for (uint32_t c = 0; c < 4 && 4 * i + c < slots; ++c) {
+      values[c] = levels_[4 * i + c];
+    }
+    collection->SetVectorParameterValue(parameter_names_[i], FLinearColor(values[0], values[1], values[2], values[3]));
+  }
+}
+
+void TRTCAudioLevelBinding::AddReferencedObjects(FReferenceCollector& collector) {
+  collector.AddReferencedObject(texture_);
+}
+
+FString TRTCAudioLevelBinding::GetReferencerName() const {
+  return TEXT("TRTCAudioLevelBinding");
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -80,6 +80,22 @@ void TRTCCloud::setDefaultStreamRecvMode(bool autoRecvAudio, bool autoRecvVideo)
   trtc_cloud_->setDefaultStreamRecvMode(autoRecvAudio, autoRecvVideo);
 }
 
+TRTCCloud* TRTCCloud::createSubCloud() {
+  liteav::ITRTCCloud* sub_cloud = trtc_cloud_->createSubCloud();
+  if (!sub_cloud) {
+    return nullptr;
+  }
+  return new TRTCCloud(sub_cloud);
+}
+
+void TRTCCloud::destroySubCloud(TRTCCloud* subCloud) {
+  if (!subCloud) {
+    return;
+  }
+  trtc_cloud_->destroySubCloud(subCloud->trtc_cloud_);
+  delete subCloud;
+}
+
 void TRTCCloud::startPublishing(const char* streamId, TRTCVideoStreamType streamType) {
   trtc_cloud_->startPublishing(streamId, streamType);
 }
@@ -0,0 +1,166 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCDirtyTiles.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "TRTCParallelRows.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+constexpr uint32_t kBlockBytes = 16;
+constexpr uint64_t kFoldPrime = 0x100000001B3ull;
+// Odd multipliers and seeds of the four hash lanes.
+alignas(16) constexpr uint32_t kLanePrimes[4] = {0x01000193u, 0x27D4EB2Fu, 0x165667B1u, 0x61C88647u};
+alignas(16) constexpr uint32_t kLaneSeeds[4] = {0x811C9DC5u, 0x2545F491u, 0x9E3779B9u, 0x7F4A7C15u};
+
+uint32_t bytesPerPixel(TRTCVideoPixelFormat format) {
+  switch (format) {
+    case TRTCVideoPixelFormat_BGRA32:
+    case TRTCVideoPixelFormat_RGBA32:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+// Xor then multiply by an odd constant in each 32-bit lane. Both steps are bijections of the 128-bit state, but the
+// state is folded to 64 bits at the end, so different segments can collide: a missed change is possible, if unlikely.
+uint64_t hashSegment(const uint8_t* data, uint32_t bytes) {
+  const VectorRegister4Int prime = VectorIntLoadAligned(kLanePrimes);
+  VectorRegister4Int state = VectorIntLoadAligned(kLaneSeeds);
+  uint32_t offset = 0;
+  for (; offset + kBlockBytes <= bytes; offset += kBlockBytes) {
+    state = VectorIntMultiply(VectorIntXor(state, VectorIntLoad(data + offset)), prime);
+  }
+  if (offset < bytes) {
+    alignas(16) uint8_t tail[kBlockBytes] = {};
+    std::memcpy(tail, data + offset, bytes - offset);
+    state = VectorIntMultiply(VectorIntXor(state, VectorIntLoad(tail)), prime);
+  }
+  alignas(16) uint32_t lanes[4];
+  VectorIntStore(state, lanes);
+  const uint64_t low = lanes[0] | (static_cast<uint64_t>(lanes[1]) << 32);
+  const uint64_t high = lanes[2] | (static_cast<uint64_t>(lanes[3]) << 32);
+  return low ^ ((high << 29) | (high >> 35));
+}
+
+}  // namespace
+
+TRTCDirtyTiles::TRTCDirtyTiles(uint32_t tileSize, float fullUploadRatio)
+    : tile_size_(std::max<uint32_t>(tileSize, 8)), full_upload_ratio_(fullUploadRatio) {}
+
+void TRTCDirtyTiles::hashRows(const TRTCFrameView& view, uint32_t rowBegin, uint32_t rowEnd) {
+  const uint32_t pixelBytes = bytesPerPixel(view.format);
+  const uint32_t tileBytes = tile_size_ * pixelBytes;
+  const uint32_t rowBytes = view.width * pixelBytes;
+  for (uint32_t row = rowBegin; row < rowEnd; ++row) {
+    const uint8_t* pixels = view.planes[0] + static_cast<size_t>(row) * view.strides[0];
+    uint64_t* hashes = &segment_hashes_[static_cast<size_t>(row) * columns_];
+    for (uint32_t column = 0; column < columns_; ++column) {
+      const uint32_t offset = column * tileBytes;
+      hashes[column] = hashSegment(pixels + offset, std::min(tileBytes, rowBytes - offset));
+    }
+  }
+}
+
+bool TRTCDirtyTiles::diff(const TRTCFrameView& view, std::vector<FUpdateTextureRegion2D>* regions) {
+  regions->clear();
+  const uint32_t pixelBytes = bytesPerPixel(view.format);
+  if (!view.isValid() || pixelBytes == 0) {
+    valid_ = false;
+    return false;
+  }
+  const bool reshaped = view.format != format_ || view.width != width_ || view.height != height_;
+  if (reshaped) {
+    format_ = view.format;
+    width_ = view.width;
+    height_ = view.height;
+    columns_ = (width_ + tile_size_ - 1) / tile_size_;
+    rows_ = (height_ + tile_size_ - 1) / tile_size_;
+    segment_hashes_.assign(static_cast<size_t>(height_) * columns_, 0);
+    tile_hashes_.assign(static_cast<size_t>(columns_) * rows_, 0);
+    dirty_.assign(tile_hashes_.size(), 1);
+  }
+
+  const size_t bytes = static_cast<size_t>(view.strides[0]) * height_;
+  TRTCParallelRows::forEachBand(height_, bytes, [this, &view](uint32_t rowBegin, uint32_t rowEnd) {
+    hashRows(view, rowBegin, rowEnd);
+  });
+
+  // Fold the segments of each tile row by row. A changed segment hash always changes the fold, so a changed tile is
+  // only missed when segment hashes collide.
+  changed_ = 0;
+  for (uint32_t tileRow = 0; tileRow < rows_; ++tileRow) {
+    const uint32_t rowBegin = tileRow * tile_size_;
+    const uint32_t rowEnd = std::min(height_, rowBegin + tile_size_);
+    for (uint32_t column = 0; column < columns_; ++column) {
+      uint64_t hash = kFoldPrime;
+      for (uint32_t row = rowBegin; row < rowEnd; ++row) {
+        hash = (hash ^ segment_hashes_[static_cast<size_t>(row) * columns_ + column]) * kFoldPrime;
+      }
+      const size_t tile = static_cast<size_t>(tileRow) * columns_ + column;
+      const bool changed = tile_hashes_[tile] != hash;
+      tile_hashes_[tile] = hash;
+      dirty_[tile] = changed ? 1 : 0;
+      changed_ += changed ? 1 : 0;
+    }
+  }
+  if (reshaped || !valid_) {
+    valid_ = true;
+    changed_ = tileCount();
+    return false;
+  }
+  if (changed_ > full_upload_ratio_ * tileCount()) {
+    return false;
+  }
+
+  // Runs of changed tiles per tile row; a run covering the same columns as one ending on the row above extends it.
+  struct Open {
+    uint32_t first;
+    uint32_t last;
+    size_t region;
+  };
+  std::vector<Open> above;
+  std::vector<Open> current;
+  for (uint32_t tileRow = 0; tileRow < rows_; ++tileRow) {
+    const uint8_t* dirty = &dirty_[static_cast<size_t>(tileRow) * columns_];
+    const uint32_t y = tileRow * tile_size_;
+    const uint32_t height = std::min(tile_size_, height_ - y);
+    current.clear();
+    size_t next = 0;
+    for (uint32_t column = 0; column < columns_;) {
+      if (!dirty[column]) {
+        ++column;
+        continue;
+      }
+      const uint32_t first = column;
+      while (column < columns_ && dirty[column]) {
+        ++column;
+      }
+      const uint32_t last = column - 1;
+      while (next < above.size() && above[next].last < first) {
+        ++next;
+      }
+      if (next < above.size() && above[next].first == first && above[next].last == last) {
+        FUpdateTextureRegion2D& region = (*regions)[above[next].region];
+        region.Height += height;
+        current.push_back(Open{first, last, above[next].region});
+        continue;
+      }
+      const uint32_t x = first * tile_size_;
+      const uint32_t width = std::min(width_, (last + 1) * tile_size_) - x;
+      regions->emplace_back(x, y, x, y, width, height);
+      current.push_back(Open{first, last, regions->size() - 1});
+    }
+    std::swap(above, current);
+  }
+  return true;
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,446 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCDownlinkAllocator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Misc/ScopeLock.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+// Hearing somebody is worth this many times seeing them small.
+constexpr float kAudioValue = 4.f;
+// Relative budget change that triggers a new allocation.
+constexpr float kBudgetResolveRatio = 0.05f;
+// Screen area change that triggers a new allocation.
+constexpr float kAreaResolveRatio = 0.25f;
+constexpr float kMeasureSmoothing = 0.3f;
+
+// Estimation: back off on loss or a poor network, probe up slowly while the budget is what limits the allocation.
+constexpr uint32_t kBackoffLossPercent = 10;
+constexpr uint32_t kProbeLossPercent = 2;
+constexpr float kBackoffFactor = 0.85f;
+constexpr float kProbeFactor = 1.08f;
+constexpr float kProbeUsage = 0.9f;
+
+constexpr uint8_t kAvailabilityFlags = TRTCUserFlag_AudioAvailable | TRTCUserFlag_VideoAvailable;
+
+uint32_t levelIndex(TRTCDownlinkLevel level) {
+  return static_cast<uint32_t>(level);
+}
+
+struct Upgrade {
+  float efficiency;
+  uint32_t slot;
+  uint8_t from;
+  uint8_t to;
+
+  bool operator<(const Upgrade& other) const { return efficiency < other.efficiency; }
+};
+
+}  // namespace
+
+TRTCDownlinkAllocator::TRTCDownlinkAllocator(TRTCCloud& cloud,
+                                             const TRTCRoster& roster,
+                                             const TRTCDownlinkConfig& config)
+    : cloud_(cloud),
+      roster_(roster),
+      config_(config),
+      fixed_budget_kbps_(config.budgetKbps),
+      budget_kbps_(static_cast<float>(config.budgetKbps ? config.budgetKbps : config.initialBudgetKbps)),
+      change_tokens_(static_cast<float>(std::max<uint32_t>(config.maxChangesPerSecond, 1))) {}
+
+TRTCDownlinkAllocator::~TRTCDownlinkAllocator() = default;
+
+TRTCDownlinkAllocator::User* TRTCDownlinkAllocator::userOf(TRTCUserHandle handle) {
+  const uint32_t slot = roster_.slot(handle);
+  if (slot == kTRTCInvalidSlot) {
+    return nullptr;
+  }
+  if (slot >= users_.size()) {
+    users_.resize(roster_.slotCount());
+  }
+  User& user = users_[slot];
+  if (user.handle != handle) {
+    user = User();
+    user.handle = handle;
+    dirty_ = true;
+  }
+  return &user;
+}
+
+const TRTCDownlinkAllocator::User* TRTCDownlinkAllocator::userOf(TRTCUserHandle handle) const {
+  const uint32_t slot = roster_.slot(handle);
+  if (slot >= users_.size() || users_[slot].handle != handle) {
+    return nullptr;
+  }
+  return &users_[slot];
+}
+
+void TRTCDownlinkAllocator::setPinned(TRTCUserHandle handle, bool pinned) {
+  User* user = userOf(handle);
+  if (user && user->pinned != pinned) {
+    user->pinned = pinned;
+    dirty_ = true;
+  }
+}
+
+void TRTCDownlinkAllocator::setScreenArea(TRTCUserHandle handle, uint32_t pixels) {
+  User* user = userOf(handle);
+  if (!user || user->area == pixels) {
+    return;
+  }
+  const float larger = static_cast<float>(std::max(user->area, pixels));
+  const float change = std::abs(static_cast<float>(user->area) - static_cast<float>(pixels));
+  if ((user->area == 0) != (pixels == 0) || change > kAreaResolveRatio * larger) {
+    dirty_ = true;
+  }
+  user->area = pixels;
+}
+
+void TRTCDownlinkAllocator::setBudgetKbps(uint32_t kbps) {
+  fixed_budget_kbps_ = kbps;
+  if (kbps) {
+    budget_kbps_ = static_cast<float>(kbps);
+  }
+}
+
+TRTCDownlinkLevel TRTCDownlinkAllocator::level(TRTCUserHandle handle) const {
+  const User* user = userOf(handle);
+  return user ? user->target : TRTCDownlinkLevel::Off;
+}
+
+void TRTCDownlinkAllocator::onNetworkQuality(TRTCQualityInfo localQuality,
+                                             TRTCQualityInfo* /*remoteQuality*/,
+                                             uint32_t /*remoteQualityCount*/) {
+  FScopeLock lock(&mutex_);
+  quality_ = localQuality.quality;
+}
+
+void TRTCDownlinkAllocator::onStatistics(const TRTCStatistics& statistics) {
+  FScopeLock lock(&mutex_);
+  incoming_.fresh = true;
+  incoming_.receivedBytes = statistics.receivedBytes;
+  incoming_.downLoss = statistics.downLoss;
+  incoming_.time = FPlatformTime::Seconds();
+  incoming_.remotes.resize(statistics.remoteStatisticsArraySize);
+  for (uint32_t i = 0; i < statistics.remoteStatisticsArraySize; ++i) {
+    const TRTCRemoteStatistics& remote = statistics.remoteStatisticsArray[i];
+    RemoteBitrate& bitrate = incoming_.remotes[i];
+    bitrate.userId = remote.userId ? remote.userId : "";
+    bitrate.streamType = remote.streamType;
+    bitrate.videoKbps = remote.videoBitrate;
+    bitrate.audioKbps = remote.audioBitrate;
+  }
+}
+
+void TRTCDownlinkAllocator::tick() {
+  const double now = FPlatformTime::Seconds();
+  const float deltaSeconds = last_tick_ > 0 ? static_cast<float>(now - last_tick_) : 0.f;
+  last_tick_ = now;
+
+  syncUsers(now);
+  updateBudget();
+  if (std::abs(budget_kbps_ - solved_budget_kbps_) > kBudgetResolveRatio * solved_budget_kbps_) {
+    dirty_ = true;
+  }
+  if (dirty_) {
+    solve();
+  }
+  apply(now, deltaSeconds);
+}
+
+void TRTCDownlinkAllocator::syncUsers(double now) {
+  if (users_.size() < roster_.slotCount()) {
+    users_.resize(roster_.slotCount());
+  }
+  for (User& user : users_) {
+    if (user.handle != kTRTCInvalidUserHandle && !roster_.isValid(user.handle)) {
+      user = User();
+      dirty_ = true;
+    }
+  }
+  speakers_.clear();
+  roster_.forEachUser([this, now](TRTCUserHandle handle) {
+    const uint32_t slot = roster_.slot(handle);
+    User& user = users_[slot];
+    if (user.handle != handle) {
+      user = User();
+      user.handle = handle;
+      dirty_ = true;
+    }
+    const uint8_t flags = roster_.flags(handle);
+    if ((flags ^ user.flags) & kAvailabilityFlags) {
+      dirty_ = true;
+    }
+    user.flags = flags;
+    if (flags & TRTCUserFlag_Speaking) {
+      user.lastSpoke = now;
+    }
+    user.rank = 0xFFFFFFFFu;
+    if (now - user.lastSpoke < config_.speakerMemorySeconds) {
+      speakers_.push_back(slot);
+    }
+  });
+
+  // Most recent speakers first; users speaking right now tie on the time and keep their slot order.
+  std::stable_sort(speakers_.begin(), speakers_.end(),
+                   [this](uint32_t a, uint32_t b) { return users_[a].lastSpoke > users_[b].lastSpoke; });
+  if (speakers_.size() > config_.speakerRanks) {
+    speakers_.resize(config_.speakerRanks);
+  }
+  for (uint32_t rank = 0; rank < speakers_.size(); ++rank) {
+    users_[speakers_[rank]].rank = rank;
+  }
+  if (speakers_ != previous_speakers_) {
+    previous_speakers_ = speakers_;
+    dirty_ = true;
+  }
+}
+
+void TRTCDownlinkAllocator::updateBudget() {
+  TRTCQuality quality;
+  {
+    FScopeLock lock(&mutex_);
+    std::swap(incoming_, draining_);
+    incoming_.fresh = false;
+    quality = quality_;
+  }
+  if (!draining_.fresh) {
+    return;
+  }
+
+  if (last_statistics_time_ > 0 && draining_.time > last_statistics_time_ &&
+      draining_.receivedBytes >= last_received_bytes_) {
+    measured_kbps_ = static_cast<float>((draining_.receivedBytes - last_received_bytes_) * 8 / 1000.0 /
+                                        (draining_.time - last_statistics_time_));
+  }
+  last_received_bytes_ = draining_.receivedBytes;
+  last_statistics_time_ = draining_.time;
+  stats_.measuredKbps = static_cast<uint32_t>(measured_kbps_);
+
+  for (const RemoteBitrate& remote : draining_.remotes) {
+    User* user = userOf(roster_.find(remote.userId.c_str()));
+    if (!user) {
+      continue;
+    }
+    auto learn = [](float& kbps, uint32_t sample) {
+      if (sample > 0) {
+        kbps = kbps > 0 ? kbps + kMeasureSmoothing * (sample - kbps) : static_cast<float>(sample);
+      }
+    };
+    learn(user->measuredKbps[levelIndex(TRTCDownlinkLevel::AudioOnly)], remote.audioKbps);
+    if (remote.streamType == TRTCVideoStreamTypeBig) {
+      learn(user->measuredKbps[levelIndex(TRTCDownlinkLevel::Big)], remote.videoKbps);
+    } else if (remote.streamType == TRTCVideoStreamTypeSmall) {
+      learn(user->measuredKbps[levelIndex(TRTCDownlinkLevel::Small)], remote.videoKbps);
+    }
+  }
+
+  if (fixed_budget_kbps_) {
+    budget_kbps_ = static_cast<float>(fixed_budget_kbps_);
+    return;
+  }
+  if (quality >= TRTCQuality_Down) {
+    budget_kbps_ = static_cast<float>(config_.minBudgetKbps);
+  } else if (draining_.downLoss > kBackoffLossPercent || quality >= TRTCQuality_Bad) {
+    budget_kbps_ *= kBackoffFactor;
+  } else if (draining_.downLoss < kProbeLossPercent && quality <= TRTCQuality_Good &&
+             static_cast<float>(stats_.allocatedKbps) >= kProbeUsage * budget_kbps_) {
+    budget_kbps_ *= kProbeFactor;
+  }
+  budget_kbps_ = std::min(std::max(budget_kbps_, static_cast<float>(config_.minBudgetKbps)),
+                          static_cast<float>(std::max(config_.maxBudgetKbps, config_.minBudgetKbps)));
+}
+
+float TRTCDownlinkAllocator::cost(const User& user, TRTCDownlinkLevel level) const {
+  const float* measured = user.measuredKbps;
+  float kbps = 0;
+  if (level >= TRTCDownlinkLevel::AudioOnly && (user.flags & TRTCUserFlag_AudioAvailable)) {
+    const float audio = measured[levelIndex(TRTCDownlinkLevel::AudioOnly)];
+    kbps += audio > 0 ? audio : config_.audioKbps;
+  }
+  if (level >= TRTCDownlinkLevel::Small) {
+    const float video = measured[levelIndex(level)];
+    kbps += video > 0 ? video : (level == TRTCDownlinkLevel::Big ? config_.bigKbps : config_.smallKbps);
+  }
+  return kbps;
+}
+
+void TRTCDownlinkAllocator::solve() {
+  dirty_ = false;
+  solved_budget_kbps_ = budget_kbps_;
+  ++stats_.solves;
+
+  // Cumulative value and cost of each level per user; levels that add nothing are never granted.
+  struct Choice {
+    float value[kTRTCDownlinkLevelCount];
+    float cost[kTRTCDownlinkLevelCount];
+    uint8_t level;
+  };
+  std::vector<Choice> choices(users_.size());
+  const float bigMinArea = static_cast<float>(std::max<uint32_t>(config_.bigMinAreaPixels, 1));
+  for (uint32_t slot = 0; slot < users_.size(); ++slot) {
+    User& user = users_[slot];
+    Choice& choice = choices[slot];
+    choice.level = levelIndex(TRTCDownlinkLevel::Off);
+    if (user.handle == kTRTCInvalidUserHandle) {
+      std::fill(std::begin(choice.value), std::end(choice.value), 0.f);
+      std::fill(std::begin(choice.cost), std::end(choice.cost), 0.f);
+      continue;
+    }
+    user.priority = 1.f + (user.pinned ? config_.pinnedWeight : 0.f) +
+                    (user.rank < config_.speakerRanks ? config_.speakerWeight / (1.f + user.rank) : 0.f);
+    const bool audio = (user.flags & TRTCUserFlag_AudioAvailable) != 0;
+    const bool video = (user.flags & TRTCUserFlag_VideoAvailable) != 0;
+    const float area = user.pinned ? std::max(static_cast<float>(user.area), bigMinArea) : user.area;
+    float* value = choice.value;
+    value[0] = 0.f;
+    value[1] = audio ? user.priority * kAudioValue : 0.f;
+    value[2] = value[1] + (video && area > 0 ? user.priority : 0.f);
+    value[3] = value[2] + (video && area >= bigMinArea
+                               ? user.priority * config_.areaWeight * std::min(area / bigMinArea, 4.f)
+                               : 0.f);
+    const uint8_t current = user.applied == kUnapplied ? levelIndex(user.target) : user.applied;
+    value[current] *= 1.f + config_.stickiness;
+    for (uint32_t level = 0; level < kTRTCDownlinkLevelCount; ++level) {
+      choice.cost[level] = cost(user, static_cast<TRTCDownlinkLevel>(level));
+    }
+  }
+
+  // Best upgrade of `slot` from its level that fits in `remaining`; efficiency is value gained per kbps.
+  auto bestUpgrade = [&choices](uint32_t slot, float remaining, Upgrade* upgrade) {
+    const Choice& choice = choices[slot];
+    bool found = false;
+    for (uint8_t to = choice.level + 1; to < kTRTCDownlinkLevelCount; ++to) {
+      const float gain = choice.value[to] - choice.value[choice.level];
+      const float extra = choice.cost[to] - choice.cost[choice.level];
+      if (gain <= 0.f || extra > remaining) {
+        continue;
+      }
+      const float efficiency = extra > 0.f ? gain / extra : std::numeric_limits<float>::max();
+      if (!found || efficiency > upgrade->efficiency) {
+        *upgrade = Upgrade{efficiency, slot, choice.level, to};
+        found = true;
+      }
+    }
+    return found;
+  };
+
+  float remaining = budget_kbps_;
+  std::vector<Upgrade> heap;
+  heap.reserve(users_.size());
+  for (uint32_t slot = 0; slot < users_.size(); ++slot) {
+    Upgrade upgrade;
+    if (users_[slot].handle != kTRTCInvalidUserHandle && bestUpgrade(slot, remaining, &upgrade)) {
+      heap.push_back(upgrade);
+    }
+  }
+  std::make_heap(heap.begin(), heap.end());
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end());
+    const Upgrade upgrade = heap.back();
+    heap.pop_back();
+    Choice& choice = choices[upgrade.slot];
+    const float extra = choice.cost[upgrade.to] - choice.cost[upgrade.from];
+    if (extra <= remaining) {
+      choice.level = upgrade.to;
+      remaining -= extra;
+    }
+    // Either the next step up, or a smaller step that still fits now that the budget shrank.
+    Upgrade next;
+    if (bestUpgrade(upgrade.slot, remaining, &next)) {
+      heap.push_back(next);
+      std::push_heap(heap.begin(), heap.end());
+    }
+  }
+
+  std::fill(std::begin(stats_.users), std::end(stats_.users), 0u);
+  for (uint32_t slot = 0; slot < users_.size(); ++slot) {
+    User& user = users_[slot];
+    if (user.handle == kTRTCInvalidUserHandle) {
+      continue;
+    }
+    const TRTCDownlinkLevel target = static_cast<TRTCDownlinkLevel>(choices[slot].level);
+    if (target != user.target) {
+      // A new target is a new change; an old one still waiting is no longer deferred.
+      user.target = target;
+      user.deferred = false;
+    }
+    ++stats_.users[choices[slot].level];
+  }
+  stats_.budgetKbps = static_cast<uint32_t>(budget_kbps_);
+  stats_.allocatedKbps = static_cast<uint32_t>(budget_kbps_ - remaining);
+}
+
+void TRTCDownlinkAllocator::apply(double now, float deltaSeconds) {
+  const float rate = static_cast<float>(std::max<uint32_t>(config_.maxChangesPerSecond, 1));
+  change_tokens_ = std::min(rate, change_tokens_ + deltaSeconds * rate);
+
+  // Users the SDK still receives in full by default count as on the big stream.
+  auto appliedLevel = [](const User& user) {
+    return user.applied == kUnapplied ? levelIndex(TRTCDownlinkLevel::Big) : user.applied;
+  };
+  pending_.clear();
+  for (uint32_t slot = 0; slot < users_.size(); ++slot) {
+    const User& user = users_[slot];
+    if (user.handle != kTRTCInvalidUserHandle && user.applied != levelIndex(user.target)) {
+      pending_.push_back(slot);
+    }
+  }
+  if (pending_.empty()) {
+    return;
+  }
+  // Downgrades free the bandwidth upgrades use, so they go first; then the most important users.
+  std::sort(pending_.begin(), pending_.end(), [this, &appliedLevel](uint32_t a, uint32_t b) {
+    const bool downA = levelIndex(users_[a].target) < appliedLevel(users_[a]);
+    const bool downB = levelIndex(users_[b].target) < appliedLevel(users_[b]);
+    return downA != downB ? downA : users_[a].priority > users_[b].priority;
+  });
+  for (uint32_t slot : pending_) {
+    User& user = users_[slot];
+    const bool upgrade = levelIndex(user.target) > appliedLevel(user);
+    if (change_tokens_ < 1.f || (upgrade && now - user.lastChange < config_.minSwitchSeconds)) {
+      if (!user.deferred) {
+        user.deferred = true;
+        ++stats_.deferred;
+      }
+      continue;
+    }
+    change_tokens_ -= 1.f;
+    applyLevel(user, user.target, now);
+  }
+}
+
+void TRTCDownlinkAllocator::applyLevel(User& user, TRTCDownlinkLevel level, double now) {
+  const char* userId = roster_.userId(user.handle);
+  if (!userId) {
+    return;
+  }
+  const bool known = user.applied != kUnapplied;
+  const TRTCDownlinkLevel from = static_cast<TRTCDownlinkLevel>(user.applied);
+  const bool audio = level != TRTCDownlinkLevel::Off;
+  const bool video = level >= TRTCDownlinkLevel::Small;
+  if (!known || (from != TRTCDownlinkLevel::Off) != audio) {
+    cloud_.muteRemoteAudio(userId, !audio);
+  }
+  if (!known || (from >= TRTCDownlinkLevel::Small) != video) {
+    cloud_.muteRemoteVideoStream(userId, TRTCVideoStreamTypeBig, !video);
+  }
+  if (video && (!known || from != level)) {
+    cloud_.setRemoteVideoStreamType(
+        userId, level == TRTCDownlinkLevel::Big ? TRTCVideoStreamTypeBig : TRTCVideoStreamTypeSmall);
+  }
+  user.applied = levelIndex(level);
+  user.lastChange = now;
+  user.deferred = false;
+  ++stats_.changes;
+}
+
+}  // namespace ue
+}  // namespace liteav
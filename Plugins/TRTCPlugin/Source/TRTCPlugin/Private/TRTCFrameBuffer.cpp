@@ -0,0 +1,119 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCFrameBuffer.h"
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeLock.h"
+
+namespace liteav {
+namespace ue {
+
+TRTCFrameBuffer::TRTCFrameBuffer(TRTCVideoPixelFormat format, uint32_t width, uint32_t height) {
+  view_.format = format;
+  view_.width = width;
+  view_.height = height;
+  TRTCFrameView::alignedStrides(format, width, view_.strides);
+  size_ = TRTCFrameView::bufferSize(format, height, view_.strides);
+  if (size_ == 0) {
+    view_ = TRTCFrameView();
+    return;
+  }
+  data_ = static_cast<uint8_t*>(FMemory::Malloc(size_, kTRTCFrameStrideAlignment));
+  view_.assignPlanes(data_);
+}
+
+TRTCFrameBuffer::~TRTCFrameBuffer() {
+  FMemory::Free(data_);
+}
+
+struct TRTCFrameBufferPool::State {
+  using Key = std::tuple<int, uint32_t, uint32_t>;
+
+  explicit State(uint32_t maxPerSize) : maxBuffersPerSize(maxPerSize) {}
+
+  void recycle(TRTCFrameBuffer* buffer) {
+    {
+      FScopeLock lock(&mutex);
+      std::vector<TRTCFrameBuffer*>& bucket = idle[Key(buffer->format(), buffer->width(), buffer->height())];
+      if (bucket.size() < maxBuffersPerSize) {
+        buffer->setTimestamp(0);
+        bucket.push_back(buffer);
+        idleBytes += buffer->size();
+        return;
+      }
+    }
+    delete buffer;
+  }
+
+  void clear() {
+    std::map<Key, std::vector<TRTCFrameBuffer*>> released;
+    {
+      FScopeLock lock(&mutex);
+      released.swap(idle);
+      idleBytes = 0;
+    }
+    for (auto& bucket : released) {
+      for (TRTCFrameBuffer* buffer : bucket.second) {
+        delete buffer;
+      }
+    }
+  }
+
+  const uint32_t maxBuffersPerSize;
+  FCriticalSection mutex;
+  std::map<Key, std::vector<TRTCFrameBuffer*>> idle;
+  size_t idleBytes = 0;
+};
+
+TRTCFrameBufferPool::TRTCFrameBufferPool(uint32_t maxBuffersPerSize)
+    : state_(std::make_shared<State>(maxBuffersPerSize)) {}
+
+TRTCFrameBufferPool::~TRTCFrameBufferPool() {
+  state_->clear();
+}
+
+std::shared_ptr<TRTCFrameBuffer> TRTCFrameBufferPool::acquire(TRTCVideoPixelFormat format,
+                                                              uint32_t width,
+                                                              uint32_t height) {
+  TRTCFrameBuffer* buffer = nullptr;
+  {
+    FScopeLock lock(&state_->mutex);
+    auto it = state_->idle.find(State::Key(format, width, height));
+    if (it != state_->idle.end() && !it->second.empty()) {
+      buffer = it->second.back();
+      it->second.pop_back();
+      state_->idleBytes -= buffer->size();
+    }
+  }
+  if (!buffer) {
+    buffer = new TRTCFrameBuffer(format, width, height);
+    if (!buffer->view().isValid()) {
+      delete buffer;
+      return nullptr;
+    }
+  }
+  std::weak_ptr<State> weakState = state_;
+  return std::shared_ptr<TRTCFrameBuffer>(buffer, [weakState](TRTCFrameBuffer* released) {
+    if (std::shared_ptr<State> state = weakState.lock()) {
+      state->recycle(released);
+    } else {
+      delete released;
+    }
+  });
+}
+
+void TRTCFrameBufferPool::trim() {
+  state_->clear();
+}
+
+size_t TRTCFrameBufferPool::idleBytes() const {
+  FScopeLock lock(&state_->mutex);
+  return state_->idleBytes;
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,90 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCFrameScaler.h"
+
+#include <cmath>
+
+#include "TRTCParallelRows.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+uint32_t roundDownToEven(uint32_t value) {
+  return std::max<uint32_t>(2, value & ~1u);
+}
+
+template <TRTCVideoPixelFormat Format>
+void scaleWith(const TRTCFrameView& src, const TRTCFrameView& dst, uint32_t boxFactor) {
+  // The box filter reads every source pixel, so the source size decides whether the work is worth splitting.
+  uint32_t strides[3];
+  TRTCFrameView::alignedStrides(Format, boxFactor > 1 ? src.width : dst.width, strides);
+  const size_t work = TRTCFrameView::bufferSize(Format, boxFactor > 1 ? src.height : dst.height, strides);
+  TRTCParallelRows::forEachBand(dst.height, work, [&src, &dst, boxFactor](uint32_t rowBegin, uint32_t rowEnd) {
+    if (boxFactor > 1) {
+      TRTCFrameScaler<Format>::boxDownscaleRows(src, dst, boxFactor, rowBegin, rowEnd);
+    } else {
+      TRTCFrameScaler<Format>::bilinearRows(src, dst, rowBegin, rowEnd);
+    }
+  });
+}
+
+}  // namespace
+
+void computeDownscaleSize(TRTCDownscaleMode mode,
+                          uint32_t srcWidth,
+                          uint32_t srcHeight,
+                          uint32_t displayWidth,
+                          uint32_t displayHeight,
+                          uint32_t* dstWidth,
+                          uint32_t* dstHeight,
+                          uint32_t* boxFactor) {
+  *dstWidth = srcWidth;
+  *dstHeight = srcHeight;
+  *boxFactor = 1;
+  if (displayWidth == 0 || displayHeight == 0 || srcWidth <= displayWidth || srcHeight <= displayHeight) {
+    return;
+  }
+  if (mode == TRTCDownscaleMode::PowerOfTwo) {
+    uint32_t factor = 1;
+    while (srcWidth / (factor * 2) >= displayWidth && srcHeight / (factor * 2) >= displayHeight) {
+      factor *= 2;
+    }
+    if (factor > 1) {
+      *dstWidth = roundDownToEven(srcWidth / factor);
+      *dstHeight = roundDownToEven(srcHeight / factor);
+      *boxFactor = factor;
+    }
+    return;
+  }
+  const double scale = std::max(static_cast<double>(displayWidth) / srcWidth,
+                                static_cast<double>(displayHeight) / srcHeight);
+  *dstWidth = std::min(srcWidth, roundDownToEven(static_cast<uint32_t>(std::ceil(srcWidth * scale)) + 1));
+  *dstHeight = std::min(srcHeight, roundDownToEven(static_cast<uint32_t>(std::ceil(srcHeight * scale)) + 1));
+}
+
+bool scaleFrame(const TRTCFrameView& src, const TRTCFrameView& dst, uint32_t boxFactor) {
+  if (!src.isValid() || !dst.isValid() || src.format != dst.format) {
+    return false;
+  }
+  if (src.width == dst.width && src.height == dst.height) {
+    return convertFrame(src, dst);
+  }
+  switch (src.format) {
+    case TRTCVideoPixelFormat_I420:
+      scaleWith<TRTCVideoPixelFormat_I420>(src, dst, boxFactor);
+      return true;
+    case TRTCVideoPixelFormat_BGRA32:
+      scaleWith<TRTCVideoPixelFormat_BGRA32>(src, dst, boxFactor);
+      return true;
+    case TRTCVideoPixelFormat_RGBA32:
+      scaleWith<TRTCVideoPixelFormat_RGBA32>(src, dst, boxFactor);
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,58 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCFrameUpload.h"
+
+namespace liteav {
+namespace ue {
+
+UTexture2D* createFrameTexture(TRTCVideoPixelFormat format, uint32_t width, uint32_t height) {
+  switch (format) {
+    case TRTCVideoPixelFormat_BGRA32:
+      return TRTCFrameUploader<TRTCVideoPixelFormat_BGRA32>::createTexture(width, height);
+    case TRTCVideoPixelFormat_RGBA32:
+      return TRTCFrameUploader<TRTCVideoPixelFormat_RGBA32>::createTexture(width, height);
+    default:
+      return nullptr;
+  }
+}
+
+bool uploadFrame(UTexture2D* texture, const TRTCFrameView& view, TFunction<void()> onUploaded) {
+  if (!texture || !view.isValid()) {
+    return false;
+  }
+  switch (view.format) {
+    case TRTCVideoPixelFormat_BGRA32:
+      TRTCFrameUploader<TRTCVideoPixelFormat_BGRA32>::upload(texture, view, MoveTemp(onUploaded));
+      return true;
+    case TRTCVideoPixelFormat_RGBA32:
+      TRTCFrameUploader<TRTCVideoPixelFormat_RGBA32>::upload(texture, view, MoveTemp(onUploaded));
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool uploadFrameRegions(UTexture2D* texture,
+                        const TRTCFrameView& view,
+                        const std::vector<FUpdateTextureRegion2D>& regions,
+                        TFunction<void()> onUploaded) {
+  if (!texture || !view.isValid()) {
+    return false;
+  }
+  const uint32_t count = static_cast<uint32_t>(regions.size());
+  switch (view.format) {
+    case TRTCVideoPixelFormat_BGRA32:
+      TRTCFrameUploader<TRTCVideoPixelFormat_BGRA32>::uploadRegions(texture, view, regions.data(), count,
+                                                                    MoveTemp(onUploaded));
+      return true;
+    case TRTCVideoPixelFormat_RGBA32:
+      TRTCFrameUploader<TRTCVideoPixelFormat_RGBA32>::uploadRegions(texture, view, regions.data(), count,
+                                                                    MoveTemp(onUploaded));
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,212 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCFrameView.h"
+
+#include "TRTCParallelRows.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+template <TRTCVideoPixelFormat Format>
+size_t planarBufferSize(uint32_t height, const uint32_t strides[3]) {
+  using Traits = TRTCPixelFormatTraits<Format>;
+  size_t size = 0;
+  for (int plane = 0; plane < Traits::kPlaneCount; ++plane) {
+    size += static_cast<size_t>(strides[plane]) * Traits::planeHeight(plane, height);
+  }
+  return size;
+}
+
+template <TRTCVideoPixelFormat Format>
+void planarStrides(uint32_t width, uint32_t strides[3], bool aligned) {
+  using Traits = TRTCPixelFormatTraits<Format>;
+  for (int plane = 0; plane < 3; ++plane) {
+    if (plane >= Traits::kPlaneCount) {
+      strides[plane] = 0;
+      continue;
+    }
+    const uint32_t rowBytes = Traits::planeWidth(plane, width) * Traits::planeBytesPerPixel(plane);
+    strides[plane] = aligned ? alignFrameStride(rowBytes) : rowBytes;
+  }
+}
+
+template <TRTCVideoPixelFormat Format>
+void assignPlanarPlanes(TRTCFrameView& view, uint8_t* base) {
+  using Traits = TRTCPixelFormatTraits<Format>;
+  for (int plane = 0; plane < Traits::kPlaneCount; ++plane) {
+    view.planes[plane] = base;
+    base += static_cast<size_t>(view.strides[plane]) * Traits::planeHeight(plane, view.height);
+  }
+}
+
+bool computeStrides(TRTCVideoPixelFormat format, uint32_t width, uint32_t strides[3], bool aligned) {
+  switch (format) {
+    case TRTCVideoPixelFormat_I420:
+      planarStrides<TRTCVideoPixelFormat_I420>(width, strides, aligned);
+      return true;
+    case TRTCVideoPixelFormat_BGRA32:
+      planarStrides<TRTCVideoPixelFormat_BGRA32>(width, strides, aligned);
+      return true;
+    case TRTCVideoPixelFormat_RGBA32:
+      planarStrides<TRTCVideoPixelFormat_RGBA32>(width, strides, aligned);
+      return true;
+    default:
+      strides[0] = strides[1] = strides[2] = 0;
+      return false;
+  }
+}
+
+template <TRTCVideoPixelFormat Src, TRTCVideoPixelFormat Dst>
+void convertInBands(const TRTCFrameView& src, const TRTCFrameView& dst) {
+  uint32_t strides[3];
+  TRTCFrameView::alignedStrides(Dst, dst.width, strides);
+  TRTCParallelRows::forEachBand(dst.height, TRTCFrameView::bufferSize(Dst, dst.height, strides),
+                                [&src, &dst](uint32_t rowBegin, uint32_t rowEnd) {
+                                  TRTCFrameConverter<Src, Dst>::convertRows(src, dst, rowBegin, rowEnd);
+                                });
+}
+
+template <TRTCVideoPixelFormat Src>
+bool convertFrom(const TRTCFrameView& src, const TRTCFrameView& dst) {
+  switch (dst.format) {
+    case TRTCVideoPixelFormat_BGRA32:
+      convertInBands<Src, TRTCVideoPixelFormat_BGRA32>(src, dst);
+      return true;
+    case TRTCVideoPixelFormat_RGBA32:
+      convertInBands<Src, TRTCVideoPixelFormat_RGBA32>(src, dst);
+      return true;
+    case TRTCVideoPixelFormat_I420:
+      convertInBands<Src, TRTCVideoPixelFormat_I420>(src, dst);
+      return true;
+    default:
+      return false;
+  }
+}
+
+template <TRTCVideoPixelFormat Format, typename Traits = TRTCPixelFormatTraits<Format>>
+void fillPackedPlaceholder(const TRTCFrameView& dst) {
+  uint8_t pixel[4];
+  pixel[Traits::kRed] = pixel[Traits::kGreen] = pixel[Traits::kBlue] = 0x32;
+  pixel[Traits::kAlpha] = 0xFF;
+  for (uint32_t row = 0; row < dst.height; ++row) {
+    uint8_t* dstRow = dst.planes[0] + static_cast<size_t>(row) * dst.strides[0];
+    for (uint32_t x = 0; x < dst.width; ++x) {
+      std::memcpy(dstRow + x * 4, pixel, 4);
+    }
+  }
+}
+
+}  // namespace
+
+bool TRTCFrameView::isValid() const {
+  if (width == 0 || height == 0 || planes[0] == nullptr) {
+    return false;
+  }
+  switch (format) {
+    case TRTCVideoPixelFormat_I420:
+      return planes[1] != nullptr && planes[2] != nullptr;
+    case TRTCVideoPixelFormat_BGRA32:
+    case TRTCVideoPixelFormat_RGBA32:
+      return true;
+    default:
+      return false;
+  }
+}
+
+TRTCFrameView TRTCFrameView::fromVideoFrame(const TRTCVideoFrame& frame) {
+  TRTCFrameView view;
+  if (frame.bufferType != TRTCVideoBufferType_Buffer || frame.data == nullptr) {
+    return view;
+  }
+  uint32_t strides[3];
+  if (!computeStrides(frame.videoFormat, frame.width, strides, false)) {
+    return view;
+  }
+  if (bufferSize(frame.videoFormat, frame.height, strides) > frame.length) {
+    return view;
+  }
+  view.format = frame.videoFormat;
+  view.width = frame.width;
+  view.height = frame.height;
+  view.timestamp = frame.timestamp;
+  std::copy(strides, strides + 3, view.strides);
+  view.assignPlanes(reinterpret_cast<uint8_t*>(frame.data));
+  return view;
+}
+
+size_t TRTCFrameView::bufferSize(TRTCVideoPixelFormat format, uint32_t height, const uint32_t strides[3]) {
+  switch (format) {
+    case TRTCVideoPixelFormat_I420:
+      return planarBufferSize<TRTCVideoPixelFormat_I420>(height, strides);
+    case TRTCVideoPixelFormat_BGRA32:
+    case TRTCVideoPixelFormat_RGBA32:
+      return static_cast<size_t>(strides[0]) * height;
+    default:
+      return 0;
+  }
+}
+
+void TRTCFrameView::alignedStrides(TRTCVideoPixelFormat format, uint32_t width, uint32_t strides[3]) {
+  computeStrides(format, width, strides, true);
+}
+
+void TRTCFrameView::assignPlanes(uint8_t* base) {
+  switch (format) {
+    case TRTCVideoPixelFormat_I420:
+      assignPlanarPlanes<TRTCVideoPixelFormat_I420>(*this, base);
+      break;
+    case TRTCVideoPixelFormat_BGRA32:
+    case TRTCVideoPixelFormat_RGBA32:
+      planes[0] = base;
+      break;
+    default:
+      break;
+  }
+}
+
+bool convertFrame(const TRTCFrameView& src, const TRTCFrameView& dst) {
+  if (!src.isValid() || !dst.isValid() || src.width != dst.width || src.height != dst.height) {
+    return false;
+  }
+  switch (src.format) {
+    case TRTCVideoPixelFormat_I420:
+      return convertFrom<TRTCVideoPixelFormat_I420>(src, dst);
+    case TRTCVideoPixelFormat_BGRA32:
+      return convertFrom<TRTCVideoPixelFormat_BGRA32>(src, dst);
+    case TRTCVideoPixelFormat_RGBA32:
+      return convertFrom<TRTCVideoPixelFormat_RGBA32>(src, dst);
+    default:
+      return false;
+  }
+}
+
+void fillFramePlaceholder(const TRTCFrameView& dst) {
+  switch (dst.format) {
+    case TRTCVideoPixelFormat_BGRA32:
+      fillPackedPlaceholder<TRTCVideoPixelFormat_BGRA32>(dst);
+      break;
+    case TRTCVideoPixelFormat_RGBA32:
+      fillPackedPlaceholder<TRTCVideoPixelFormat_RGBA32>(dst);
+      break;
+    case TRTCVideoPixelFormat_I420: {
+      using Traits = TRTCPixelFormatTraits<TRTCVideoPixelFormat_I420>;
+      // Y = 0x32 with neutral chroma gives the same grey as the packed placeholder on limited-range decoders.
+      const uint8_t values[3] = {0x32, 0x80, 0x80};
+      for (int plane = 0; plane < Traits::kPlaneCount; ++plane) {
+        const uint32_t rows = Traits::planeHeight(plane, dst.height);
+        const uint32_t rowBytes = Traits::planeWidth(plane, dst.width);
+        for (uint32_t row = 0; row < rows; ++row) {
+          std::memset(dst.planes[plane] + static_cast<size_t>(row) * dst.strides[plane], values[plane], rowBytes);
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,294 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCGalleryWidget.h"
+
+#include "Blueprint/WidgetTree.h"
+#include "Components/CanvasPanel.h"
+#include "Components/CanvasPanelSlot.h"
+#include "Components/Image.h"
+#include "Engine/Texture2D.h"
+#include "TRTCFrameUpload.h"
+
+using liteav::TRTCVideoStreamType;
+using liteav::TRTCVideoStreamTypeBig;
+using liteav::TRTCVideoStreamTypeSmall;
+using liteav::ue::TRTCStreamKey;
+
+namespace {
+
+const FLinearColor kTileBackground(0.02f, 0.02f, 0.02f, 1.f);
+
+}  // namespace
+
+void UTRTCGalleryWidget::SetSources(liteav::ue::TRTCCloud* InCloud,
+                                    liteav::ue::TRTCVideoFrameHub* InHub,
+                                    liteav::ue::TRTCRoster* InRoster) {
+  for (FTRTCGalleryTile& Tile : Tiles) {
+    ReleaseTile(Tile);
+  }
+  HandleToTile.Reset();
+  ExpireSubscriptions(0, true);
+  Participants.clear();
+  ParticipantsRevision = MAX_uint64;
+  Cloud = InCloud;
+  Hub = InHub;
+  Roster = InRoster;
+}
+
+void UTRTCGalleryWidget::SetScrollOffset(float Offset) {
+  ScrollOffset = FMath::Max(0.f, Offset);
+}
+
+TSharedRef<SWidget> UTRTCGalleryWidget::RebuildWidget() {
+  // Without a designer tree the gallery builds its own canvas; a Blueprint subclass may provide one as the root.
+  if (WidgetTree) {
+    if (!WidgetTree->RootWidget) {
+      WidgetTree->RootWidget = WidgetTree->ConstructWidget<UCanvasPanel>(UCanvasPanel::StaticClass(), TEXT("Gallery"));
+    }
+    Canvas = Cast<UCanvasPanel>(WidgetTree->RootWidget);
+    if (Canvas) {
+      Canvas->SetClipping(EWidgetClipping::ClipToBounds);
+    }
+  }
+  return Super::RebuildWidget();
+}
+
+void UTRTCGalleryWidget::NativeTick(const FGeometry& MyGeometry, float InDeltaTime) {
+  Super::NativeTick(MyGeometry, InDeltaTime);
+  if (!Canvas || !Roster) {
+    return;
+  }
+  // Walking the whole roster is only needed when users come or go; otherwise the tick touches the visible range only.
+  if (Roster->membershipRevision() != ParticipantsRevision) {
+    ParticipantsRevision = Roster->membershipRevision();
+    Participants.clear();
+    Roster->forEachUser([this](liteav::ue::TRTCUserHandle Handle) { Participants.push_back(Handle); });
+  }
+  LayoutTiles(MyGeometry);
+}
+
+FReply UTRTCGalleryWidget::NativeOnMouseWheel(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent) {
+  SetScrollOffset(ScrollOffset - InMouseEvent.GetWheelDelta() * (TileSize.Y + TileSpacing) * 0.5f);
+  return FReply::Handled();
+}
+
+void UTRTCGalleryWidget::NativeDestruct() {
+  SetSources(nullptr, nullptr, nullptr);
+  FreeTextures.Reset();
+  Super::NativeDestruct();
+}
+
+void UTRTCGalleryWidget::LayoutTiles(const FGeometry& Geometry) {
+  const FVector2D ViewSize = Geometry.GetLocalSize();
+  const float PitchX = TileSize.X + TileSpacing;
+  const float PitchY = TileSize.Y + TileSpacing;
+  if (TileSize.X <= 0.f || TileSize.Y <= 0.f || ViewSize.Y <= 0.f) {
+    return;
+  }
+  const int32 Count = static_cast<int32>(Participants.size());
+  const int32 Columns = FMath::Max(1, FMath::FloorToInt((ViewSize.X + TileSpacing) / PitchX));
+  const int32 Rows = (Count + Columns - 1) / Columns;
+  ContentHeight = FMath::Max(0.f, Rows * PitchY - TileSpacing);
+  ScrollOffset = FMath::Clamp(ScrollOffset, 0.f, FMath::Max(0.f, ContentHeight - ViewSize.Y));
+
+  const int32 FirstVisibleRow = FMath::FloorToInt(ScrollOffset / PitchY);
+  const int32 LastVisibleRow = FMath::FloorToInt((ScrollOffset + ViewSize.Y) / PitchY);
+  const int32 FirstRow = FMath::Max(0, FirstVisibleRow - OverscanRows);
+  const int32 LastRow = FMath::Min(Rows - 1, LastVisibleRow + OverscanRows);
+  const int32 First = FirstRow * Columns;
+  const int32 End = FMath::Min(Count, (LastRow + 1) * Columns);
+
+  // Keep tiles whose participant is still in range (possibly at another index), then bind the rest.
+  TArray<int32, TInlineAllocator<64>> Unbound;
+  TBitArray<> Kept(false, Tiles.Num());
+  for (int32 Index = First; Index < End; ++Index) {
+    if (const int32* TileIndex = HandleToTile.Find(Participants[Index])) {
+      Tiles[*TileIndex].Index = Index;
+      Kept[*TileIndex] = true;
+    } else {
+      Unbound.Add(Index);
+    }
+  }
+  for (int32 TileIndex = 0; TileIndex < Tiles.Num(); ++TileIndex) {
+    if (!Kept[TileIndex] && Tiles[TileIndex].Handle != liteav::ue::kTRTCInvalidUserHandle) {
+      HandleToTile.Remove(Tiles[TileIndex].Handle);
+      ReleaseTile(Tiles[TileIndex]);
+    }
+  }
+  for (int32 Index : Unbound) {
+    const int32 TileIndex = AcquireTile();
+    FTRTCGalleryTile& Tile = Tiles[TileIndex];
+    Tile.Handle = Participants[Index];
+    Tile.Index = Index;
+    Tile.UserId = Roster->userId(Tile.Handle);
+    Tile.Sequence = ~0ull;
+    Tile.Image->SetColorAndOpacity(kTileBackground);
+    Tile.Image->SetVisibility(ESlateVisibility::HitTestInvisible);
+    HandleToTile.Add(Tile.Handle, TileIndex);
+  }
+
+  const double Now = FPlatformTime::Seconds();
+  const float Scale = Geometry.Scale;
+  const uint32 PixelWidth = static_cast<uint32>(TileSize.X * Scale);
+  const uint32 PixelHeight = static_cast<uint32>(TileSize.Y * Scale);
+  const TRTCVideoStreamType VisibleType =
+      TileSize.Y * Scale >= BigStreamMinHeight ? TRTCVideoStreamTypeBig : TRTCVideoStreamTypeSmall;
+  for (FTRTCGalleryTile& Tile : Tiles) {
+    if (Tile.Handle == liteav::ue::kTRTCInvalidUserHandle) {
+      continue;
+    }
+    const int32 Row = Tile.Index / Columns;
+    const int32 Column = Tile.Index % Columns;
+    if (UCanvasPanelSlot* TileSlot = Cast<UCanvasPanelSlot>(Tile.Image->Slot)) {
+      TileSlot->SetPosition(FVector2D(Column * PitchX, Row * PitchY - ScrollOffset));
+      TileSlot->SetSize(TileSize);
+    }
+    const bool Visible = Row >= FirstVisibleRow && Row <= LastVisibleRow;
+    const TRTCVideoStreamType Type = Visible ? VisibleType : TRTCVideoStreamTypeSmall;
+    if (Roster->flags(Tile.Handle) & liteav::ue::TRTCUserFlag_VideoAvailable) {
+      WantStream(Tile.UserId, Type, Now);
+    }
+    RefreshTile(Tile, Type, PixelWidth, PixelHeight);
+  }
+  ExpireSubscriptions(Now, false);
+}
+
+int32 UTRTCGalleryWidget::AcquireTile() {
+  for (int32 TileIndex = 0; TileIndex < Tiles.Num(); ++TileIndex) {
+    if (Tiles[TileIndex].Handle == liteav::ue::kTRTCInvalidUserHandle) {
+      return TileIndex;
+    }
+  }
+  FTRTCGalleryTile& Tile = Tiles.AddDefaulted_GetRef();
+  Tile.Image = WidgetTree->ConstructWidget<UImage>(UImage::StaticClass());
+  Canvas->AddChildToCanvas(Tile.Image);
+  return Tiles.Num() - 1;
+}
+
+void UTRTCGalleryWidget::ReleaseTile(FTRTCGalleryTile& Tile) {
+  if (Tile.Handle == liteav::ue::kTRTCInvalidUserHandle) {
+    return;
+  }
+  if (Hub && Tile.HasDisplaySize) {
+    Hub->removeConsumer(TRTCStreamKey(Tile.UserId.c_str(), Tile.DisplaySizeType), Tile.Image);
+  }
+  Tile.HasDisplaySize = false;
+  ReleaseTexture(Tile.Texture);
+  Tile.Texture = nullptr;
+  Tile.Handle = liteav::ue::kTRTCInvalidUserHandle;
+  Tile.Index = INDEX_NONE;
+  Tile.UserId.clear();
+  if (Tile.Image) {
+    Tile.Image->SetBrush(FSlateBrush());
+    Tile.Image->SetVisibility(ESlateVisibility::Collapsed);
+  }
+}
+
+void UTRTCGalleryWidget::RefreshTile(FTRTCGalleryTile& Tile,
+                                     TRTCVideoStreamType Type,
+                                     uint32 PixelWidth,
+                                     uint32 PixelHeight) {
+  if (!Hub) {
+    return;
+  }
+  // Each tile is its own consumer, keyed by its image, which lives as long as the tile. A tile moving between the big
+  // and the small stream withdraws its size from the one it left.
+  if (Tile.HasDisplaySize && Tile.DisplaySizeType != Type) {
+    Hub->removeConsumer(TRTCStreamKey(Tile.UserId.c_str(), Tile.DisplaySizeType), Tile.Image);
+  }
+  Tile.HasDisplaySize = true;
+  Tile.DisplaySizeType = Type;
+  // Depending on the SDK, small-stream frames may be delivered under either stream type.
+  TRTCStreamKey Key(Tile.UserId.c_str(), Type);
+  Hub->setDisplaySize(Key, Tile.Image, PixelWidth, PixelHeight);
+  uint64 Sequence = 0;
+  std::shared_ptr<const liteav::ue::TRTCFrameBuffer> Frame = Hub->latestFrame(Key, &Sequence);
+  if (!Frame && Type == TRTCVideoStreamTypeSmall) {
+    Key.streamType = TRTCVideoStreamTypeBig;
+    Frame = Hub->latestFrame(Key, &Sequence);
+  }
+  if (Sequence == Tile.Sequence) {
+    return;
+  }
+  Tile.Sequence = Sequence;
+  if (!Frame) {
+    // Until the (re-)subscribed stream delivers, show the last frame seen before it was unsubscribed.
+    Frame = Hub->cachedFrame(TRTCStreamKey(Tile.UserId.c_str(), Type));
+    if (!Frame && Type == TRTCVideoStreamTypeSmall) {
+      Frame = Hub->cachedFrame(TRTCStreamKey(Tile.UserId.c_str(), TRTCVideoStreamTypeBig));
+    }
+  }
+  if (!Frame) {
+    ReleaseTexture(Tile.Texture);
+    Tile.Texture = nullptr;
+    Tile.Image->SetBrush(FSlateBrush());
+    Tile.Image->SetColorAndOpacity(kTileBackground);
+    return;
+  }
+  if (!Tile.Texture || static_cast<uint32>(Tile.Texture->GetSizeX()) != Frame->width() ||
+      static_cast<uint32>(Tile.Texture->GetSizeY()) != Frame->height()) {
+    ReleaseTexture(Tile.Texture);
+    Tile.Texture = AcquireTexture(Frame->width(), Frame->height());
+    Tile.Image->SetBrushFromTexture(Tile.Texture);
+    Tile.Image->SetColorAndOpacity(FLinearColor::White);
+  }
+  // The frame buffer stays referenced until the render thread has consumed it.
+  liteav::ue::uploadFrame(Tile.Texture, Frame->view(), [Frame]() {});
+}
+
+UTexture2D* UTRTCGalleryWidget::AcquireTexture(uint32 Width, uint32 Height) {
+  for (int32 Index = FreeTextures.Num() - 1; Index >= 0; --Index) {
+    UTexture2D* Texture = FreeTextures[Index];
+    if (static_cast<uint32>(Texture->GetSizeX()) == Width && static_cast<uint32>(Texture->GetSizeY()) == Height) {
+      FreeTextures.RemoveAtSwap(Index);
+      return Texture;
+    }
+  }
+  return liteav::ue::createFrameTexture(liteav::ue::kTRTCNativePixelFormat, Width, Height);
+}
+
+void UTRTCGalleryWidget::ReleaseTexture(UTexture2D* Texture) {
+  if (!Texture) {
+    return;
+  }
+  // Keep at most one spare texture per tile; older spares are left to the garbage collector.
+  if (FreeTextures.Num() >= FMath::Max(1, Tiles.Num())) {
+    FreeTextures.RemoveAt(0);
+  }
+  FreeTextures.Add(Texture);
+}
+
+void UTRTCGalleryWidget::WantStream(const std::string& UserId, TRTCVideoStreamType Type, double Now) {
+  auto It = Subscriptions.find(UserId);
+  if (It == Subscriptions.end()) {
+    FSubscription& Subscription = Subscriptions[UserId];
+    Subscription.Type = Type;
+    Subscription.LastWanted = Now;
+    if (Cloud && Hub) {
+      Hub->acquireRemoteView(UserId.c_str(), this, Type);
+    }
+    return;
+  }
+  FSubscription& Subscription = It->second;
+  Subscription.LastWanted = Now;
+  if (Subscription.Type != Type) {
+    Subscription.Type = Type;
+    if (Cloud && Hub) {
+      Hub->acquireRemoteView(UserId.c_str(), this, Type);
+    }
+  }
+}
+
+void UTRTCGalleryWidget::ExpireSubscriptions(double Now, bool All) {
+  for (auto It = Subscriptions.begin(); It != Subscriptions.end();) {
+    const bool Present = Roster && Roster->find(It->first.c_str()) != liteav::ue::kTRTCInvalidUserHandle;
+    if (!All && Present && Now - It->second.LastWanted < UnsubscribeDelay) {
+      ++It;
+      continue;
+    }
+    if (Cloud && Hub) {
+      Hub->releaseRemoteView(It->first.c_str(), this);
+    }
+    It = Subscriptions.erase(It);
+  }
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCLastFrameCache.h"
+
+#include "Misc/ScopeLock.h"
+#include "TRTCFrameScaler.h"
+
+namespace liteav {
+namespace ue {
+
+TRTCLastFrameCache::TRTCLastFrameCache(const TRTCLastFrameCacheConfig& config) : config_(config) {}
+
+void TRTCLastFrameCache::setConfig(const TRTCLastFrameCacheConfig& config) {
+  FScopeLock lock(&mutex_);
+  config_ = config;
+  evict();
+}
+
+void TRTCLastFrameCache::store(const TRTCStreamKey& key, const TRTCFrameView& frame) {
+  if (!frame.isValid()) {
+    return;
+  }
+  uint32_t maxWidth;
+  uint32_t maxHeight;
+  {
+    FScopeLock lock(&mutex_);
+    maxWidth = config_.maxWidth;
+    maxHeight = config_.maxHeight;
+  }
+  // Downscale outside the lock; the frames handed in are usually already display-sized.
+  uint32_t width;
+  uint32_t height;
+  uint32_t boxFactor;
+  computeDownscaleSize(TRTCDownscaleMode::PowerOfTwo, frame.width, frame.height, maxWidth, maxHeight, &width, &height,
+                       &boxFactor);
+  std::shared_ptr<TRTCFrameBuffer> copy = std::make_shared<TRTCFrameBuffer>(frame.format, width, height);
+  const bool converted = (width == frame.width && height == frame.height) ? convertFrame(frame, copy->view())
+                                                                          : scaleFrame(frame, copy->view(), boxFactor);
+  if (!converted) {
+    return;
+  }
+  copy->setTimestamp(frame.timestamp);
+
+  // Evicted frames may still be referenced by an upload; they are freed when the last reference drops.
+  FScopeLock lock(&mutex_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    bytes_ -= it->second->frame->size();
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+  bytes_ += copy->size();
+  entries_.push_front(Entry{key, std::move(copy)});
+  index_.emplace(key, entries_.begin());
+  evict();
+}
+
+std::shared_ptr<const TRTCFrameBuffer> TRTCLastFrameCache::find(const TRTCStreamKey& key) {
+  FScopeLock lock(&mutex_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->frame;
+}
+
+void TRTCLastFrameCache::erase(const TRTCStreamKey& key) {
+  FScopeLock lock(&mutex_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return;
+  }
+  bytes_ -= it->second->frame->size();
+  entries_.erase(it->second);
+  index_.erase(it);
+}
+
+void TRTCLastFrameCache::clear() {
+  FScopeLock lock(&mutex_);
+  entries_.clear();
+  index_.clear();
+  bytes_ = 0;
+}
+
+size_t TRTCLastFrameCache::bytes() const {
+  FScopeLock lock(&mutex_);
+  return bytes_;
+}
+
+void TRTCLastFrameCache::evict() {
+  while (!entries_.empty() && (bytes_ > config_.maxBytes || entries_.size() > config_.maxFrames)) {
+    const Entry& oldest = entries_.back();
+    bytes_ -= oldest.frame->size();
+    index_.erase(oldest.key);
+    entries_.pop_back();
+  }
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,270 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCLogSink.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "HAL/FileManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Compression.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogTRTCSDK, Log, All);
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+// Uncompressed bytes collected before a gzip member is written, and the longest a line waits for the file.
+constexpr size_t kFileBatchBytes = 256 * 1024;
+constexpr double kFileFlushSeconds = 2.0;
+constexpr uint32_t kDrainIntervalMs = 100;
+
+const char* levelTag(TRTCLogLevel level) {
+  switch (level) {
+    case TRTCLogLevelVerbose:
+      return "V";
+    case TRTCLogLevelDebug:
+      return "D";
+    case TRTCLogLevelInfo:
+      return "I";
+    case TRTCLogLevelWarn:
+      return "W";
+    case TRTCLogLevelError:
+      return "E";
+    default:
+      return "F";
+  }
+}
+
+void copyTruncated(char* dst, size_t capacity, const char* src, size_t length) {
+  const size_t count = std::min(length, capacity - 1);
+  std::memcpy(dst, src, count);
+  dst[count] = '\0';
+}
+
+}  // namespace
+
+class TRTCLogSink::Worker : public FRunnable {
+ public:
+  explicit Worker(TRTCLogSink* sink) : sink_(sink), wake_(FPlatformProcess::GetSynchEventFromPool(false)) {
+    batch_.reserve(kFileBatchBytes + kMaxLineBytes * 2);
+    thread_ = FRunnableThread::Create(this, TEXT("TRTCLogSink"), 0, TPri_Lowest);
+  }
+
+  ~Worker() override {
+    if (thread_) {
+      stopping_.store(true);
+      wake_->Trigger();
+      thread_->WaitForCompletion();
+      delete thread_;
+    }
+    FPlatformProcess::ReturnSynchEventToPool(wake_);
+  }
+
+  void wake() { wake_->Trigger(); }
+
+  uint32 Run() override {
+    while (!stopping_.load()) {
+      wake_->Wait(kDrainIntervalMs);
+      drain();
+    }
+    drain();
+    writeBatch();
+    closeFile();
+    return 0;
+  }
+
+ private:
+  void drain() {
+    const TRTCLogSinkConfig& config = sink_->config_;
+    uint64_t written = 0;
+    while (sink_->ring_.tryPop([&](Line& line) {
+      emit(line.level, line.module, line.text);
+      ++written;
+    })) {
+    }
+    sink_->written_.fetch_add(written, std::memory_order_relaxed);
+
+    // Report drops once per drain rather than per line.
+    const uint64_t full = sink_->dropped_full_.load(std::memory_order_relaxed);
+    const uint64_t limited = sink_->dropped_rate_limited_.load(std::memory_order_relaxed);
+    if (full != reported_full_ || limited != reported_limited_) {
+      const std::string summary = "dropped " + std::to_string(full - reported_full_) + " lines (ring full), " +
+                                  std::to_string(limited - reported_limited_) + " lines (rate limited)";
+      reported_full_ = full;
+      reported_limited_ = limited;
+      emit(TRTCLogLevelWarn, "TRTCLogSink", summary.c_str());
+    }
+
+    if (!config.fileDirectory.IsEmpty() && !batch_.empty() &&
+        (batch_.size() >= kFileBatchBytes || FPlatformTime::Seconds() - last_write_ >= kFileFlushSeconds)) {
+      writeBatch();
+    }
+  }
+
+  void emit(TRTCLogLevel level, const char* module, const char* text) {
+    const TRTCLogSinkConfig& config = sink_->config_;
+    if (config.toUELog) {
+      switch (level) {
+        case TRTCLogLevelVerbose:
+        case TRTCLogLevelDebug:
+          UE_LOG(LogTRTCSDK, Verbose, TEXT("[%s] %s"), UTF8_TO_TCHAR(module), UTF8_TO_TCHAR(text));
+          break;
+        case TRTCLogLevelInfo:
+          UE_LOG(LogTRTCSDK, Log, TEXT("[%s] %s"), UTF8_TO_TCHAR(module), UTF8_TO_TCHAR(text));
+          break;
+        case TRTCLogLevelWarn:
+          UE_LOG(LogTRTCSDK, Warning, TEXT("[%s] %s"), UTF8_TO_TCHAR(module), UTF8_TO_TCHAR(text));
+          break;
+        default:
+          UE_LOG(LogTRTCSDK, Error, TEXT("[%s] %s"), UTF8_TO_TCHAR(module), UTF8_TO_TCHAR(text));
+          break;
+      }
+    }
+    if (!config.fileDirectory.IsEmpty()) {
+      batch_.append(levelTag(level)).append(" ").append(module).append(" ").append(text);
+      if (batch_.empty() || batch_.back() != '\n') {
+        batch_.push_back('\n');
+      }
+    }
+  }
+
+  // Compress the batch into one gzip member and append it to the current file, rotating it first if full.
+  void writeBatch() {
+    last_write_ = FPlatformTime::Seconds();
+    if (batch_.empty()) {
+      return;
+    }
+    const int32 rawSize = static_cast<int32>(batch_.size());
+    int32 compressedSize = FCompression::CompressMemoryBound(NAME_Gzip, rawSize);
+    compressed_.SetNumUninitialized(compressedSize, false);
+    if (!FCompression::CompressMemory(NAME_Gzip, compressed_.GetData(), compressedSize, batch_.data(), rawSize)) {
+      batch_.clear();
+      return;
+    }
+    batch_.clear();
+
+    const TRTCLogSinkConfig& config = sink_->config_;
+    if (file_ && file_bytes_ + compressedSize > config.maxFileBytes) {
+      closeFile();
+      rotateFiles();
+    }
+    if (!file_) {
+      file_ = IFileManager::Get().CreateFileWriter(*filePath(0), FILEWRITE_Append | FILEWRITE_AllowRead);
+      file_bytes_ = file_ ? static_cast<uint64_t>(file_->TotalSize()) : 0;
+    }
+    if (file_) {
+      file_->Serialize(compressed_.GetData(), compressedSize);
+      file_->Flush();
+      file_bytes_ += compressedSize;
+    }
+  }
+
+  void rotateFiles() {
+    const uint32_t maxFiles = std::max<uint32_t>(1, sink_->config_.maxFiles);
+    IFileManager& fileManager = IFileManager::Get();
+    fileManager.Delete(*filePath(maxFiles - 1), false, true, true);
+    for (int32 index = static_cast<int32>(maxFiles) - 2; index >= 0; --index) {
+      const FString from = filePath(index);
+      if (fileManager.FileExists(*from)) {
+        fileManager.Move(*filePath(index + 1), *from, true, true, false, true);
+      }
+    }
+  }
+
+  void closeFile() {
+    delete file_;
+    file_ = nullptr;
+    file_bytes_ = 0;
+  }
+
+  FString filePath(int32 index) const {
+    return FPaths::Combine(sink_->config_.fileDirectory, FString::Printf(TEXT("trtc_sdk.%d.log.gz"), index));
+  }
+
+  TRTCLogSink* sink_;
+  FEvent* wake_;
+  FRunnableThread* thread_ = nullptr;
+  std::atomic<bool> stopping_{false};
+  std::string batch_;
+  TArray<uint8> compressed_;
+  FArchive* file_ = nullptr;
+  uint64_t file_bytes_ = 0;
+  double last_write_ = 0;
+  uint64_t reported_full_ = 0;
+  uint64_t reported_limited_ = 0;
+};
+
+TRTCLogSink::TRTCLogSink(const TRTCLogSinkConfig& config)
+    : config_(config), ring_(std::max<uint32_t>(config.ringLines, 16)) {
+  worker_ = std::make_unique<Worker>(this);
+}
+
+TRTCLogSink::~TRTCLogSink() {
+  worker_.reset();
+}
+
+TRTCLogSinkStats TRTCLogSink::stats() const {
+  TRTCLogSinkStats stats;
+  stats.written = written_.load(std::memory_order_relaxed);
+  stats.droppedFull = dropped_full_.load(std::memory_order_relaxed);
+  stats.droppedRateLimited = dropped_rate_limited_.load(std::memory_order_relaxed);
+  stats.truncated = truncated_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void TRTCLogSink::onLog(const char* log, TRTCLogLevel level, const char* module) {
+  if (!log || level == TRTCLogLevelNone) {
+    return;
+  }
+  if (!admit(level, module)) {
+    dropped_rate_limited_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const size_t length = std::strlen(log);
+  uint64_t position = 0;
+  const bool pushed = ring_.tryPush(
+      [&](Line& line) {
+        line.level = level;
+        copyTruncated(line.module, kMaxModuleBytes, module ? module : "", module ? std::strlen(module) : 0);
+        copyTruncated(line.text, kMaxLineBytes, log, length);
+      },
+      &position);
+  if (!pushed) {
+    dropped_full_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (length >= kMaxLineBytes) {
+    truncated_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Wake the drain thread early when half of the ring has filled since the last wake-up.
+  if ((position & (ring_.capacity() / 2 - 1)) == 0) {
+    worker_->wake();
+  }
+}
+
+bool TRTCLogSink::admit(TRTCLogLevel level, const char* module) {
+  if (config_.maxLinesPerSecond == 0 || level >= TRTCLogLevelWarn) {
+    return true;
+  }
+  // Modules share a small table of per-second counters; colliding modules share a budget.
+  uint32_t hash = 2166136261u;
+  for (const char* c = module ? module : ""; *c; ++c) {
+    hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+  }
+  RateBucket& bucket = rate_buckets_[hash % kRateBuckets];
+  const uint32_t now = static_cast<uint32_t>(FPlatformTime::Seconds());
+  uint32_t second = bucket.second.load(std::memory_order_relaxed);
+  if (second != now && bucket.second.compare_exchange_strong(second, now, std::memory_order_relaxed)) {
+    bucket.count.store(0, std::memory_order_relaxed);
+  }
+  return bucket.count.fetch_add(1, std::memory_order_relaxed) < config_.maxLinesPerSecond;
+}
+
+}  // namespace ue
+}  // namespace liteav
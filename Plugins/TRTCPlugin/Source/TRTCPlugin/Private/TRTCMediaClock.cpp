@@ -0,0 +1,185 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCMediaClock.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+// A `generateCustomPTS` call bracketed by platform reads wider than this was preempted and is not used.
+constexpr double kMaxSampleSpreadSeconds = 0.002;
+// The rate is only estimated once the observation times have this standard deviation; until then it is taken as exact.
+constexpr double kMinRateSpreadSeconds = 0.5;
+
+}  // namespace
+
+// Exponentially weighted least-squares line y = f(x), with x and y in seconds. Sums are kept relative to the first
+// observation so that they stay small enough for double precision over long sessions.
+struct TRTCMediaClock::Fit {
+  bool valid = false;
+  double x0 = 0;
+  double y0 = 0;
+  double last_x = 0;
+  double w = 0;
+  double sx = 0;
+  double sy = 0;
+  double sxx = 0;
+  double sxy = 0;
+  double mean_x = 0;
+  double mean_y = 0;
+  double rate = 1;
+  double jitter = 0;
+  uint64_t observations = 0;
+  uint64_t resyncs = 0;
+
+  void restart(double x, double y) {
+    valid = true;
+    x0 = x;
+    y0 = y;
+    last_x = x;
+    w = sx = sy = sxx = sxy = 0;
+    mean_x = mean_y = 0;
+    rate = 1;
+    jitter = 0;
+  }
+
+  double map(double x) const { return valid ? y0 + mean_y + rate * (x - x0 - mean_x) : x; }
+
+  void add(double x, double y, const TRTCMediaClockConfig& config) {
+    double residual = 0;
+    if (valid) {
+      residual = y - map(x);
+      if (std::abs(residual) * 1000.0 > config.resyncMs) {
+        valid = false;
+        ++resyncs;
+      }
+    }
+    if (!valid) {
+      restart(x, y);
+      residual = 0;
+    }
+    const double decay = x > last_x ? std::exp(-(x - last_x) / std::max(config.fitSeconds, 1.0)) : 1.0;
+    const double dx = x - x0;
+    const double dy = y - y0;
+    w = w * decay + 1;
+    sx = sx * decay + dx;
+    sy = sy * decay + dy;
+    sxx = sxx * decay + dx * dx;
+    sxy = sxy * decay + dx * dy;
+    last_x = std::max(last_x, x);
+    ++observations;
+    jitter += 0.05 * (std::abs(residual) - jitter);
+
+    mean_x = sx / w;
+    mean_y = sy / w;
+    const double variance = sxx / w - mean_x * mean_x;
+    rate = 1;
+    if (variance > kMinRateSpreadSeconds * kMinRateSpreadSeconds) {
+      const double limit = config.maxDriftPpm * 1e-6;
+      rate = std::min(std::max((sxy / w - mean_x * mean_y) / variance, 1 - limit), 1 + limit);
+    }
+  }
+};
+
+class TRTCMediaClock::Worker : public FRunnable {
+ public:
+  explicit Worker(TRTCMediaClock* clock) : clock_(clock), wake_(FPlatformProcess::GetSynchEventFromPool(false)) {
+    thread_ = FRunnableThread::Create(this, TEXT("TRTCMediaClock"), 0, TPri_BelowNormal);
+  }
+
+  ~Worker() override {
+    if (thread_) {
+      stopping_.store(true);
+      wake_->Trigger();
+      thread_->WaitForCompletion();
+      delete thread_;
+    }
+    FPlatformProcess::ReturnSynchEventToPool(wake_);
+  }
+
+  uint32 Run() override {
+    while (!stopping_.load()) {
+      wake_->Wait(std::max<uint32_t>(clock_->config_.samplePeriodMs, 10));
+      if (!stopping_.load()) {
+        clock_->sampleCustomPts();
+      }
+    }
+    return 0;
+  }
+
+ private:
+  TRTCMediaClock* const clock_;
+  FEvent* wake_;
+  FRunnableThread* thread_ = nullptr;
+  std::atomic<bool> stopping_{false};
+};
+
+TRTCMediaClock::TRTCMediaClock(TRTCCloud& cloud, const TRTCMediaClockConfig& config)
+    : cloud_(cloud), config_(config), fits_(std::make_unique<Fit[]>(kTRTCClockDomainCount)) {
+  // The SDK mapping is needed from the first frame on, so it starts from one sample taken here.
+  sampleCustomPts();
+  worker_ = std::make_unique<Worker>(this);
+}
+
+TRTCMediaClock::~TRTCMediaClock() {
+  worker_.reset();
+}
+
+void TRTCMediaClock::observe(TRTCClockDomain domain, double domainSeconds, double platformSeconds) {
+  if (domain == TRTCClockDomain::Platform || domain >= TRTCClockDomain::Count) {
+    return;
+  }
+  FScopeLock lock(&mutex_);
+  fits_[static_cast<uint32_t>(domain)].add(domainSeconds, platformSeconds, config_);
+}
+
+uint64_t TRTCMediaClock::pts(TRTCClockDomain domain, double domainSeconds) const {
+  if (domain >= TRTCClockDomain::Count) {
+    return 0;
+  }
+  double ms;
+  {
+    FScopeLock lock(&mutex_);
+    const double platform =
+        domain == TRTCClockDomain::Platform ? domainSeconds : fits_[static_cast<uint32_t>(domain)].map(domainSeconds);
+    ms = fits_[static_cast<uint32_t>(TRTCClockDomain::Platform)].map(platform) * 1000.0;
+  }
+  return ms > 0 ? static_cast<uint64_t>(ms + 0.5) : 0;
+}
+
+TRTCClockDomainStats TRTCMediaClock::stats(TRTCClockDomain domain) const {
+  TRTCClockDomainStats stats;
+  if (domain >= TRTCClockDomain::Count) {
+    return stats;
+  }
+  FScopeLock lock(&mutex_);
+  const Fit& fit = fits_[static_cast<uint32_t>(domain)];
+  stats.locked = fit.valid;
+  stats.driftPpm = (fit.rate - 1) * 1e6;
+  stats.jitterMs = fit.jitter * 1000.0;
+  stats.observations = fit.observations;
+  stats.resyncs = fit.resyncs;
+  return stats;
+}
+
+void TRTCMediaClock::sampleCustomPts() {
+  const double before = FPlatformTime::Seconds();
+  const uint64_t customPts = cloud_.generateCustomPTS();
+  const double after = FPlatformTime::Seconds();
+  FScopeLock lock(&mutex_);
+  Fit& fit = fits_[static_cast<uint32_t>(TRTCClockDomain::Platform)];
+  if (after - before > kMaxSampleSpreadSeconds && fit.valid) {
+    return;
+  }
+  fit.add(0.5 * (before + after), customPts / 1000.0, config_);
+}
+
+}  // namespace ue
+}  // namespace liteav
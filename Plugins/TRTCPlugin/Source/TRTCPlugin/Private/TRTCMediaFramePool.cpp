@@ -0,0 +1,277 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCMediaFramePool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeLock.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+constexpr uint32_t kBucketCount = 64;
+// Bucket of blocks too large for the biggest bucket; they are freed on release.
+constexpr uint32_t kUnpooled = kBucketCount;
+constexpr uint32_t kThreadCacheBlocks = 4;
+constexpr size_t kMinBlockBytes = 4096;
+constexpr uint32_t kBlockAlignment = 64;
+
+// 4, 5, 6 and 7 KiB, then 8, 10, 12 and 14 KiB, and so on.
+size_t bucketBytes(uint32_t bucket) {
+  return static_cast<size_t>(4 + bucket % 4) << (bucket / 4 + 10);
+}
+
+uint32_t bucketFor(size_t bytes) {
+  if (bytes <= kMinBlockBytes) {
+    return 0;
+  }
+  uint32_t octave = 0;
+  for (size_t value = bytes - 1; value > 1; value >>= 1) {
+    ++octave;
+  }
+  // `step` is 4 to 7, the quarter of the octave below `bytes`; one more rounds up, possibly into the next octave.
+  const size_t step = (bytes - 1) >> (octave - 2);
+  const uint32_t bucket = (octave - 12) * 4 + static_cast<uint32_t>(step + 1 - 4);
+  return bucket < kBucketCount ? bucket : kUnpooled;
+}
+
+}  // namespace
+
+struct TRTCMediaFramePoolState {
+  explicit TRTCMediaFramePoolState(uint32_t maxIdle) : maxIdlePerBucket(maxIdle) {}
+
+  uint8_t* take(uint32_t bucket) {
+    FScopeLock lock(&mutex);
+    std::vector<uint8_t*>& list = idle[bucket];
+    if (list.empty()) {
+      return nullptr;
+    }
+    uint8_t* block = list.back();
+    list.pop_back();
+    idleBytes -= bucketBytes(bucket);
+    return block;
+  }
+
+  void give(uint32_t bucket, uint8_t* block) {
+    {
+      FScopeLock lock(&mutex);
+      std::vector<uint8_t*>& list = idle[bucket];
+      if (list.size() < maxIdlePerBucket) {
+        list.push_back(block);
+        idleBytes += bucketBytes(bucket);
+        return;
+      }
+    }
+    FMemory::Free(block);
+  }
+
+  void clear() {
+    std::vector<uint8_t*> released;
+    {
+      FScopeLock lock(&mutex);
+      for (std::vector<uint8_t*>& list : idle) {
+        released.insert(released.end(), list.begin(), list.end());
+        list.clear();
+      }
+      idleBytes = 0;
+    }
+    for (uint8_t* block : released) {
+      FMemory::Free(block);
+    }
+  }
+
+  const uint32_t maxIdlePerBucket;
+  FCriticalSection mutex;
+  std::vector<uint8_t*> idle[kBucketCount];
+  size_t idleBytes = 0;
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> reuses{0};
+  std::atomic<uint64_t> threadCacheHits{0};
+};
+
+namespace {
+
+// Blocks a thread released, per pool and bucket. Entries are matched on the pool's control block rather than its
+// address, so a new pool allocated where a destroyed one lived never picks up the old pool's entries.
+class ThreadCache {
+ public:
+  struct Entry {
+    std::weak_ptr<TRTCMediaFramePoolState> owner;
+    uint32_t bucket = 0;
+    uint32_t count = 0;
+    uint8_t* blocks[kThreadCacheBlocks];
+  };
+
+  ~ThreadCache() {
+    for (Entry& entry : entries_) {
+      flush(entry);
+    }
+  }
+
+  Entry* find(const std::shared_ptr<TRTCMediaFramePoolState>& owner, uint32_t bucket, bool create) {
+    Entry* vacant = nullptr;
+    for (Entry& entry : entries_) {
+      if (entry.bucket == bucket && !entry.owner.owner_before(owner) && !owner.owner_before(entry.owner)) {
+        return &entry;
+      }
+      if (!vacant && entry.owner.expired()) {
+        flush(entry);
+        vacant = &entry;
+      }
+    }
+    if (!create) {
+      return nullptr;
+    }
+    if (!vacant) {
+      entries_.emplace_back();
+      vacant = &entries_.back();
+    }
+    vacant->owner = owner;
+    vacant->bucket = bucket;
+    vacant->count = 0;
+    return vacant;
+  }
+
+ private:
+  static void flush(Entry& entry) {
+    std::shared_ptr<TRTCMediaFramePoolState> owner = entry.owner.lock();
+    for (uint32_t i = 0; i < entry.count; ++i) {
+      if (owner) {
+        owner->give(entry.bucket, entry.blocks[i]);
+      } else {
+        FMemory::Free(entry.blocks[i]);
+      }
+    }
+    entry.count = 0;
+  }
+
+  std::vector<Entry> entries_;
+};
+
+thread_local ThreadCache t_cache;
+
+}  // namespace
+
+void TRTCPooledBlock::reset() {
+  if (!data_) {
+    return;
+  }
+  std::shared_ptr<TRTCMediaFramePoolState> owner = owner_.lock();
+  if (!owner || bucket_ == kUnpooled) {
+    FMemory::Free(data_);
+  } else {
+    ThreadCache::Entry* entry = t_cache.find(owner, bucket_, true);
+    if (entry->count < kThreadCacheBlocks) {
+      entry->blocks[entry->count++] = data_;
+    } else {
+      owner->give(bucket_, data_);
+    }
+  }
+  owner_.reset();
+  data_ = nullptr;
+  capacity_ = 0;
+  bucket_ = 0;
+}
+
+TRTCMediaFramePool::TRTCMediaFramePool(uint32_t maxIdlePerBucket)
+    : state_(std::make_shared<TRTCMediaFramePoolState>(maxIdlePerBucket)) {}
+
+TRTCMediaFramePool::~TRTCMediaFramePool() {
+  state_->clear();
+}
+
+TRTCPooledBlock TRTCMediaFramePool::acquire(size_t bytes) {
+  TRTCPooledBlock block;
+  if (bytes == 0) {
+    return block;
+  }
+  const uint32_t bucket = bucketFor(bytes);
+  uint8_t* data = nullptr;
+  if (bucket != kUnpooled) {
+    ThreadCache::Entry* entry = t_cache.find(state_, bucket, false);
+    if (entry && entry->count > 0) {
+      data = entry->blocks[--entry->count];
+      state_->threadCacheHits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      data = state_->take(bucket);
+    }
+  }
+  const size_t capacity = bucket != kUnpooled ? bucketBytes(bucket) : bytes;
+  if (data) {
+    state_->reuses.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    data = static_cast<uint8_t*>(FMemory::Malloc(capacity, kBlockAlignment));
+    state_->allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  block.owner_ = state_;
+  block.data_ = data;
+  block.capacity_ = capacity;
+  block.bucket_ = bucket;
+  return block;
+}
+
+TRTCPooledVideoFrame TRTCMediaFramePool::acquireVideo(TRTCVideoPixelFormat format, uint32_t width, uint32_t height) {
+  const size_t pixels = static_cast<size_t>(width) * height;
+  size_t bytes = 0;
+  switch (format) {
+    case TRTCVideoPixelFormat_I420:
+      bytes = pixels + 2 * (static_cast<size_t>(width + 1) / 2) * ((height + 1) / 2);
+      break;
+    case TRTCVideoPixelFormat_BGRA32:
+    case TRTCVideoPixelFormat_RGBA32:
+      bytes = pixels * 4;
+      break;
+    default:
+      break;
+  }
+  TRTCPooledBlock block = acquire(bytes);
+  if (!block) {
+    return TRTCPooledVideoFrame();
+  }
+  TRTCVideoFrame frame;
+  frame.videoFormat = format;
+  frame.bufferType = TRTCVideoBufferType_Buffer;
+  frame.data = reinterpret_cast<char*>(block.data());
+  frame.length = static_cast<uint32_t>(bytes);
+  frame.width = width;
+  frame.height = height;
+  frame.timestamp = 0;
+  return TRTCPooledVideoFrame(frame, std::move(block));
+}
+
+TRTCPooledAudioFrame TRTCMediaFramePool::acquireAudio(uint32_t sampleRate, uint32_t channels, uint32_t frames) {
+  const size_t bytes = static_cast<size_t>(frames) * channels * sizeof(int16_t);
+  TRTCPooledBlock block = acquire(bytes);
+  if (!block) {
+    return TRTCPooledAudioFrame();
+  }
+  TRTCAudioFrame frame;
+  frame.audioFormat = TRTCAudioFrameFormatPCM;
+  frame.data = reinterpret_cast<char*>(block.data());
+  frame.length = static_cast<uint32_t>(bytes);
+  frame.sampleRate = sampleRate;
+  frame.channel = channels;
+  frame.timestamp = 0;
+  return TRTCPooledAudioFrame(frame, std::move(block));
+}
+
+void TRTCMediaFramePool::trim() {
+  state_->clear();
+}
+
+TRTCMediaFramePoolStats TRTCMediaFramePool::stats() const {
+  TRTCMediaFramePoolStats stats;
+  stats.allocations = state_->allocations.load(std::memory_order_relaxed);
+  stats.reuses = state_->reuses.load(std::memory_order_relaxed);
+  stats.threadCacheHits = state_->threadCacheHits.load(std::memory_order_relaxed);
+  FScopeLock lock(&state_->mutex);
+  stats.idleBytes = state_->idleBytes;
+  return stats;
+}
+
+}  // namespace ue
+}  // namespace liteav
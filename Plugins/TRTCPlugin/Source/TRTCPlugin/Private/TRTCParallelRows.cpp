@@ -0,0 +1,23 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCParallelRows.h"
+
+#include <atomic>
+
+namespace liteav {
+namespace ue {
+
+namespace {
+std::atomic<size_t> gThresholdBytes{TRTCParallelRows::kDefaultThresholdBytes};
+}  // namespace
+
+void TRTCParallelRows::setThresholdBytes(size_t bytes) {
+  gThresholdBytes.store(bytes, std::memory_order_relaxed);
+}
+
+size_t TRTCParallelRows::thresholdBytes() {
+  return gThresholdBytes.load(std::memory_order_relaxed);
+}
+
+}  // namespace ue
+}  // namespace liteav
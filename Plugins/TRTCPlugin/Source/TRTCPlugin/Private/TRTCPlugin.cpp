@@ -4,6 +4,8 @@
 
 #define LOCTEXT_NAMESPACE "FTRTCPluginModule"
 
+DEFINE_LOG_CATEGORY(LogTRTCPlugin);
+
 void FTRTCPluginModule::StartupModule() {
   // This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file
   // per-module FString BaseDir = IPluginManager::Get().FindPlugin("TRTCPlugin")->GetBaseDir();
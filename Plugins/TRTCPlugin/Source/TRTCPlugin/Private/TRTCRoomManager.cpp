@@ -0,0 +1,516 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCRoomManager.h"
+
+#include <atomic>
+#include <set>
+
+#include "Async/Async.h"
+#include "TRTCPlugin.h"
+
+namespace liteav {
+namespace ue {
+
+// Owned copy of the `TRTCParams` fields needed to enter or switch to a room.
+struct TRTCRoomManager::Room {
+  uint32_t sdkAppId = 0;
+  uint32_t roomId = 0;
+  std::string userId;
+  std::string userSig;
+  std::string strRoomId;
+  std::string privateMapKey;
+  std::string key;
+
+  explicit Room(const TRTCParams& params)
+      : sdkAppId(params.sdkAppId),
+        roomId(params.roomId),
+        userId(params.userId ? params.userId : ""),
+        userSig(params.userSig ? params.userSig : ""),
+        strRoomId(params.strRoomId ? params.strRoomId : ""),
+        privateMapKey(params.privateMapKey ? params.privateMapKey : ""),
+        key(strRoomId.empty() ? std::to_string(roomId) : strRoomId) {}
+
+  TRTCParams params() const {
+    TRTCParams params;
+    params.sdkAppId = sdkAppId;
+    params.roomId = roomId;
+    params.userId = userId.c_str();
+    params.userSig = userSig.c_str();
+    params.strRoomId = strRoomId.c_str();
+    params.privateMapKey = privateMapKey.empty() ? nullptr : privateMapKey.c_str();
+    params.role = TRTCRoleAudience;
+    return params;
+  }
+
+  TRTCSwitchRoomConfig switchConfig() const {
+    TRTCSwitchRoomConfig config;
+    config.roomId = roomId;
+    config.strRoomId = strRoomId.c_str();
+    config.userSig = userSig.c_str();
+    config.privateMapKey = privateMapKey.empty() ? nullptr : privateMapKey.c_str();
+    return config;
+  }
+};
+
+struct TRTCRoomManager::Slot {
+  TRTCCloud* cloud = nullptr;
+  std::unique_ptr<TRTCVideoFrameHub> hub;
+  std::unique_ptr<SlotCallback> callback;
+  // Room the cloud is in or entering; null when idle.
+  std::shared_ptr<Room> room;
+  bool entered = false;
+  // Bumped whenever the slot leaves a room, so that late events of that room are dropped. Shared with the slot's
+  // callback, which reads it on SDK threads that may outlive the manager.
+  std::shared_ptr<std::atomic<uint32_t>> generation = std::make_shared<std::atomic<uint32_t>>(0);
+  std::set<std::string> users;
+  std::set<std::string> videoUsers;
+  // Room the slot is moving away from with `switchRoom`, and its users. The SDK stays there if the switch fails.
+  std::shared_ptr<Room> switchedFrom;
+  std::set<std::string> switchedUsers;
+  std::set<std::string> switchedVideoUsers;
+};
+
+//
+// Forwards the events of one sub-cloud to the game thread, tagged with the slot generation they belong to.
+//
+class TRTCRoomManager::SlotCallback : public ITRTCCloudCallback {
+ public:
+  SlotCallback(TRTCRoomManager* manager, int index)
+      : manager_(manager), index_(index), generation_(manager->slots_[index]->generation), alive_(manager->alive_) {}
+
+  void onError(TXLiteAVError errCode, const char* errMsg, void* /*extraInfo*/) override {
+    post(SlotEvent::Error, errMsg, errCode);
+  }
+  void onWarning(TXLiteAVWarning /*warningCode*/, const char* /*warningMsg*/, void* /*extraInfo*/) override {}
+  void onEnterRoom(int result) override { post(SlotEvent::EnterRoom, nullptr, result); }
+  void onExitRoom(int /*reason*/) override {}
+  void onSwitchRoom(TXLiteAVError errCode, const char* /*errMsg*/) override {
+    post(SlotEvent::EnterRoom, nullptr, errCode == 0 ? 1 : errCode);
+  }
+  void onRemoteUserEnterRoom(const char* userId) override { post(SlotEvent::UserEnter, userId, 0); }
+  void onRemoteUserLeaveRoom(const char* userId, int reason) override { post(SlotEvent::UserLeave, userId, reason); }
+  void onUserVideoAvailable(const char* userId, bool available) override {
+    post(SlotEvent::VideoAvailable, userId, available ? 1 : 0);
+  }
+  void onFirstVideoFrame(const char* userId, const TRTCVideoStreamType /*streamType*/, const int /*width*/,
+                         const int /*height*/) override {
+    post(SlotEvent::FirstVideo, userId, 0);
+  }
+  void onFirstAudioFrame(const char* userId) override { post(SlotEvent::FirstAudio, userId, 0); }
+
+ private:
+  // Runs on SDK threads; `manager_` is only dereferenced on the game thread once `alive` confirms it still exists.
+  void post(SlotEvent event, const char* text, int value) {
+    const uint32_t generation = generation_->load(std::memory_order_acquire);
+    TRTCRoomManager* manager = manager_;
+    const int index = index_;
+    std::weak_ptr<bool> alive = alive_;
+    std::string copy = text ? text : "";
+    AsyncTask(ENamedThreads::GameThread, [=]() {
+      if (alive.lock()) {
+        manager->handleEvent(index, generation, event, copy, value);
+      }
+    });
+  }
+
+  TRTCRoomManager* manager_;
+  int index_;
+  std::shared_ptr<const std::atomic<uint32_t>> generation_;
+  std::weak_ptr<bool> alive_;
+};
+
+TRTCRoomManager::TRTCRoomManager(TRTCCloud* mainCloud, TRTCAppScene scene)
+    : main_cloud_(mainCloud), scene_(scene), alive_(std::make_shared<bool>(true)) {
+  for (int i = 0; i < 2; ++i) {
+    slots_[i] = std::make_unique<Slot>();
+    Slot& slot = *slots_[i];
+    slot.cloud = main_cloud_->createSubCloud();
+    if (!slot.cloud) {
+      UE_LOG(LogTRTCPlugin, Error, TEXT("TRTCRoomManager: createSubCloud failed"));
+      continue;
+    }
+    // Audio is received as soon as a room is entered; video only once the manager subscribes it.
+    slot.cloud->setDefaultStreamRecvMode(true, false);
+    slot.hub = std::make_unique<TRTCVideoFrameHub>(slot.cloud);
+    slot.callback = std::make_unique<SlotCallback>(this, i);
+    slot.cloud->addCallback(slot.callback.get());
+  }
+}
+
+TRTCRoomManager::~TRTCRoomManager() {
+  alive_.reset();
+  for (std::unique_ptr<Slot>& slot : slots_) {
+    if (!slot->cloud) {
+      continue;
+    }
+    slot->cloud->removeCallback(slot->callback.get());
+    if (slot->room) {
+      slot->cloud->exitRoom();
+    }
+    slot->hub.reset();
+    main_cloud_->destroySubCloud(slot->cloud);
+  }
+}
+
+void TRTCRoomManager::setCallback(TRTCRoomManagerCallback* callback) {
+  callback_ = callback;
+}
+
+void TRTCRoomManager::setRoomRing(const std::vector<TRTCParams>& rooms) {
+  ring_.clear();
+  for (const TRTCParams& params : rooms) {
+    ring_.push_back(std::make_shared<Room>(params));
+  }
+  predictNext();
+}
+
+void TRTCRoomManager::prepareRoom(const TRTCParams& params) {
+  std::shared_ptr<Room> room = std::make_shared<Room>(params);
+  if ((active().room && active().room->key == room->key) || (standby().room && standby().room->key == room->key)) {
+    return;
+  }
+  enterSlot(standby(), room, false);
+}
+
+void TRTCRoomManager::switchRoom(const TRTCParams& params) {
+  std::shared_ptr<Room> room = std::make_shared<Room>(params);
+  Slot& from = active();
+  if (from.room && from.room->key == room->key) {
+    return;
+  }
+  finishSwitch();
+
+  // Remember the direction of travel through the ring so that the prediction follows the user.
+  if (from.room && ring_.size() > 2) {
+    const int current = ringIndexOf(from.room->key);
+    const int next = ringIndexOf(room->key);
+    if (current >= 0 && next >= 0) {
+      const int count = static_cast<int>(ring_.size());
+      const int step = (next - current + count) % count;
+      ring_direction_ = step == count - 1 ? -1 : (step == 1 ? 1 : ring_direction_);
+    }
+  }
+
+  switch_started_ = FPlatformTime::Seconds();
+  switch_pending_ = true;
+  previous_room_ = from.room;
+  stats_ = TRTCRoomSwitchStats();
+  stats_.roomKey = room->key;
+
+  withdraw(from);
+  Slot& spare = standby();
+  if (spare.room && spare.room->key == room->key && spare.cloud) {
+    stats_.warm = true;
+    if (spare.entered) {
+      stats_.enterRoomMs = 0;
+    }
+    leaveSlot(from);
+    active_index_ = 1 - active_index_;
+    present(spare);
+  } else {
+    enterSlot(from, room, true);
+  }
+  predictNext();
+}
+
+void TRTCRoomManager::exitRoom() {
+  finishSwitch();
+  withdraw(active());
+  leaveSlot(active());
+  leaveSlot(standby());
+  held_frames_.clear();
+}
+
+TRTCCloud* TRTCRoomManager::activeCloud() const {
+  return active().cloud;
+}
+
+TRTCVideoFrameHub* TRTCRoomManager::activeHub() const {
+  return active().hub.get();
+}
+
+std::shared_ptr<const TRTCFrameBuffer> TRTCRoomManager::latestFrame(const void* consumer,
+                                                                    const TRTCStreamKey& key,
+                                                                    uint64_t* sequence) {
+  std::shared_ptr<const TRTCFrameBuffer> frame = active().hub ? active().hub->latestFrame(key) : nullptr;
+  HeldFrame& held = held_frames_[consumer];
+  if (frame) {
+    if (frame != held.frame) {
+      held.frame = std::move(frame);
+      ++held.sequence;
+    }
+  } else if (held.frame && FPlatformTime::Seconds() - switch_started_ > kHoldFrameSeconds) {
+    held.frame.reset();
+    ++held.sequence;
+  }
+  if (sequence) {
+    *sequence = held.sequence;
+  }
+  return held.frame;
+}
+
+void TRTCRoomManager::setDisplaySize(const TRTCStreamKey& key,
+                                     const void* consumer,
+                                     uint32_t width,
+                                     uint32_t height) {
+  if (active().hub) {
+    active().hub->setDisplaySize(key, consumer, width, height);
+  }
+}
+
+void TRTCRoomManager::removeConsumer(const void* consumer) {
+  held_frames_.erase(consumer);
+}
+
+TRTCRoomManager::Slot& TRTCRoomManager::active() const {
+  return *slots_[active_index_];
+}
+
+TRTCRoomManager::Slot& TRTCRoomManager::standby() const {
+  return *slots_[1 - active_index_];
+}
+
+void TRTCRoomManager::enterSlot(Slot& slot, const std::shared_ptr<Room>& room, bool presented) {
+  if (!slot.cloud) {
+    return;
+  }
+  slot.generation->fetch_add(1, std::memory_order_acq_rel);
+  if (slot.room && slot.entered) {
+    slot.switchedFrom = slot.room;
+    slot.switchedUsers = slot.users;
+    slot.switchedVideoUsers = slot.videoUsers;
+  } else {
+    slot.switchedFrom.reset();
+  }
+  resetSlotStreams(slot);
+  slot.users.clear();
+  slot.entered = false;
+  slot.cloud->muteAllRemoteAudio(!presented);
+  slot.cloud->muteAllRemoteVideoStreams(!presented);
+  // An occupied connection moves with `switchRoom`, which is cheaper than a full exit and enter.
+  if (slot.room) {
+    slot.cloud->switchRoom(room->switchConfig());
+  } else {
+    slot.cloud->enterRoom(room->params(), scene_);
+  }
+  slot.room = room;
+}
+
+void TRTCRoomManager::leaveSlot(Slot& slot) {
+  if (!slot.cloud || !slot.room) {
+    return;
+  }
+  resetSlotStreams(slot);
+  slot.cloud->exitRoom();
+  slot.generation->fetch_add(1, std::memory_order_acq_rel);
+  slot.room.reset();
+  slot.switchedFrom.reset();
+  slot.entered = false;
+  slot.users.clear();
+}
+
+void TRTCRoomManager::restoreSlot(Slot& slot, bool presented) {
+  slot.generation->fetch_add(1, std::memory_order_acq_rel);
+  slot.room = std::move(slot.switchedFrom);
+  slot.users.swap(slot.switchedUsers);
+  slot.videoUsers.swap(slot.switchedVideoUsers);
+  slot.switchedUsers.clear();
+  slot.switchedVideoUsers.clear();
+  slot.entered = true;
+  if (slot.hub) {
+    for (const std::string& user : slot.videoUsers) {
+      slot.hub->attachRemoteUser(user.c_str());
+    }
+  }
+  if (presented) {
+    present(slot);
+  }
+}
+
+void TRTCRoomManager::resetSlotStreams(Slot& slot) {
+  if (!slot.hub) {
+    return;
+  }
+  for (const std::string& user : slot.videoUsers) {
+    slot.hub->detachRemoteUser(user.c_str());
+  }
+  slot.videoUsers.clear();
+  slot.hub->clearAllStreams();
+}
+
+void TRTCRoomManager::present(Slot& slot) {
+  if (!slot.cloud) {
+    return;
+  }
+  slot.cloud->muteAllRemoteAudio(false);
+  slot.cloud->muteAllRemoteVideoStreams(false);
+  for (const std::string& user : slot.users) {
+    if (callback_) {
+      callback_->onRemoteUserEnterRoom(user.c_str());
+    }
+  }
+  for (const std::string& user : slot.videoUsers) {
+    slot.cloud->startRemoteView(user.c_str(), TRTCVideoStreamTypeBig, nullptr);
+    if (callback_) {
+      callback_->onUserVideoAvailable(user.c_str(), true);
+    }
+  }
+}
+
+void TRTCRoomManager::withdraw(Slot& slot) {
+  if (!callback_) {
+    return;
+  }
+  for (const std::string& user : slot.users) {
+    callback_->onRemoteUserLeaveRoom(user.c_str());
+  }
+}
+
+void TRTCRoomManager::predictNext() {
+  if (ring_.size() < 2 || !active().room) {
+    return;
+  }
+  const int current = ringIndexOf(active().room->key);
+  if (current < 0) {
+    return;
+  }
+  const int count = static_cast<int>(ring_.size());
+  const int index = (current + ring_direction_ + count) % count;
+  const std::shared_ptr<Room>& next = ring_[index];
+  if (!standby().room || standby().room->key != next->key) {
+    enterSlot(standby(), next, false);
+  }
+}
+
+int TRTCRoomManager::ringIndexOf(const std::string& key) const {
+  for (size_t i = 0; i < ring_.size(); ++i) {
+    if (ring_[i]->key == key) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+void TRTCRoomManager::finishSwitch() {
+  if (!switch_pending_) {
+    return;
+  }
+  switch_pending_ = false;
+  UE_LOG(LogTRTCPlugin, Log, TEXT("room switch to %s (%s): entered %.0f ms, audio %.0f ms, video %.0f ms"),
+         UTF8_TO_TCHAR(stats_.roomKey.c_str()), stats_.warm ? TEXT("warm") : TEXT("cold"), stats_.enterRoomMs,
+         stats_.firstAudioMs, stats_.firstVideoMs);
+  if (callback_) {
+    callback_->onRoomSwitched(stats_);
+  }
+}
+
+void TRTCRoomManager::handleEvent(int slotIndex,
+                                  uint32_t generation,
+                                  SlotEvent event,
+                                  const std::string& text,
+                                  int value) {
+  Slot& slot = *slots_[slotIndex];
+  if (generation != slot.generation->load(std::memory_order_acquire)) {
+    return;
+  }
+  const bool presented = slotIndex == active_index_;
+  const bool measuring = presented && switch_pending_;
+  switch (event) {
+    case SlotEvent::Error:
+      if (presented && callback_) {
+        callback_->onError(static_cast<TXLiteAVError>(value), text.c_str());
+      }
+      break;
+    case SlotEvent::EnterRoom:
+      // `onEnterRoom` reports elapsed milliseconds on success; switchRoom success is mapped to 1.
+      if (value < 0) {
+        UE_LOG(LogTRTCPlugin, Warning, TEXT("TRTCRoomManager: entering room failed, %d"), value);
+        if (slot.switchedFrom) {
+          // A failed `switchRoom` leaves the SDK in the room it came from, so that room is presented again as is.
+          restoreSlot(slot, presented);
+        } else {
+          // Make sure the cloud is out of the room before it is entered again.
+          slot.cloud->exitRoom();
+          slot.generation->fetch_add(1, std::memory_order_acq_rel);
+          slot.room.reset();
+        }
+        if (measuring) {
+          abortSwitch(static_cast<TXLiteAVError>(value));
+        }
+        break;
+      }
+      slot.entered = true;
+      slot.switchedFrom.reset();
+      slot.switchedUsers.clear();
+      slot.switchedVideoUsers.clear();
+      if (measuring && stats_.enterRoomMs < 0) {
+        stats_.enterRoomMs = elapsedMs();
+      }
+      break;
+    case SlotEvent::UserEnter:
+      slot.users.insert(text);
+      if (presented && callback_) {
+        callback_->onRemoteUserEnterRoom(text.c_str());
+      }
+      break;
+    case SlotEvent::UserLeave:
+      if (slot.videoUsers.erase(text) > 0) {
+        slot.hub->detachRemoteUser(text.c_str());
+        slot.hub->clearStream(TRTCStreamKey(text.c_str(), TRTCVideoStreamTypeBig));
+      }
+      if (slot.users.erase(text) > 0 && presented && callback_) {
+        callback_->onRemoteUserLeaveRoom(text.c_str());
+      }
+      break;
+    case SlotEvent::VideoAvailable:
+      if (value != 0) {
+        slot.videoUsers.insert(text);
+        slot.hub->attachRemoteUser(text.c_str());
+        if (presented) {
+          slot.cloud->startRemoteView(text.c_str(), TRTCVideoStreamTypeBig, nullptr);
+        }
+      } else {
+        slot.videoUsers.erase(text);
+        if (presented) {
+          slot.cloud->stopRemoteView(text.c_str(), TRTCVideoStreamTypeBig);
+        }
+        slot.hub->detachRemoteUser(text.c_str());
+        slot.hub->clearStream(TRTCStreamKey(text.c_str(), TRTCVideoStreamTypeBig));
+      }
+      if (presented && callback_) {
+        callback_->onUserVideoAvailable(text.c_str(), value != 0);
+      }
+      break;
+    case SlotEvent::FirstVideo:
+      if (measuring && !text.empty()) {
+        stats_.firstVideoMs = elapsedMs();
+        finishSwitch();
+      }
+      break;
+    case SlotEvent::FirstAudio:
+      if (measuring && stats_.firstAudioMs < 0) {
+        stats_.firstAudioMs = elapsedMs();
+      }
+      break;
+  }
+}
+
+void TRTCRoomManager::abortSwitch(TXLiteAVError errCode) {
+  switch_pending_ = false;
+  // Go back to the room the switch started from, unless the failed switch already left the connection there. Its own
+  // failure is only reported, there is nothing left to go back to.
+  std::shared_ptr<Room> previous = std::move(previous_room_);
+  if (previous && !active().room) {
+    switchRoom(previous->params());
+  }
+  if (callback_) {
+    callback_->onError(errCode, "TRTCRoomManager: entering room failed");
+  }
+}
+
+double TRTCRoomManager::elapsedMs() const {
+  return (FPlatformTime::Seconds() - switch_started_) * 1000.0;
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,364 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCRoster.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Misc/ScopeLock.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+constexpr uint8_t kPublishingFlags =
+    TRTCUserFlag_AudioAvailable | TRTCUserFlag_VideoAvailable | TRTCUserFlag_SubStreamAvailable;
+constexpr uint32_t kGenerationMask = 0xFFF;
+constexpr size_t kMinBuckets = 64;
+
+}  // namespace
+
+TRTCRoster::TRTCRoster() = default;
+
+TRTCRoster::~TRTCRoster() = default;
+
+void TRTCRoster::setListener(TRTCRosterListener* listener) {
+  listener_ = listener;
+}
+
+void TRTCRoster::setSpeakingThreshold(uint32_t volume) {
+  speaking_threshold_ = volume;
+}
+
+void TRTCRoster::tick() {
+  {
+    FScopeLock lock(&queue_mutex_);
+    std::swap(incoming_, draining_);
+  }
+  for (const PendingEvent& event : draining_.events) {
+    apply(event, draining_.text.data() + event.textOffset);
+  }
+  draining_.events.clear();
+  draining_.text.clear();
+  publishChanges();
+}
+
+TRTCUserHandle TRTCRoster::find(const char* userId) const {
+  if (!userId) {
+    return kTRTCInvalidUserHandle;
+  }
+  const size_t length = std::strlen(userId);
+  const uint32_t slot = findSlot(userId, length, hashId(userId, length));
+  return slot == kEmptyBucket ? kTRTCInvalidUserHandle : makeHandle(slot);
+}
+
+bool TRTCRoster::isValid(TRTCUserHandle handle) const {
+  return slotOf(handle) != kEmptyBucket;
+}
+
+const char* TRTCRoster::userId(TRTCUserHandle handle) const {
+  const uint32_t slot = slotOf(handle);
+  return slot == kEmptyBucket ? nullptr : ids_[slot].c_str();
+}
+
+uint8_t TRTCRoster::flags(TRTCUserHandle handle) const {
+  const uint32_t slot = slotOf(handle);
+  return slot == kEmptyBucket ? 0 : flags_[slot];
+}
+
+uint32_t TRTCRoster::volume(TRTCUserHandle handle) const {
+  const uint32_t slot = slotOf(handle);
+  return slot == kEmptyBucket ? 0 : volumes_[slot];
+}
+
+uint32_t TRTCRoster::countWithFlags(uint8_t mask) const {
+  uint32_t count = 0;
+  for (size_t slot = 0; slot < flags_.size(); ++slot) {
+    count += (states_[slot] == SlotState::Present && (flags_[slot] & mask) == mask) ? 1 : 0;
+  }
+  return count;
+}
+
+void TRTCRoster::onExitRoom(int /*reason*/) {
+  push(EventType::Clear, nullptr, 0, 0);
+}
+
+void TRTCRoster::onRemoteUserEnterRoom(const char* userId) {
+  push(EventType::Enter, userId, 0, 0);
+}
+
+void TRTCRoster::onRemoteUserLeaveRoom(const char* userId, int /*reason*/) {
+  push(EventType::Leave, userId, 0, 0);
+}
+
+void TRTCRoster::onUserVideoAvailable(const char* userId, bool available) {
+  push(EventType::Flag, userId, TRTCUserFlag_VideoAvailable, available ? 1 : 0);
+}
+
+void TRTCRoster::onUserSubStreamAvailable(const char* userId, bool available) {
+  push(EventType::Flag, userId, TRTCUserFlag_SubStreamAvailable, available ? 1 : 0);
+}
+
+void TRTCRoster::onUserAudioAvailable(const char* userId, bool available) {
+  push(EventType::Flag, userId, TRTCUserFlag_AudioAvailable, available ? 1 : 0);
+}
+
+void TRTCRoster::onUserVoiceVolume(TRTCVolumeInfo* userVolumes, uint32_t userVolumesCount, uint32_t /*totalVolume*/) {
+  // Users missing from a report are silent, so the whole report is queued as one contiguous batch.
+  FScopeLock lock(&queue_mutex_);
+  push(EventType::VolumeReport, nullptr, 0, 0);
+  for (uint32_t i = 0; i < userVolumesCount; ++i) {
+    const TRTCVolumeInfo& info = userVolumes[i];
+    // The local user is reported with an empty ID.
+    if (info.userId && info.userId[0] != '\0') {
+      push(EventType::Volume, info.userId, 0, static_cast<uint8_t>(std::min<uint32_t>(info.volume, 100)));
+    }
+  }
+}
+
+uint32_t TRTCRoster::hashId(const char* id, size_t length) {
+  // FNV-1a.
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(id[i])) * 16777619u;
+  }
+  return hash;
+}
+
+uint32_t TRTCRoster::slotOf(TRTCUserHandle handle) const {
+  const uint32_t slot = handle & kIndexMask;
+  if (handle == kTRTCInvalidUserHandle || slot >= states_.size() || states_[slot] == SlotState::Free ||
+      generations_[slot] != (handle >> kIndexBits)) {
+    return kEmptyBucket;
+  }
+  return slot;
+}
+
+uint32_t TRTCRoster::findSlot(const char* id, size_t length, uint32_t hash) const {
+  if (buckets_.empty()) {
+    return kEmptyBucket;
+  }
+  const size_t mask = buckets_.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    const uint32_t slot = buckets_[i];
+    if (slot == kEmptyBucket) {
+      return kEmptyBucket;
+    }
+    if (hashes_[slot] == hash && ids_[slot].size() == length && std::memcmp(ids_[slot].data(), id, length) == 0) {
+      return slot;
+    }
+  }
+}
+
+void TRTCRoster::insertBucket(uint32_t slot) {
+  const size_t mask = buckets_.size() - 1;
+  size_t i = hashes_[slot] & mask;
+  while (buckets_[i] != kEmptyBucket) {
+    i = (i + 1) & mask;
+  }
+  buckets_[i] = slot;
+}
+
+void TRTCRoster::eraseBucket(uint32_t slot) {
+  const size_t mask = buckets_.size() - 1;
+  size_t hole = hashes_[slot] & mask;
+  while (buckets_[hole] != slot) {
+    hole = (hole + 1) & mask;
+  }
+  // Backward-shift deletion: pull later entries of the probe run into the hole so that no tombstones accumulate.
+  for (size_t i = (hole + 1) & mask; buckets_[i] != kEmptyBucket; i = (i + 1) & mask) {
+    const size_t home = hashes_[buckets_[i]] & mask;
+    const bool reachable = hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+    if (!reachable) {
+      buckets_[hole] = buckets_[i];
+      hole = i;
+    }
+  }
+  buckets_[hole] = kEmptyBucket;
+}
+
+void TRTCRoster::growTable() {
+  buckets_.assign(std::max(kMinBuckets, buckets_.size() * 2), kEmptyBucket);
+  for (uint32_t slot = 0; slot < static_cast<uint32_t>(states_.size()); ++slot) {
+    if (states_[slot] == SlotState::Present) {
+      insertBucket(slot);
+    }
+  }
+}
+
+void TRTCRoster::push(EventType type, const char* userId, uint8_t flag, uint8_t value) {
+  FScopeLock lock(&queue_mutex_);
+  const size_t length = userId ? std::strlen(userId) : 0;
+  PendingEvent event;
+  event.type = type;
+  event.flag = flag;
+  event.value = value;
+  event.textOffset = static_cast<uint32_t>(incoming_.text.size());
+  event.textLength = static_cast<uint32_t>(length);
+  incoming_.text.insert(incoming_.text.end(), userId, userId + length);
+  incoming_.events.push_back(event);
+}
+
+void TRTCRoster::apply(const PendingEvent& event, const char* text) {
+  const uint32_t hash = hashId(text, event.textLength);
+  switch (event.type) {
+    case EventType::Enter:
+      enter(text, event.textLength, hash);
+      break;
+    case EventType::Leave: {
+      const uint32_t slot = findSlot(text, event.textLength, hash);
+      if (slot != kEmptyBucket) {
+        leave(slot);
+      }
+      break;
+    }
+    case EventType::Flag: {
+      // Availability implies presence even if the enter event was missed.
+      const uint32_t slot = enter(text, event.textLength, hash);
+      if (slot != kEmptyBucket) {
+        setFlag(slot, event.flag, event.value != 0);
+      }
+      break;
+    }
+    case EventType::VolumeReport:
+      for (uint32_t slot : speakers_) {
+        volumes_[slot] = 0;
+        setFlag(slot, TRTCUserFlag_Speaking, false);
+      }
+      speakers_.clear();
+      break;
+    case EventType::Volume: {
+      const uint32_t slot = findSlot(text, event.textLength, hash);
+      if (slot != kEmptyBucket && event.value > 0) {
+        volumes_[slot] = event.value;
+        speakers_.push_back(slot);
+        setFlag(slot, TRTCUserFlag_Speaking, event.value >= speaking_threshold_);
+      }
+      break;
+    }
+    case EventType::Clear:
+      for (uint32_t slot = 0; slot < static_cast<uint32_t>(states_.size()); ++slot) {
+        if (states_[slot] == SlotState::Present) {
+          leave(slot);
+        }
+      }
+      break;
+  }
+}
+
+uint32_t TRTCRoster::enter(const char* id, size_t length, uint32_t hash) {
+  if (length == 0) {
+    return kEmptyBucket;
+  }
+  const uint32_t existing = findSlot(id, length, hash);
+  if (existing != kEmptyBucket) {
+    return existing;
+  }
+  uint32_t slot;
+  if (!free_slots_.empty()) {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    if (states_.size() > kIndexMask) {
+      return kEmptyBucket;
+    }
+    slot = static_cast<uint32_t>(states_.size());
+    ids_.emplace_back();
+    hashes_.push_back(0);
+    generations_.push_back(0);
+    flags_.push_back(0);
+    volumes_.push_back(0);
+    states_.push_back(SlotState::Free);
+    entered_this_tick_.push_back(0);
+    touched_this_tick_.push_back(0);
+  }
+  // `assign` reuses the buffer the slot kept from its previous user.
+  ids_[slot].assign(id, length);
+  hashes_[slot] = hash;
+  flags_[slot] = 0;
+  volumes_[slot] = 0;
+  states_[slot] = SlotState::Present;
+  entered_this_tick_[slot] = 1;
+  ++count_;
+  if (static_cast<size_t>(count_) * 2 > buckets_.size()) {
+    growTable();
+  } else {
+    insertBucket(slot);
+  }
+  touch(slot);
+  return slot;
+}
+
+void TRTCRoster::leave(uint32_t slot) {
+  touch(slot);
+  eraseBucket(slot);
+  states_[slot] = SlotState::Leaving;
+  --count_;
+  for (size_t i = 0; i < speakers_.size(); ++i) {
+    if (speakers_[i] == slot) {
+      speakers_[i] = speakers_.back();
+      speakers_.pop_back();
+      break;
+    }
+  }
+  released_.push_back(slot);
+}
+
+void TRTCRoster::setFlag(uint32_t slot, uint8_t flag, bool on) {
+  const uint8_t previous = flags_[slot];
+  uint8_t flags = on ? (previous | flag) : (previous & ~flag);
+  flags = (flags & kPublishingFlags) ? (flags | TRTCUserFlag_Anchor) : (flags & ~TRTCUserFlag_Anchor);
+  if (flags != previous) {
+    touch(slot);
+    flags_[slot] = flags;
+  }
+}
+
+void TRTCRoster::touch(uint32_t slot) {
+  if (!touched_this_tick_[slot]) {
+    touched_this_tick_[slot] = 1;
+    touched_.push_back({slot, flags_[slot]});
+  }
+}
+
+void TRTCRoster::publishChanges() {
+  for (const Touched& touched : touched_) {
+    const uint32_t slot = touched.slot;
+    const bool entered = entered_this_tick_[slot] != 0;
+    touched_this_tick_[slot] = 0;
+    entered_this_tick_[slot] = 0;
+    if (states_[slot] == SlotState::Leaving) {
+      if (!entered) {
+        left_.push_back(makeHandle(slot));
+      }
+    } else if (entered) {
+      entered_.push_back(makeHandle(slot));
+    } else if (flags_[slot] != touched.flags) {
+      updated_.push_back(makeHandle(slot));
+    }
+  }
+  touched_.clear();
+  if (!entered_.empty() || !left_.empty()) {
+    ++membership_revision_;
+  }
+
+  if (listener_ && (!entered_.empty() || !left_.empty() || !updated_.empty())) {
+    listener_->onRosterChanged(TRTCRosterChanges{entered_, left_, updated_});
+  }
+  entered_.clear();
+  left_.clear();
+  updated_.clear();
+
+  for (uint32_t slot : released_) {
+    states_[slot] = SlotState::Free;
+    generations_[slot] = (generations_[slot] + 1) & kGenerationMask;
+    flags_[slot] = 0;
+    volumes_[slot] = 0;
+    free_slots_.push_back(slot);
+  }
+  released_.clear();
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,451 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCSessionRecorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "HAL/FileManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "TRTCPlugin.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+constexpr uint32_t kDrainIntervalMs = 20;
+// Longest that written data stays in a write buffer, so a crash loses at most this much of every file.
+constexpr double kFlushSeconds = 2.0;
+constexpr uint32_t kWavHeaderBytes = 44;
+
+void appendBytes(std::vector<uint8_t>& buffer, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+void appendText(std::vector<uint8_t>& buffer, const char* text) {
+  appendBytes(buffer, text, std::strlen(text));
+}
+
+void appendLE(std::vector<uint8_t>& buffer, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) {
+    buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+// File names keep letters, digits, '-' and '_' and percent-encode every other byte, so distinct user ids never map to
+// the same file and no id can escape the recording directory.
+std::string fileStem(const char* userId) {
+  std::string stem;
+  for (const char* c = userId; *c; ++c) {
+    const unsigned char byte = static_cast<unsigned char>(*c);
+    if ((byte >= '0' && byte <= '9') || (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') || byte == '-' ||
+        byte == '_') {
+      stem.push_back(static_cast<char>(byte));
+    } else {
+      char escaped[4];
+      std::snprintf(escaped, sizeof(escaped), "%%%02X", byte);
+      stem.append(escaped);
+    }
+  }
+  return stem;
+}
+
+const char* streamSuffix(TRTCVideoStreamType type) {
+  switch (type) {
+    case TRTCVideoStreamTypeSmall:
+      return "small";
+    case TRTCVideoStreamTypeSub:
+      return "sub";
+    default:
+      return "main";
+  }
+}
+
+}  // namespace
+
+class TRTCSessionRecorder::Worker : public FRunnable {
+ public:
+  explicit Worker(TRTCSessionRecorder* recorder)
+      : recorder_(recorder),
+        wake_(FPlatformProcess::GetSynchEventFromPool(false)),
+        closed_(FPlatformProcess::GetSynchEventFromPool(false)) {
+    thread_ = FRunnableThread::Create(this, TEXT("TRTCSessionRecorder"), 0, TPri_BelowNormal);
+  }
+
+  ~Worker() override {
+    if (thread_) {
+      stopping_.store(true);
+      wake_->Trigger();
+      thread_->WaitForCompletion();
+      delete thread_;
+    }
+    FPlatformProcess::ReturnSynchEventToPool(wake_);
+    FPlatformProcess::ReturnSynchEventToPool(closed_);
+  }
+
+  void wake() { wake_->Trigger(); }
+
+  void setDirectory(const FString& directory) {
+    FScopeLock lock(&directory_mutex_);
+    directory_ = directory;
+  }
+
+  // Write out and close every file of `session` and the sessions before it, and wait until that is done.
+  void close(uint32_t session) {
+    if (!thread_) {
+      // Nothing was ever written, and nothing would trigger `closed_`.
+      return;
+    }
+    close_request_.store(session);
+    wake_->Trigger();
+    closed_->Wait();
+  }
+
+  uint32 Run() override {
+    while (!stopping_.load()) {
+      wake_->Wait(kDrainIntervalMs);
+      drain();
+      const uint32_t request = close_request_.load();
+      if (request != closed_session_) {
+        drain();
+        closeAll();
+        closed_session_ = request;
+        closed_->Trigger();
+      }
+    }
+    drain();
+    closeAll();
+    return 0;
+  }
+
+ private:
+  struct Stream {
+    FArchive* file = nullptr;
+    bool failed = false;
+    bool wav = false;
+    uint32_t segment = 0;
+    // Resolution (video) or sample format (audio) the current file was started with.
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t sampleRate = 0;
+    uint32_t channels = 0;
+    uint64_t dataBytes = 0;
+    std::vector<uint8_t> buffer;
+  };
+
+  void drain() {
+    while (recorder_->queue_.tryPop([this](Job& job) {
+      if (job.session > closed_session_) {
+        if (job.video) {
+          writeVideo(job);
+        } else {
+          writeAudio(job);
+        }
+      }
+      recorder_->queued_bytes_.fetch_sub(job.bytes, std::memory_order_relaxed);
+      job.frame.reset();
+    })) {
+    }
+    const double now = FPlatformTime::Seconds();
+    if (now - last_flush_ >= kFlushSeconds) {
+      last_flush_ = now;
+      for (auto& stream : streams_) {
+        flush(stream.second);
+      }
+    }
+  }
+
+  void writeVideo(const Job& job) {
+    const TRTCFrameView& source = job.frame->view();
+    Stream& stream = streams_[fileStem(job.userId) + "." + streamSuffix(job.streamType)];
+    if (stream.file && (stream.width != source.width || stream.height != source.height)) {
+      closeStream(stream);
+      ++stream.segment;
+    }
+    if (!stream.file && !stream.failed) {
+      stream.width = source.width;
+      stream.height = source.height;
+      if (openStream(stream, job.userId, streamSuffix(job.streamType), TEXT("y4m"))) {
+        char header[128];
+        std::snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n",
+                      source.width, source.height, std::max<uint32_t>(1, recorder_->config_.videoFrameRate));
+        appendText(stream.buffer, header);
+      }
+    }
+    if (!stream.file) {
+      return;
+    }
+
+    const TRTCFrameView* planar = &source;
+    if (source.format != TRTCVideoPixelFormat_I420) {
+      if (!i420_ || i420_->width() != source.width || i420_->height() != source.height) {
+        i420_ = std::make_unique<TRTCFrameBuffer>(TRTCVideoPixelFormat_I420, source.width, source.height);
+      }
+      if (!convertFrame(source, i420_->view())) {
+        return;
+      }
+      planar = &i420_->view();
+    }
+    // Frame parameters starting with 'X' are ignored by Y4M readers; the capture time lets tools re-time the stream.
+    char frameHeader[48];
+    std::snprintf(frameHeader, sizeof(frameHeader), "FRAME XPTS=%llu\n",
+                  static_cast<unsigned long long>(source.timestamp));
+    appendText(stream.buffer, frameHeader);
+    using Traits = TRTCPixelFormatTraits<TRTCVideoPixelFormat_I420>;
+    for (int plane = 0; plane < Traits::kPlaneCount; ++plane) {
+      const uint32_t rowBytes = Traits::planeWidth(plane, source.width);
+      const uint32_t rows = Traits::planeHeight(plane, source.height);
+      for (uint32_t row = 0; row < rows; ++row) {
+        appendBytes(stream.buffer, planar->planes[plane] + static_cast<size_t>(row) * planar->strides[plane], rowBytes);
+      }
+    }
+    recorder_->video_frames_.fetch_add(1, std::memory_order_relaxed);
+    if (stream.buffer.size() >= recorder_->config_.writeChunkBytes) {
+      flush(stream);
+    }
+  }
+
+  void writeAudio(const Job& job) {
+    Stream& stream = streams_[fileStem(job.userId) + ".audio"];
+    if (stream.file && (stream.sampleRate != job.sampleRate || stream.channels != job.channels)) {
+      closeStream(stream);
+      ++stream.segment;
+    }
+    if (!stream.file && !stream.failed) {
+      stream.sampleRate = job.sampleRate;
+      stream.channels = job.channels;
+      stream.wav = true;
+      stream.dataBytes = 0;
+      if (openStream(stream, job.userId, "audio", TEXT("wav"))) {
+        // The RIFF and data sizes are patched in when the file is closed.
+        appendText(stream.buffer, "RIFF");
+        appendLE(stream.buffer, 0, 4);
+        appendText(stream.buffer, "WAVEfmt ");
+        appendLE(stream.buffer, 16, 4);
+        appendLE(stream.buffer, 1, 2);
+        appendLE(stream.buffer, job.channels, 2);
+        appendLE(stream.buffer, job.sampleRate, 4);
+        appendLE(stream.buffer, job.sampleRate * job.channels * 2, 4);
+        appendLE(stream.buffer, job.channels * 2, 2);
+        appendLE(stream.buffer, 16, 2);
+        appendText(stream.buffer, "data");
+        appendLE(stream.buffer, 0, 4);
+      }
+    }
+    if (!stream.file) {
+      return;
+    }
+    appendBytes(stream.buffer, job.pcm, job.bytes);
+    stream.dataBytes += job.bytes;
+    recorder_->audio_frames_.fetch_add(1, std::memory_order_relaxed);
+    if (stream.buffer.size() >= recorder_->config_.writeChunkBytes) {
+      flush(stream);
+    }
+  }
+
+  bool openStream(Stream& stream, const char* userId, const char* suffix, const TCHAR* extension) {
+    FString directory;
+    {
+      FScopeLock lock(&directory_mutex_);
+      directory = directory_;
+    }
+    const std::string name = fileStem(userId) + "." + suffix;
+    const FString path = FPaths::Combine(
+        directory, FString::Printf(TEXT("%s.%u.%s"), UTF8_TO_TCHAR(name.c_str()), stream.segment, extension));
+    stream.file = IFileManager::Get().CreateFileWriter(*path, FILEWRITE_AllowRead);
+    if (!stream.file) {
+      // Later data of this stream is discarded until the next session instead of retrying every frame.
+      stream.failed = true;
+      UE_LOG(LogTRTCPlugin, Warning, TEXT("TRTCSessionRecorder: cannot create %s"), *path);
+      return false;
+    }
+    stream.buffer.reserve(recorder_->config_.writeChunkBytes + recorder_->config_.writeChunkBytes / 4);
+    return true;
+  }
+
+  void flush(Stream& stream) {
+    if (!stream.file || stream.buffer.empty()) {
+      return;
+    }
+    stream.file->Serialize(stream.buffer.data(), static_cast<int64>(stream.buffer.size()));
+    recorder_->bytes_written_.fetch_add(stream.buffer.size(), std::memory_order_relaxed);
+    stream.buffer.clear();
+  }
+
+  void closeStream(Stream& stream) {
+    flush(stream);
+    if (stream.file && stream.wav) {
+      const uint32_t dataBytes =
+          static_cast<uint32_t>(std::min<uint64_t>(stream.dataBytes, 0xFFFFFFFFu - kWavHeaderBytes));
+      std::vector<uint8_t> size;
+      appendLE(size, kWavHeaderBytes - 8 + dataBytes, 4);
+      appendLE(size, dataBytes, 4);
+      stream.file->Seek(4);
+      stream.file->Serialize(size.data(), 4);
+      stream.file->Seek(kWavHeaderBytes - 4);
+      stream.file->Serialize(size.data() + 4, 4);
+    }
+    delete stream.file;
+    stream.file = nullptr;
+  }
+
+  void closeAll() {
+    for (auto& stream : streams_) {
+      closeStream(stream.second);
+    }
+    streams_.clear();
+  }
+
+  TRTCSessionRecorder* recorder_;
+  FEvent* wake_;
+  FEvent* closed_;
+  FRunnableThread* thread_ = nullptr;
+  std::atomic<bool> stopping_{false};
+  std::atomic<uint32_t> close_request_{0};
+  uint32_t closed_session_ = 0;
+  FCriticalSection directory_mutex_;
+  FString directory_;
+  std::map<std::string, Stream> streams_;
+  std::unique_ptr<TRTCFrameBuffer> i420_;
+  double last_flush_ = 0;
+};
+
+TRTCSessionRecorder::TRTCSessionRecorder(const TRTCSessionRecorderConfig& config)
+    : config_(config), queue_(std::max<uint32_t>(config.maxQueuedJobs, 16)), pool_(8) {
+  worker_ = std::make_unique<Worker>(this);
+}
+
+TRTCSessionRecorder::~TRTCSessionRecorder() {
+  stop();
+  worker_.reset();
+}
+
+void TRTCSessionRecorder::start(const FString& directory) {
+  stop();
+  IFileManager::Get().MakeDirectory(*directory, true);
+  worker_->setDirectory(directory);
+  session_.fetch_add(1);
+  recording_.store(true);
+}
+
+void TRTCSessionRecorder::stop() {
+  if (!recording_.exchange(false)) {
+    return;
+  }
+  // Frames that passed the `recording_` check concurrently carry this session and are discarded by the worker.
+  worker_->close(session_.load());
+}
+
+TRTCSessionRecorderStats TRTCSessionRecorder::stats() const {
+  TRTCSessionRecorderStats stats;
+  stats.videoFrames = video_frames_.load(std::memory_order_relaxed);
+  stats.audioFrames = audio_frames_.load(std::memory_order_relaxed);
+  stats.droppedVideoFrames = dropped_video_.load(std::memory_order_relaxed);
+  stats.droppedAudioFrames = dropped_audio_.load(std::memory_order_relaxed);
+  stats.bytesWritten = bytes_written_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void TRTCSessionRecorder::onFrame(const TRTCStreamKey& key, const TRTCFrameView& frame) {
+  if (!config_.recordVideo || key.isLocal() || !recording_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  uint32_t strides[3];
+  TRTCFrameView::alignedStrides(frame.format, frame.width, strides);
+  const size_t bytes = TRTCFrameView::bufferSize(frame.format, frame.height, strides);
+  if (!reserve(bytes, true)) {
+    dropped_video_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  // Only a copy is made here; the conversion to I420 happens on the I/O thread.
+  std::shared_ptr<TRTCFrameBuffer> buffer = pool_.acquire(frame.format, frame.width, frame.height);
+  if (!buffer || !convertFrame(frame, buffer->view())) {
+    queued_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    return;
+  }
+  buffer->setTimestamp(frame.timestamp);
+  const uint32_t session = session_.load();
+  const bool pushed = queue_.tryPush([&](Job& job) {
+    job.session = session;
+    job.video = true;
+    job.streamType = key.streamType;
+    std::snprintf(job.userId, kMaxUserIdBytes, "%s", key.userId.c_str());
+    job.bytes = bytes;
+    job.frame = std::move(buffer);
+  });
+  if (!pushed) {
+    queued_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    dropped_video_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  worker_->wake();
+}
+
+TRTCAudioConsumerOptions TRTCSessionRecorder::consumerOptions() {
+  TRTCAudioConsumerOptions options;
+  options.sources = TRTCAudioSource_Remote;
+  options.delivery = TRTCAudioDelivery::Queued;
+  options.dropPolicy = TRTCAudioDropPolicy::DropNewest;
+  return options;
+}
+
+void TRTCSessionRecorder::onAudioBlock(const TRTCAudioBlock& block) {
+  if (!config_.recordAudio || block.source != TRTCAudioSource_Remote || block.userId[0] == '\0' ||
+      block.sampleType != TRTCAudioSampleType::Int16 || block.frames == 0 ||
+      !recording_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  const size_t frameBytes = static_cast<size_t>(block.channels) * 2;
+  const size_t chunkBytes = kMaxAudioJobBytes / frameBytes * frameBytes;
+  if (chunkBytes == 0) {
+    dropped_audio_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const uint8_t* data = static_cast<const uint8_t*>(block.data);
+  const size_t total = block.bytes();
+  const uint32_t session = session_.load();
+  for (size_t offset = 0; offset < total; offset += chunkBytes) {
+    const size_t bytes = std::min(chunkBytes, total - offset);
+    if (!reserve(bytes, false)) {
+      dropped_audio_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+    const bool pushed = queue_.tryPush([&](Job& job) {
+      job.session = session;
+      job.video = false;
+      std::snprintf(job.userId, kMaxUserIdBytes, "%s", block.userId);
+      job.bytes = bytes;
+      std::memcpy(job.pcm, data + offset, bytes);
+      job.sampleRate = block.sampleRate;
+      job.channels = block.channels;
+    });
+    if (!pushed) {
+      queued_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+      dropped_audio_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+  }
+  worker_->wake();
+}
+
+bool TRTCSessionRecorder::reserve(size_t bytes, bool video) {
+  const uint64_t limit = video ? config_.maxQueuedBytes / 2 : config_.maxQueuedBytes;
+  uint64_t queued = queued_bytes_.load(std::memory_order_relaxed);
+  do {
+    if (queued + bytes > limit) {
+      return false;
+    }
+  } while (!queued_bytes_.compare_exchange_weak(queued, queued + bytes, std::memory_order_relaxed));
+  return true;
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,225 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCSilenceSuppressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+// The worker also polls, so a missed trigger costs at most this much.
+constexpr uint32_t kPollMs = 50;
+constexpr float kSilenceDb = -100.f;
+
+float frameLevelDb(const int16_t* pcm, uint32_t samples) {
+  double energy = 0;
+  for (uint32_t i = 0; i < samples; ++i) {
+    energy += static_cast<double>(pcm[i]) * pcm[i];
+  }
+  if (energy <= 0) {
+    return kSilenceDb;
+  }
+  const double rms = std::sqrt(energy / samples) / 32768.0;
+  return std::max(kSilenceDb, static_cast<float>(20.0 * std::log10(rms)));
+}
+
+}  // namespace
+
+class TRTCSilenceSuppressor::Worker : public FRunnable {
+ public:
+  explicit Worker(TRTCSilenceSuppressor* suppressor)
+      : suppressor_(suppressor), wake_(FPlatformProcess::GetSynchEventFromPool(false)) {
+    thread_ = FRunnableThread::Create(this, TEXT("TRTCSilenceSuppressor"), 0, TPri_AboveNormal);
+  }
+
+  ~Worker() override {
+    if (thread_) {
+      stopping_.store(true);
+      wake_->Trigger();
+      thread_->WaitForCompletion();
+      delete thread_;
+    }
+    FPlatformProcess::ReturnSynchEventToPool(wake_);
+  }
+
+  void wake() { wake_->Trigger(); }
+
+  TRTCSilenceSuppressorStats stats() const {
+    TRTCSilenceSuppressorStats stats;
+    stats.suppressed = suppressed_.load(std::memory_order_relaxed);
+    stats.mutes = mutes_.load(std::memory_order_relaxed);
+    stats.unmutes = unmutes_.load(std::memory_order_relaxed);
+    stats.suppressedSeconds = suppressed_seconds_.load(std::memory_order_relaxed);
+    if (stats.suppressed) {
+      stats.suppressedSeconds += FPlatformTime::Seconds() - suppressed_since_.load(std::memory_order_relaxed);
+    }
+    return stats;
+  }
+
+  uint32 Run() override {
+    while (!stopping_.load()) {
+      wake_->Wait(kPollMs);
+      apply();
+    }
+    // Leave the microphone as the user set it.
+    suppressor_->cloud_.muteLocalAudio(suppressor_->user_muted_.load());
+    return 0;
+  }
+
+ private:
+  void apply() {
+    const TRTCSilenceSuppressor& suppressor = *suppressor_;
+    const bool userMuted = suppressor.user_muted_.load(std::memory_order_acquire);
+    const bool suppress = !userMuted && suppressor.enabled_.load(std::memory_order_acquire) &&
+                          !suppressor.speaking_.load(std::memory_order_acquire);
+    const bool mute = userMuted || suppress;
+    if (!applied_ || mute != muted_) {
+      suppressor_->cloud_.muteLocalAudio(mute);
+      muted_ = mute;
+      applied_ = true;
+    }
+    if (suppress != suppressed_.load(std::memory_order_relaxed)) {
+      const double now = FPlatformTime::Seconds();
+      if (suppress) {
+        mutes_.fetch_add(1, std::memory_order_relaxed);
+        suppressed_since_.store(now, std::memory_order_relaxed);
+      } else {
+        unmutes_.fetch_add(1, std::memory_order_relaxed);
+        suppressed_seconds_.store(suppressed_seconds_.load(std::memory_order_relaxed) + now -
+                                      suppressed_since_.load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+      }
+      suppressed_.store(suppress, std::memory_order_relaxed);
+    }
+  }
+
+  TRTCSilenceSuppressor* const suppressor_;
+  bool applied_ = false;
+  bool muted_ = false;
+  std::atomic<bool> suppressed_{false};
+  std::atomic<uint64_t> mutes_{0};
+  std::atomic<uint64_t> unmutes_{0};
+  std::atomic<double> suppressed_since_{0};
+  std::atomic<double> suppressed_seconds_{0};
+
+  FEvent* wake_;
+  FRunnableThread* thread_ = nullptr;
+  std::atomic<bool> stopping_{false};
+};
+
+TRTCSilenceSuppressor::TRTCSilenceSuppressor(TRTCCloud& cloud,
+                                             const TRTCSilenceSuppressorConfig& config,
+                                             TRTCAudioFrameProcessor* inner)
+    : cloud_(cloud),
+      config_(config),
+      inner_(inner),
+      delay_line_(std::make_unique<int16_t[]>(kMaxSampleRate / 1000 * kMaxPreRollMs * kMaxChannels)) {
+  noise_floor_.store(noise_floor_db_);
+  worker_ = std::make_unique<Worker>(this);
+}
+
+TRTCSilenceSuppressor::~TRTCSilenceSuppressor() {
+  worker_.reset();
+}
+
+void TRTCSilenceSuppressor::setEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_release);
+  worker_->wake();
+}
+
+void TRTCSilenceSuppressor::setUserMuted(bool muted) {
+  user_muted_.store(muted, std::memory_order_release);
+  worker_->wake();
+}
+
+TRTCSilenceSuppressorStats TRTCSilenceSuppressor::stats() const {
+  TRTCSilenceSuppressorStats stats = worker_->stats();
+  stats.speaking = speaking_.load(std::memory_order_relaxed);
+  stats.noiseFloorDb = noise_floor_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void TRTCSilenceSuppressor::processCapturedAudio(int16_t* pcm,
+                                                 uint32_t frames,
+                                                 uint32_t channels,
+                                                 uint32_t sampleRate) {
+  if (!pcm || frames == 0) {
+    return;
+  }
+  if (inner_) {
+    inner_->processCapturedAudio(pcm, frames, channels, sampleRate);
+  }
+  // Formats the delay line has no room for still pass through the inner processor, just without suppression.
+  if (channels == 0 || channels > kMaxChannels || sampleRate == 0 || sampleRate > kMaxSampleRate) {
+    return;
+  }
+  // Detection sees the audio as captured, the encoder sees it `preRollMs` later.
+  detect(pcm, frames, channels, sampleRate);
+  delay(pcm, frames, channels, sampleRate);
+}
+
+void TRTCSilenceSuppressor::detect(const int16_t* pcm, uint32_t frames, uint32_t channels, uint32_t sampleRate) {
+  const float levelDb = frameLevelDb(pcm, frames * channels);
+  const bool speech = levelDb >= std::max(config_.minSpeechDb, noise_floor_db_ + config_.onsetMarginDb);
+  // The floor drops at once and rises slowly, ten times slower still during speech so a long talk does not raise
+  // it, while a background that got louder is eventually learned anyway.
+  const float seconds = static_cast<float>(frames) / sampleRate;
+  if (levelDb < noise_floor_db_) {
+    noise_floor_db_ += 0.5f * (levelDb - noise_floor_db_);
+  } else {
+    const float rise = config_.floorRiseDbPerSecond * seconds * (speech ? 0.1f : 1.f);
+    noise_floor_db_ = std::min(levelDb, noise_floor_db_ + rise);
+  }
+  noise_floor_.store(noise_floor_db_, std::memory_order_relaxed);
+
+  const bool speaking = speaking_.load(std::memory_order_relaxed);
+  if (speech) {
+    silent_samples_ = 0;
+    if (!speaking) {
+      speaking_.store(true, std::memory_order_release);
+      worker_->wake();
+    }
+    return;
+  }
+  silent_samples_ += frames;
+  if (speaking && silent_samples_ * 1000 >= static_cast<uint64_t>(config_.silenceHoldMs) * sampleRate) {
+    speaking_.store(false, std::memory_order_release);
+    worker_->wake();
+  }
+}
+
+void TRTCSilenceSuppressor::delay(int16_t* pcm, uint32_t frames, uint32_t channels, uint32_t sampleRate) {
+  if (sampleRate != sample_rate_ || channels != channels_) {
+    // A format change starts the delay line over from silence.
+    sample_rate_ = sampleRate;
+    channels_ = channels;
+    delay_samples_ = sampleRate / 1000 * std::min(config_.preRollMs, kMaxPreRollMs) * channels;
+    delay_position_ = 0;
+    std::memset(delay_line_.get(), 0, sizeof(int16_t) * delay_samples_);
+  }
+  if (delay_samples_ == 0) {
+    return;
+  }
+  // Swap the frame through the ring piece by piece, each piece contiguous in the ring.
+  uint32_t remaining = frames * channels;
+  while (remaining > 0) {
+    const uint32_t chunk = std::min(remaining, delay_samples_ - delay_position_);
+    int16_t* line = delay_line_.get() + delay_position_;
+    for (uint32_t i = 0; i < chunk; ++i) {
+      std::swap(pcm[i], line[i]);
+    }
+    pcm += chunk;
+    remaining -= chunk;
+    delay_position_ = (delay_position_ + chunk) % delay_samples_;
+  }
+}
+
+}  // namespace ue
+}  // namespace liteav
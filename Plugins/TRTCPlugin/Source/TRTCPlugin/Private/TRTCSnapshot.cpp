@@ -0,0 +1,83 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCSnapshot.h"
+
+#include "Async/Async.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+// Encode `view` (any supported format) on the calling worker thread.
+bool encodeFrame(IImageWrapperModule& module,
+                 const TRTCFrameView& view,
+                 TRTCSnapshotFormat format,
+                 int32 quality,
+                 TArray64<uint8>& encoded) {
+  const ERGBFormat rgbFormat = view.format == TRTCVideoPixelFormat_RGBA32 ? ERGBFormat::RGBA : ERGBFormat::BGRA;
+  const TRTCVideoPixelFormat packedFormat =
+      view.format == TRTCVideoPixelFormat_RGBA32 ? TRTCVideoPixelFormat_RGBA32 : TRTCVideoPixelFormat_BGRA32;
+
+  // The image wrapper wants tightly packed rows; plugin buffers pad every row, and planar frames need converting.
+  const uint32_t rowBytes = view.width * 4;
+  TArray64<uint8> pixels;
+  pixels.SetNumUninitialized(static_cast<int64>(rowBytes) * view.height);
+  TRTCFrameView packed;
+  packed.format = packedFormat;
+  packed.width = view.width;
+  packed.height = view.height;
+  packed.strides[0] = rowBytes;
+  packed.planes[0] = pixels.GetData();
+  if (!convertFrame(view, packed)) {
+    return false;
+  }
+
+  TSharedPtr<IImageWrapper> wrapper =
+      module.CreateImageWrapper(format == TRTCSnapshotFormat::PNG ? EImageFormat::PNG : EImageFormat::JPEG);
+  if (!wrapper.IsValid() ||
+      !wrapper->SetRaw(pixels.GetData(), pixels.Num(), static_cast<int32>(view.width), static_cast<int32>(view.height),
+                       rgbFormat, 8)) {
+    return false;
+  }
+  encoded = wrapper->GetCompressed(format == TRTCSnapshotFormat::PNG ? 0 : FMath::Clamp(quality, 1, 100));
+  return encoded.Num() > 0;
+}
+
+}  // namespace
+
+bool requestSnapshot(const TRTCVideoFrameHub& hub,
+                     const TRTCStreamKey& key,
+                     TRTCSnapshotFormat format,
+                     FTRTCSnapshotDelegate onComplete,
+                     int32 quality) {
+  std::shared_ptr<const TRTCFrameBuffer> frame = hub.latestFrame(key);
+  if (!frame) {
+    return false;
+  }
+  // Background tasks cannot load modules, so the image wrapper module is resolved here once.
+  static IImageWrapperModule& module =
+      FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName(TEXT("ImageWrapper")));
+
+  // Hub buffers are immutable, so the task reads the frame without copying it first.
+  AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask,
+            [frame = std::move(frame), key, format, quality, onComplete = MoveTemp(onComplete)]() mutable {
+              TRTCSnapshot snapshot;
+              snapshot.key = key;
+              snapshot.width = frame->width();
+              snapshot.height = frame->height();
+              snapshot.timestamp = frame->timestamp();
+              snapshot.success = encodeFrame(module, frame->view(), format, quality, snapshot.encoded);
+              frame.reset();
+              AsyncTask(ENamedThreads::GameThread,
+                        [snapshot = MoveTemp(snapshot), onComplete = MoveTemp(onComplete)]() {
+                          onComplete.ExecuteIfBound(snapshot);
+                        });
+            });
+  return true;
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,143 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCStreamTextures.h"
+
+#include "Engine/Texture2D.h"
+#include "TRTCDirtyTiles.h"
+#include "TRTCFrameUpload.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+// Both uploadable formats are four bytes per pixel.
+constexpr uint64_t kUploadBytesPerPixel = 4;
+
+}  // namespace
+
+struct TRTCStreamTextures::Stream {
+  explicit Stream(const TRTCStreamKey& streamKey) : key(streamKey) {
+    // Screen shares are mostly static, so only their changed tiles are uploaded.
+    if (key.streamType == TRTCVideoStreamTypeSub) {
+      tiles = std::make_unique<TRTCDirtyTiles>();
+    }
+  }
+
+  const TRTCStreamKey key;
+  UTexture2D* texture = nullptr;
+  uint64_t sequence = 0;
+  std::unique_ptr<TRTCDirtyTiles> tiles;
+};
+
+struct TRTCStreamTextureHandle::Consumer {
+  Consumer(TRTCVideoFrameHub& frameHub, std::shared_ptr<TRTCStreamTextures::Stream> sharedStream)
+      : hub(frameHub), stream(std::move(sharedStream)) {}
+  ~Consumer() { hub.removeConsumer(stream->key, this); }
+
+  TRTCVideoFrameHub& hub;
+  const std::shared_ptr<TRTCStreamTextures::Stream> stream;
+};
+
+UTexture2D* TRTCStreamTextureHandle::texture() const {
+  return consumer_ ? consumer_->stream->texture : nullptr;
+}
+
+void TRTCStreamTextureHandle::setDisplaySize(uint32_t width, uint32_t height) {
+  if (consumer_) {
+    consumer_->hub.setDisplaySize(consumer_->stream->key, consumer_.get(), width, height);
+  }
+}
+
+TRTCStreamTextures::TRTCStreamTextures(TRTCVideoFrameHub& hub) : hub_(hub) {}
+
+TRTCStreamTextures::~TRTCStreamTextures() = default;
+
+TRTCStreamTextureHandle TRTCStreamTextures::acquire(const TRTCStreamKey& key) {
+  std::weak_ptr<Stream>& entry = streams_[key];
+  std::shared_ptr<Stream> stream = entry.lock();
+  if (!stream) {
+    stream = std::make_shared<Stream>(key);
+    entry = stream;
+  }
+  TRTCStreamTextureHandle handle;
+  handle.consumer_ = std::make_shared<TRTCStreamTextureHandle::Consumer>(hub_, std::move(stream));
+  return handle;
+}
+
+void TRTCStreamTextures::tick() {
+  for (auto it = streams_.begin(); it != streams_.end();) {
+    std::shared_ptr<Stream> stream = it->second.lock();
+    if (!stream) {
+      it = streams_.erase(it);
+      continue;
+    }
+    ++it;
+    uint64_t sequence = 0;
+    std::shared_ptr<const TRTCFrameBuffer> frame = hub_.latestFrame(stream->key, &sequence);
+    if (sequence == stream->sequence) {
+      continue;
+    }
+    stream->sequence = sequence;
+    const bool cached = !frame;
+    if (cached) {
+      // Show the last frame seen before the stream was cleared, otherwise keep whatever the texture holds.
+      frame = hub_.cachedFrame(stream->key);
+      if (!frame) {
+        continue;
+      }
+    }
+    UTexture2D* texture = stream->texture;
+    if (!texture || static_cast<uint32_t>(texture->GetSizeX()) != frame->width() ||
+        static_cast<uint32_t>(texture->GetSizeY()) != frame->height()) {
+      texture = createFrameTexture(frame->format(), frame->width(), frame->height());
+      if (!texture) {
+        continue;
+      }
+      stream->texture = texture;
+      if (stream->tiles) {
+        stream->tiles->reset();
+      }
+    }
+    // The frame buffer stays referenced until the render thread has consumed it.
+    TRTCDirtyTiles* tiles = stream->tiles.get();
+    if (tiles && cached) {
+      tiles->reset();
+    } else if (tiles && tiles->diff(frame->view(), &regions_)) {
+      if (!regions_.empty() && uploadFrameRegions(texture, frame->view(), regions_, [frame]() {})) {
+        ++uploads_;
+        for (const FUpdateTextureRegion2D& region : regions_) {
+          upload_bytes_ += static_cast<uint64_t>(region.Width) * region.Height * kUploadBytesPerPixel;
+        }
+      }
+      continue;
+    }
+    if (uploadFrame(texture, frame->view(), [frame]() {})) {
+      ++uploads_;
+      upload_bytes_ += static_cast<uint64_t>(frame->width()) * frame->height() * kUploadBytesPerPixel;
+    }
+  }
+}
+
+uint32_t TRTCStreamTextures::streamCount() const {
+  uint32_t count = 0;
+  for (const auto& entry : streams_) {
+    count += entry.second.expired() ? 0 : 1;
+  }
+  return count;
+}
+
+void TRTCStreamTextures::AddReferencedObjects(FReferenceCollector& collector) {
+  for (auto& entry : streams_) {
+    if (std::shared_ptr<Stream> stream = entry.second.lock()) {
+      collector.AddReferencedObject(stream->texture);
+    }
+  }
+}
+
+FString TRTCStreamTextures::GetReferencerName() const {
+  return TEXT("TRTCStreamTextures");
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,295 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCSubmixBridge.h"
+
+#include <algorithm>
+
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+// Audio the submix ring holds, enough to ride out a stalled worker.
+constexpr uint32_t kRingMs = 500;
+
+bool isSupportedRate(int32 sampleRate) {
+  return sampleRate == 16000 || sampleRate == 24000 || sampleRate == 32000 || sampleRate == 44100 ||
+         sampleRate == 48000;
+}
+
+TRTCSubmixBridgeConfig sanitized(TRTCSubmixBridgeConfig config) {
+  config.channels = std::min<uint32_t>(std::max<uint32_t>(config.channels, 1), 2);
+  config.frameMs = std::min<uint32_t>(std::max<uint32_t>(config.frameMs, 5), 100);
+  return config;
+}
+
+int16_t toPcm16(float sample) {
+  const float scaled = sample * 32767.f;
+  return static_cast<int16_t>(std::min(32767.f, std::max(-32768.f, scaled)));
+}
+
+}  // namespace
+
+class TRTCSubmixBridge::Worker : public FRunnable {
+ public:
+  explicit Worker(TRTCSubmixBridge* bridge)
+      : bridge_(bridge),
+        max_frame_samples_(kMaxSampleRate / 1000 * bridge->config_.frameMs * bridge->config_.channels),
+        frames_(std::max<uint32_t>(bridge->config_.poolFrames, 2)),
+        pcm_(frames_.size() * max_frame_samples_),
+        wake_(FPlatformProcess::GetSynchEventFromPool(false)) {
+    for (size_t i = 0; i < frames_.size(); ++i) {
+      TRTCAudioFrame& frame = frames_[i];
+      frame.audioFormat = TRTCAudioFrameFormatPCM;
+      frame.data = reinterpret_cast<char*>(&pcm_[i * max_frame_samples_]);
+      frame.channel = bridge->config_.channels;
+    }
+    thread_ = FRunnableThread::Create(this, TEXT("TRTCSubmixBridge"), 0, TPri_AboveNormal);
+  }
+
+  ~Worker() override {
+    if (thread_) {
+      stopping_.store(true);
+      wake_->Trigger();
+      thread_->WaitForCompletion();
+      delete thread_;
+    }
+    FPlatformProcess::ReturnSynchEventToPool(wake_);
+  }
+
+  uint32 Run() override {
+    const uint32_t intervalMs = std::max<uint32_t>(bridge_->config_.frameMs / 4, 2);
+    while (!stopping_.load()) {
+      wake_->Wait(intervalMs);
+      pump();
+    }
+    return 0;
+  }
+
+ private:
+  void pump() {
+    const uint32_t sampleRate = bridge_->sample_rate_.load(std::memory_order_acquire);
+    if (sampleRate == 0) {
+      return;
+    }
+    if (sampleRate != sample_rate_) {
+      // Whatever was captured at the previous rate is discarded; the SDK buffer simply drains.
+      sample_rate_ = sampleRate;
+      frame_samples_ = sampleRate * bridge_->config_.frameMs / 1000 * bridge_->config_.channels;
+      ready_count_ = 0;
+      bridge_->ring_read_.store(bridge_->ring_write_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+    cutFrames();
+    deliver();
+  }
+
+  // Convert every complete frame in the ring into the pool.
+  void cutFrames() {
+    const TRTCSubmixBridge& bridge = *bridge_;
+    uint64_t read = bridge.ring_read_.load(std::memory_order_relaxed);
+    const uint64_t write = bridge.ring_write_.load(std::memory_order_acquire);
+    // Anchors are published before their samples, so every sample read here has its origin.
+    if (bridge.config_.clock) {
+      readClockAnchors();
+    }
+    while (write - read >= frame_samples_) {
+      if (ready_count_ == frames_.size()) {
+        // The SDK is not taking frames; keep the newest audio.
+        ready_head_ = (ready_head_ + 1) % frames_.size();
+        --ready_count_;
+        bridge_->overruns_.fetch_add(1, std::memory_order_relaxed);
+      }
+      const size_t index = (ready_head_ + ready_count_) % frames_.size();
+      int16_t* pcm = &pcm_[index * max_frame_samples_];
+      for (uint32_t i = 0; i < frame_samples_; ++i) {
+        pcm[i] = toPcm16(bridge.ring_[(read + i) & bridge.ring_mask_]);
+      }
+      TRTCAudioFrame& frame = frames_[index];
+      frame.length = frame_samples_ * sizeof(int16_t);
+      frame.sampleRate = sample_rate_;
+      if (bridge.config_.clock) {
+        const double offsetMs = static_cast<double>(read / bridge.config_.channels) * 1000.0 / sample_rate_;
+        frame.timestamp = static_cast<uint64_t>(std::max(0.0, origin_ms_ + offsetMs + 0.5));
+      }
+      read += frame_samples_;
+      ++ready_count_;
+    }
+    bridge_->ring_read_.store(read, std::memory_order_release);
+  }
+
+  // Feed the clock the readings of the submix buffers received since the last call, and keep the newest mapping.
+  void readClockAnchors() {
+    TRTCSubmixBridge& bridge = *bridge_;
+    TRTCMediaClock& clock = *bridge.config_.clock;
+    uint64_t read = bridge.anchor_read_.load(std::memory_order_relaxed);
+    const uint64_t write = bridge.anchor_write_.load(std::memory_order_acquire);
+    for (; read != write; ++read) {
+      const ClockAnchor& anchor = bridge.anchors_[read % kClockAnchors];
+      clock.observe(TRTCClockDomain::Audio, anchor.audioClock, anchor.platformSeconds);
+      const double writeMs = static_cast<double>(anchor.writePosition / bridge.config_.channels) * 1000.0 /
+                             anchor.sampleRate;
+      origin_ms_ = static_cast<double>(clock.pts(TRTCClockDomain::Audio, anchor.audioClock)) - writeMs;
+    }
+    bridge.anchor_read_.store(read, std::memory_order_release);
+  }
+
+  // Top the SDK buffer up to the target, estimating its level from the last report and the time since.
+  void deliver() {
+    const TRTCSubmixBridgeConfig& config = bridge_->config_;
+    const double now = FPlatformTime::Seconds();
+    double buffered = reported_ms_ - (now - reported_at_) * 1000.0;
+    while (buffered < config.targetBufferedMs) {
+      if (ready_count_ == 0) {
+        if (buffered <= 0 && delivering_) {
+          bridge_->underruns_.fetch_add(1, std::memory_order_relaxed);
+          delivering_ = false;
+        }
+        return;
+      }
+      TRTCAudioFrame& frame = frames_[ready_head_];
+      if (!config.clock) {
+        frame.timestamp = bridge_->cloud_.generateCustomPTS();
+      }
+      const int result = bridge_->cloud_.mixExternalAudioFrame(&frame);
+      ready_head_ = (ready_head_ + 1) % frames_.size();
+      --ready_count_;
+      if (result < 0) {
+        bridge_->rejected_frames_.fetch_add(1, std::memory_order_relaxed);
+        reported_ms_ = 0;
+        reported_at_ = now;
+        return;
+      }
+      bridge_->sent_frames_.fetch_add(1, std::memory_order_relaxed);
+      bridge_->buffered_ms_.store(result, std::memory_order_relaxed);
+      delivering_ = true;
+      // Some SDK builds report the level before adding the frame; never estimate less than what was just sent.
+      reported_ms_ = std::max<double>(result, buffered + config.frameMs);
+      reported_at_ = now;
+      buffered = reported_ms_;
+    }
+  }
+
+  TRTCSubmixBridge* const bridge_;
+  const uint32_t max_frame_samples_;
+  std::vector<TRTCAudioFrame> frames_;
+  std::vector<int16_t> pcm_;
+  // Converted frames waiting for delivery, a FIFO over `frames_`.
+  size_t ready_head_ = 0;
+  size_t ready_count_ = 0;
+  uint32_t sample_rate_ = 0;
+  uint32_t frame_samples_ = 0;
+  // Timestamp, in ms, the ring sample at write position zero would have; only maintained with a clock.
+  double origin_ms_ = 0;
+  double reported_ms_ = 0;
+  double reported_at_ = 0;
+  // Frames were delivered since the last underrun, so the next dry buffer counts as a new one.
+  bool delivering_ = false;
+
+  FEvent* wake_;
+  FRunnableThread* thread_ = nullptr;
+  std::atomic<bool> stopping_{false};
+};
+
+TRTCSubmixBridge::TRTCSubmixBridge(TRTCCloud& cloud, const TRTCSubmixBridgeConfig& config)
+    : cloud_(cloud), config_(sanitized(config)) {
+  const uint64_t samples = static_cast<uint64_t>(kMaxSampleRate) * config_.channels * kRingMs / 1000;
+  uint64_t capacity = 1024;
+  while (capacity < samples) {
+    capacity *= 2;
+  }
+  ring_mask_ = capacity - 1;
+  ring_ = std::make_unique<float[]>(capacity);
+}
+
+TRTCSubmixBridge::~TRTCSubmixBridge() {
+  stop();
+}
+
+void TRTCSubmixBridge::start(FAudioDevice* device, USoundSubmix* submix) {
+  stop();
+  if (!device) {
+    return;
+  }
+  device_ = device;
+  submix_ = submix;
+  sample_rate_.store(0);
+  anchor_read_.store(anchor_write_.load());
+  cloud_.enableMixExternalAudioFrame(config_.publish, config_.playout);
+  worker_ = std::make_unique<Worker>(this);
+  tapping_.store(true);
+  device_->RegisterSubmixBufferListener(this, submix_);
+}
+
+void TRTCSubmixBridge::stop() {
+  if (!device_) {
+    return;
+  }
+  tapping_.store(false);
+  device_->UnregisterSubmixBufferListener(this, submix_);
+  // Unregistration is carried out by the audio render thread; wait for it so the bridge can be destroyed after.
+  device_->FlushAudioRenderingCommands();
+  worker_.reset();
+  cloud_.enableMixExternalAudioFrame(false, false);
+  device_ = nullptr;
+  submix_ = nullptr;
+}
+
+TRTCSubmixBridgeStats TRTCSubmixBridge::stats() const {
+  TRTCSubmixBridgeStats stats;
+  stats.sentFrames = sent_frames_.load(std::memory_order_relaxed);
+  stats.underruns = underruns_.load(std::memory_order_relaxed);
+  stats.overruns = overruns_.load(std::memory_order_relaxed);
+  stats.rejectedFrames = rejected_frames_.load(std::memory_order_relaxed);
+  stats.bufferedMs = buffered_ms_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void TRTCSubmixBridge::OnNewSubmixBuffer(const USoundSubmix* /*OwningSubmix*/,
+                                         float* AudioData,
+                                         int32 NumSamples,
+                                         int32 NumChannels,
+                                         const int32 SampleRate,
+                                         double AudioClock) {
+  if (!tapping_.load(std::memory_order_relaxed) || !AudioData || NumChannels <= 0 || !isSupportedRate(SampleRate)) {
+    return;
+  }
+  sample_rate_.store(static_cast<uint32_t>(SampleRate), std::memory_order_release);
+  const uint32_t outChannels = config_.channels;
+  const uint64_t frames = static_cast<uint64_t>(NumSamples / NumChannels);
+  const uint64_t write = ring_write_.load(std::memory_order_relaxed);
+  const uint64_t read = ring_read_.load(std::memory_order_acquire);
+  if (config_.clock) {
+    // Only the reading is taken here; the clock locks, so the worker feeds it. Published before the samples, so the
+    // worker never stamps them with an older origin.
+    const uint64_t anchor = anchor_write_.load(std::memory_order_relaxed);
+    if (anchor - anchor_read_.load(std::memory_order_acquire) < kClockAnchors) {
+      anchors_[anchor % kClockAnchors] =
+          ClockAnchor{write, AudioClock, FPlatformTime::Seconds(), static_cast<uint32_t>(SampleRate)};
+      anchor_write_.store(anchor + 1, std::memory_order_release);
+    }
+  }
+  const uint64_t room = (ring_mask_ + 1 - (write - read)) / outChannels;
+  const uint64_t accepted = std::min(frames, room);
+  if (accepted < frames) {
+    overruns_.fetch_add(1, std::memory_order_relaxed);
+  }
+  for (uint64_t frame = 0; frame < accepted; ++frame) {
+    const float* in = AudioData + frame * NumChannels;
+    const float left = in[0];
+    const float right = NumChannels > 1 ? in[1] : in[0];
+    const uint64_t position = write + frame * outChannels;
+    if (outChannels == 1) {
+      ring_[position & ring_mask_] = 0.5f * (left + right);
+    } else {
+      ring_[position & ring_mask_] = left;
+      ring_[(position + 1) & ring_mask_] = right;
+    }
+  }
+  ring_write_.store(write + accepted * outChannels, std::memory_order_release);
+}
+
+}  // namespace ue
+}  // namespace liteav
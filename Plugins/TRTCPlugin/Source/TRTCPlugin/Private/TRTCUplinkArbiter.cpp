@@ -0,0 +1,358 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCUplinkArbiter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Misc/ScopeLock.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+constexpr uint32_t kMain = 0;
+constexpr uint32_t kSub = 1;
+
+// Estimation: back off on loss or a poor network, probe up slowly while the encoders use what they were given.
+constexpr uint32_t kBackoffLossPercent = 10;
+constexpr uint32_t kProbeLossPercent = 2;
+constexpr float kBackoffFactor = 0.85f;
+constexpr float kProbeFactor = 1.08f;
+constexpr float kProbeUsage = 0.8f;
+constexpr float kMeasureSmoothing = 0.3f;
+// Budget change that triggers a rebalance between statistics.
+constexpr float kBudgetRebalanceRatio = 0.05f;
+// The camera keeps its wanted frame rate down to this share of its wanted bitrate.
+constexpr float kReducedFpsShare = 0.75f;
+
+struct Rung {
+  TRTCVideoResolution resolution;
+  uint32_t height;
+  // Least bitrate the resolution looks acceptable at.
+  uint32_t minKbps;
+};
+
+// Largest first.
+constexpr Rung kLadder[] = {
+    {TRTCVideoResolution_1920_1080, 1080, 1800},
+    {TRTCVideoResolution_1280_720, 720, 900},
+    {TRTCVideoResolution_960_540, 540, 600},
+    {TRTCVideoResolution_640_360, 360, 300},
+    {TRTCVideoResolution_480_270, 270, 150},
+};
+
+uint32_t heightOf(TRTCVideoResolution resolution) {
+  for (const Rung& rung : kLadder) {
+    if (rung.resolution == resolution) {
+      return rung.height;
+    }
+  }
+  // Resolutions off the ladder are left to the application.
+  return 0;
+}
+
+uint32_t audioKbpsOf(TRTCAudioQuality quality) {
+  switch (quality) {
+    case TRTCAudioQualitySpeech:
+      return 24;
+    case TRTCAudioQualityMusic:
+      return 128;
+    default:
+      return 50;
+  }
+}
+
+}  // namespace
+
+TRTCUplinkArbiter::TRTCUplinkArbiter(TRTCCloud& cloud, const TRTCUplinkPolicy& policy)
+    : cloud_(cloud),
+      policy_(policy),
+      fixed_budget_kbps_(policy.budgetKbps),
+      budget_kbps_(static_cast<float>(policy.budgetKbps ? policy.budgetKbps : policy.initialBudgetKbps)),
+      message_bytes_(policy.messageKbps * 1000.f / 8.f),
+      message_count_(static_cast<float>(policy.maxMessagesPerSecond)),
+      message_refill_time_(FPlatformTime::Seconds()) {}
+
+TRTCUplinkArbiter::~TRTCUplinkArbiter() = default;
+
+void TRTCUplinkArbiter::setMainVideo(bool enabled, const TRTCVideoEncParam& wanted) {
+  videos_[kMain].enabled = enabled;
+  videos_[kMain].wanted = wanted;
+  dirty_ = true;
+}
+
+void TRTCUplinkArbiter::setSubStream(bool enabled, const TRTCVideoEncParam& wanted) {
+  if (enabled && !videos_[kSub].enabled) {
+    applied_[kSub].valid = false;
+  }
+  videos_[kSub].enabled = enabled;
+  videos_[kSub].wanted = wanted;
+  // The screen capture picks its settings up when it starts, so they have to be right before the next tick.
+  rebalance(FPlatformTime::Seconds());
+}
+
+void TRTCUplinkArbiter::setAudio(bool enabled, TRTCAudioQuality quality) {
+  if (audio_quality_ != quality) {
+    audio_kbps_ = 0;
+  }
+  audio_enabled_ = enabled;
+  audio_quality_ = quality;
+  dirty_ = true;
+}
+
+void TRTCUplinkArbiter::setBudgetKbps(uint32_t kbps) {
+  fixed_budget_kbps_ = kbps;
+  if (kbps) {
+    budget_kbps_ = static_cast<float>(kbps);
+  }
+  dirty_ = true;
+}
+
+void TRTCUplinkArbiter::onNetworkQuality(TRTCQualityInfo localQuality,
+                                         TRTCQualityInfo* /*remoteQuality*/,
+                                         uint32_t /*remoteQualityCount*/) {
+  FScopeLock lock(&mutex_);
+  quality_ = localQuality.quality;
+}
+
+void TRTCUplinkArbiter::onStatistics(const TRTCStatistics& statistics) {
+  FScopeLock lock(&mutex_);
+  incoming_.fresh = true;
+  incoming_.sentBytes = statistics.sentBytes;
+  incoming_.upLoss = statistics.upLoss;
+  incoming_.time = FPlatformTime::Seconds();
+  incoming_.audioKbps = 0;
+  for (uint32_t i = 0; i < statistics.localStatisticsArraySize; ++i) {
+    const TRTCLocalStatistics& local = statistics.localStatisticsArray[i];
+    if (local.streamType == TRTCVideoStreamTypeBig) {
+      incoming_.audioKbps = local.audioBitrate;
+    }
+  }
+}
+
+void TRTCUplinkArbiter::tick() {
+  const float before = budget_kbps_;
+  updateBudget();
+  if (std::abs(budget_kbps_ - before) > kBudgetRebalanceRatio * before) {
+    dirty_ = true;
+  }
+  if (dirty_) {
+    rebalance(FPlatformTime::Seconds());
+  }
+}
+
+void TRTCUplinkArbiter::updateBudget() {
+  PendingStatistics statistics;
+  TRTCQuality quality;
+  {
+    FScopeLock lock(&mutex_);
+    statistics = incoming_;
+    incoming_.fresh = false;
+    quality = quality_;
+  }
+  if (!statistics.fresh) {
+    return;
+  }
+  // Every report rebalances, so the split follows the measured audio bitrate and the budget.
+  dirty_ = true;
+
+  if (last_statistics_time_ > 0 && statistics.time > last_statistics_time_ &&
+      statistics.sentBytes >= last_sent_bytes_) {
+    measured_kbps_ = static_cast<float>((statistics.sentBytes - last_sent_bytes_) * 8 / 1000.0 /
+                                        (statistics.time - last_statistics_time_));
+  }
+  last_sent_bytes_ = statistics.sentBytes;
+  last_statistics_time_ = statistics.time;
+  {
+    FScopeLock lock(&mutex_);
+    stats_.measuredKbps = static_cast<uint32_t>(measured_kbps_);
+    stats_.upLoss = statistics.upLoss;
+  }
+  if (audio_enabled_ && statistics.audioKbps > 0) {
+    audio_kbps_ = audio_kbps_ > 0 ? audio_kbps_ + kMeasureSmoothing * (statistics.audioKbps - audio_kbps_)
+                                  : static_cast<float>(statistics.audioKbps);
+  }
+
+  if (fixed_budget_kbps_) {
+    budget_kbps_ = static_cast<float>(fixed_budget_kbps_);
+    return;
+  }
+  // Only the game thread writes the allocation, so it can be read without the lock here.
+  uint32_t allocated = 0;
+  for (uint32_t kbps : stats_.allocatedKbps) {
+    allocated += kbps;
+  }
+  if (quality >= TRTCQuality_Down) {
+    budget_kbps_ = static_cast<float>(policy_.minBudgetKbps);
+  } else if (statistics.upLoss > kBackoffLossPercent || quality >= TRTCQuality_Bad) {
+    budget_kbps_ *= kBackoffFactor;
+  } else if (statistics.upLoss < kProbeLossPercent && quality <= TRTCQuality_Good &&
+             measured_kbps_ >= kProbeUsage * allocated) {
+    budget_kbps_ *= kProbeFactor;
+  }
+  budget_kbps_ = std::min(std::max(budget_kbps_, static_cast<float>(policy_.minBudgetKbps)),
+                          static_cast<float>(std::max(policy_.maxBudgetKbps, policy_.minBudgetKbps)));
+}
+
+void TRTCUplinkArbiter::rebalance(double now) {
+  dirty_ = false;
+
+  const uint32_t budget = static_cast<uint32_t>(budget_kbps_);
+  uint32_t audio = 0;
+  if (audio_enabled_) {
+    audio = audio_kbps_ > 0 ? static_cast<uint32_t>(audio_kbps_) : audioKbpsOf(audio_quality_);
+  }
+  uint32_t remaining = budget > audio ? budget - audio : 0;
+  const uint32_t messages = std::min(policy_.messageKbps, remaining);
+  remaining -= messages;
+
+  const bool sharing = videos_[kSub].enabled;
+  TRTCVideoEncParam wanted[2] = {videos_[kMain].wanted, videos_[kSub].wanted};
+  if (sharing && policy_.preferSubStream) {
+    const TRTCVideoEncParam& cap = policy_.mainWhileSharing;
+    TRTCVideoEncParam& main = wanted[kMain];
+    if (heightOf(cap.videoResolution) < heightOf(main.videoResolution)) {
+      main.videoResolution = cap.videoResolution;
+    }
+    main.videoFps = std::min(main.videoFps, cap.videoFps);
+    main.videoBitrate = std::min(main.videoBitrate, cap.videoBitrate);
+  }
+  const uint32_t minimum[2] = {policy_.mainMinKbps, policy_.subMinKbps};
+
+  // The preferred channel leaves the other its minimum; both keep theirs when even that does not fit.
+  uint32_t kbps[2] = {0, 0};
+  const uint32_t first = policy_.preferSubStream ? kSub : kMain;
+  const uint32_t second = 1 - first;
+  const uint32_t reserve = videos_[second].enabled ? std::min(minimum[second], wanted[second].videoBitrate) : 0;
+  if (videos_[first].enabled) {
+    const uint32_t available = remaining > reserve ? remaining - reserve : 0;
+    kbps[first] = std::max(std::min(wanted[first].videoBitrate, available),
+                           std::min(minimum[first], wanted[first].videoBitrate));
+  }
+  if (videos_[second].enabled) {
+    const uint32_t available = remaining > kbps[first] ? remaining - kbps[first] : 0;
+    kbps[second] = std::max(std::min(wanted[second].videoBitrate, available), reserve);
+  }
+
+  {
+    FScopeLock lock(&mutex_);
+    ++stats_.rebalances;
+    stats_.budgetKbps = budget;
+    stats_.allocatedKbps[static_cast<uint32_t>(TRTCUplinkChannel::Audio)] = audio;
+    stats_.allocatedKbps[static_cast<uint32_t>(TRTCUplinkChannel::Messages)] = messages;
+    stats_.allocatedKbps[static_cast<uint32_t>(TRTCUplinkChannel::MainVideo)] = kbps[kMain];
+    stats_.allocatedKbps[static_cast<uint32_t>(TRTCUplinkChannel::SubStream)] = kbps[kSub];
+  }
+
+  if (videos_[kMain].enabled) {
+    applyVideo(kMain, shapeMain(wanted[kMain], kbps[kMain]), now);
+  }
+  if (videos_[kSub].enabled) {
+    applyVideo(kSub, shapeSub(wanted[kSub], kbps[kSub]), now);
+  }
+}
+
+TRTCVideoEncParam TRTCUplinkArbiter::shapeMain(const TRTCVideoEncParam& wanted, uint32_t kbps) const {
+  TRTCVideoEncParam param = wanted;
+  param.videoBitrate = kbps;
+  param.minVideoBitrate = std::min(wanted.minVideoBitrate, kbps);
+  const uint32_t wantedHeight = heightOf(wanted.videoResolution);
+  if (wantedHeight > 0) {
+    // The largest rung that is no larger than wanted and fits the bitrate, or the smallest one.
+    for (const Rung& rung : kLadder) {
+      if (rung.height <= wantedHeight) {
+        param.videoResolution = rung.resolution;
+        if (rung.minKbps <= kbps) {
+          break;
+        }
+      }
+    }
+  }
+  if (kbps < kReducedFpsShare * wanted.videoBitrate) {
+    param.videoFps = std::min(wanted.videoFps, policy_.reducedFps);
+  }
+  return param;
+}
+
+TRTCVideoEncParam TRTCUplinkArbiter::shapeSub(const TRTCVideoEncParam& wanted, uint32_t kbps) const {
+  TRTCVideoEncParam param = wanted;
+  param.videoBitrate = kbps;
+  param.minVideoBitrate = std::min(wanted.minVideoBitrate, kbps);
+  if (wanted.videoBitrate > 0 && kbps < wanted.videoBitrate) {
+    const uint32_t fps = static_cast<uint32_t>(std::lround(static_cast<double>(wanted.videoFps) * kbps /
+                                                           wanted.videoBitrate));
+    param.videoFps = std::max(std::min(fps, wanted.videoFps), std::min(policy_.subMinFps, wanted.videoFps));
+  }
+  return param;
+}
+
+bool TRTCUplinkArbiter::applyVideo(uint32_t index, const TRTCVideoEncParam& param, double now) {
+  Applied& applied = applied_[index];
+  const TRTCVideoEncParam& current = applied.param;
+  if (applied.valid) {
+    const bool sameShape = current.videoResolution == param.videoResolution && current.videoFps == param.videoFps &&
+                           current.resMode == param.resMode && current.enableAdjustRes == param.enableAdjustRes;
+    const float tolerance = policy_.bitrateTolerance * current.videoBitrate;
+    if (sameShape && std::abs(static_cast<float>(param.videoBitrate) - current.videoBitrate) <= tolerance) {
+      return false;
+    }
+    const bool upgrade = heightOf(param.videoResolution) > heightOf(current.videoResolution) ||
+                         param.videoFps > current.videoFps || param.videoBitrate > current.videoBitrate;
+    if (upgrade && now - applied.lastChange < policy_.minUpgradeSeconds) {
+      // Retried on the next rebalance, at the latest with the next statistics.
+      return false;
+    }
+  }
+  if (index == kMain) {
+    cloud_.setVideoEncoderParam(param);
+  } else {
+    cloud_.setSubStreamEncoderParam(param);
+  }
+  applied.valid = true;
+  applied.param = param;
+  applied.lastChange = now;
+  FScopeLock lock(&mutex_);
+  ++stats_.encoderUpdates;
+  return true;
+}
+
+bool TRTCUplinkArbiter::takeMessage(uint32_t bytes) {
+  FScopeLock lock(&mutex_);
+  const double now = FPlatformTime::Seconds();
+  const float elapsed = static_cast<float>(now - message_refill_time_);
+  message_refill_time_ = now;
+  const float byteRate = policy_.messageKbps * 1000.f / 8.f;
+  const float countRate = static_cast<float>(policy_.maxMessagesPerSecond);
+  message_bytes_ = std::min(byteRate, message_bytes_ + elapsed * byteRate);
+  message_count_ = std::min(countRate, message_count_ + elapsed * countRate);
+  if (message_count_ < 1.f || message_bytes_ < bytes) {
+    ++stats_.messagesRefused;
+    return false;
+  }
+  message_count_ -= 1.f;
+  message_bytes_ -= bytes;
+  return true;
+}
+
+bool TRTCUplinkArbiter::sendCustomCmdMsg(uint32_t cmdId,
+                                         const uint8_t* data,
+                                         uint32_t dataSize,
+                                         bool reliable,
+                                         bool ordered) {
+  return takeMessage(dataSize) && cloud_.sendCustomCmdMsg(cmdId, data, dataSize, reliable, ordered);
+}
+
+bool TRTCUplinkArbiter::sendSEIMsg(const uint8_t* data, uint32_t dataSize, int32_t repeatCount) {
+  return takeMessage(dataSize * static_cast<uint32_t>(std::max(repeatCount, 1))) &&
+         cloud_.sendSEIMsg(data, dataSize, repeatCount);
+}
+
+TRTCUplinkStats TRTCUplinkArbiter::stats() const {
+  FScopeLock lock(&mutex_);
+  return stats_;
+}
+
+}  // namespace ue
+}  // namespace liteav
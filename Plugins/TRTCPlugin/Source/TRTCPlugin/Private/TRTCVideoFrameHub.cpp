@@ -0,0 +1,312 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCVideoFrameHub.h"
+
+#include <algorithm>
+
+#include "Misc/ScopeLock.h"
+
+namespace liteav {
+namespace ue {
+
+class TRTCVideoFrameHub::LocalRenderCallback : public ITRTCVideoRenderCallback {
+ public:
+  explicit LocalRenderCallback(TRTCVideoFrameHub* hub) : hub_(hub) {}
+
+  void onRenderVideoFrame(const char* /*userId*/, TRTCVideoStreamType streamType, TRTCVideoFrame* frame) override {
+    if (frame) {
+      hub_->deliverFrame(TRTCStreamKey(nullptr, streamType), *frame);
+    }
+  }
+
+ private:
+  TRTCVideoFrameHub* hub_;
+};
+
+struct TRTCVideoFrameHub::StreamSlot {
+  FCriticalSection mutex;
+  std::map<const void*, std::pair<uint32_t, uint32_t>> consumers;
+  // Largest size requested by any consumer; zero when one of them needs full resolution or none reported yet.
+  uint32_t displayWidth = 0;
+  uint32_t displayHeight = 0;
+  std::shared_ptr<TRTCFrameBuffer> latest;
+  uint64_t sequence = 0;
+
+  void updateDisplaySize() {
+    displayWidth = 0;
+    displayHeight = 0;
+    for (const auto& consumer : consumers) {
+      if (consumer.second.first == 0 || consumer.second.second == 0) {
+        displayWidth = 0;
+        displayHeight = 0;
+        return;
+      }
+      displayWidth = std::max(displayWidth, consumer.second.first);
+      displayHeight = std::max(displayHeight, consumer.second.second);
+    }
+  }
+};
+
+TRTCVideoFrameHub::TRTCVideoFrameHub(TRTCCloud* cloud)
+    : cloud_(cloud), local_callback_(std::make_unique<LocalRenderCallback>(this)) {}
+
+TRTCVideoFrameHub::~TRTCVideoFrameHub() {
+  detachLocalStream();
+  // Views still held would keep delivering into the freed hub.
+  for (const auto& view : remote_views_) {
+    cloud_->stopRemoteView(view.first.c_str(), view.second.startedType);
+  }
+  remote_views_.clear();
+  std::set<std::string> users;
+  {
+    FScopeLock lock(&slots_mutex_);
+    users.swap(attached_users_);
+  }
+  for (const std::string& user : users) {
+    detachRemoteUser(user.c_str());
+  }
+}
+
+void TRTCVideoFrameHub::attachLocalStream() {
+  cloud_->setLocalVideoRenderCallback(kTRTCNativePixelFormat, TRTCVideoBufferType_Buffer, local_callback_.get());
+}
+
+void TRTCVideoFrameHub::detachLocalStream() {
+  cloud_->setLocalVideoRenderCallback(TRTCVideoPixelFormat_Unknown, TRTCVideoBufferType_Unknown, nullptr);
+}
+
+void TRTCVideoFrameHub::attachRemoteUser(const char* userId) {
+  if (!userId) {
+    return;
+  }
+  {
+    FScopeLock lock(&slots_mutex_);
+    attached_users_.insert(userId);
+  }
+  cloud_->setRemoteVideoRenderCallback(userId, kTRTCNativePixelFormat, TRTCVideoBufferType_Buffer, this);
+}
+
+void TRTCVideoFrameHub::detachRemoteUser(const char* userId) {
+  if (!userId) {
+    return;
+  }
+  {
+    FScopeLock lock(&slots_mutex_);
+    attached_users_.erase(userId);
+  }
+  cloud_->setRemoteVideoRenderCallback(userId, TRTCVideoPixelFormat_Unknown, TRTCVideoBufferType_Unknown, nullptr);
+}
+
+TRTCVideoStreamType TRTCVideoFrameHub::RemoteView::wantedType() const {
+  for (const auto& holder : holders) {
+    if (holder.second == TRTCVideoStreamTypeBig) {
+      return TRTCVideoStreamTypeBig;
+    }
+  }
+  return TRTCVideoStreamTypeSmall;
+}
+
+void TRTCVideoFrameHub::acquireRemoteView(const char* userId, const void* holder, TRTCVideoStreamType type) {
+  if (!userId) {
+    return;
+  }
+  auto it = remote_views_.find(userId);
+  if (it == remote_views_.end()) {
+    RemoteView& view = remote_views_[userId];
+    view.holders[holder] = type;
+    view.startedType = type;
+    view.type = type;
+    attachRemoteUser(userId);
+    cloud_->startRemoteView(userId, type, nullptr);
+    return;
+  }
+  RemoteView& view = it->second;
+  view.holders[holder] = type;
+  const TRTCVideoStreamType wanted = view.wantedType();
+  if (wanted != view.type) {
+    view.type = wanted;
+    cloud_->setRemoteVideoStreamType(userId, wanted);
+  }
+}
+
+void TRTCVideoFrameHub::releaseRemoteView(const char* userId, const void* holder) {
+  if (!userId) {
+    return;
+  }
+  auto it = remote_views_.find(userId);
+  if (it == remote_views_.end() || it->second.holders.erase(holder) == 0) {
+    return;
+  }
+  RemoteView& view = it->second;
+  if (!view.holders.empty()) {
+    const TRTCVideoStreamType wanted = view.wantedType();
+    if (wanted != view.type) {
+      view.type = wanted;
+      cloud_->setRemoteVideoStreamType(userId, wanted);
+    }
+    return;
+  }
+  cloud_->stopRemoteView(userId, view.startedType);
+  remote_views_.erase(it);
+  detachRemoteUser(userId);
+  clearStream(TRTCStreamKey(userId, TRTCVideoStreamTypeBig));
+  clearStream(TRTCStreamKey(userId, TRTCVideoStreamTypeSmall));
+}
+
+void TRTCVideoFrameHub::setDownscaleMode(TRTCDownscaleMode mode) {
+  downscale_mode_.store(mode, std::memory_order_relaxed);
+}
+
+void TRTCVideoFrameHub::setDisplaySize(const TRTCStreamKey& key,
+                                       const void* consumer,
+                                       uint32_t width,
+                                       uint32_t height) {
+  std::shared_ptr<StreamSlot> slot = findSlot(key, true);
+  FScopeLock lock(&slot->mutex);
+  auto& size = slot->consumers[consumer];
+  if (size.first == width && size.second == height) {
+    return;
+  }
+  size = std::make_pair(width, height);
+  slot->updateDisplaySize();
+}
+
+void TRTCVideoFrameHub::removeConsumer(const TRTCStreamKey& key, const void* consumer) {
+  std::shared_ptr<StreamSlot> slot = findSlot(key, false);
+  if (!slot) {
+    return;
+  }
+  FScopeLock lock(&slot->mutex);
+  slot->consumers.erase(consumer);
+  slot->updateDisplaySize();
+}
+
+std::shared_ptr<const TRTCFrameBuffer> TRTCVideoFrameHub::latestFrame(const TRTCStreamKey& key,
+                                                                      uint64_t* sequence) const {
+  std::shared_ptr<StreamSlot> slot = findSlot(key, false);
+  if (!slot) {
+    if (sequence) {
+      *sequence = 0;
+    }
+    return nullptr;
+  }
+  FScopeLock lock(&slot->mutex);
+  if (sequence) {
+    *sequence = slot->sequence;
+  }
+  return slot->latest;
+}
+
+void TRTCVideoFrameHub::clearStream(const TRTCStreamKey& key) {
+  std::shared_ptr<StreamSlot> slot = findSlot(key, false);
+  if (!slot) {
+    return;
+  }
+  std::shared_ptr<TRTCFrameBuffer> released;
+  {
+    FScopeLock lock(&slot->mutex);
+    released.swap(slot->latest);
+    ++slot->sequence;
+  }
+  if (released) {
+    last_frames_.store(key, released->view());
+  }
+}
+
+void TRTCVideoFrameHub::clearAllStreams() {
+  std::vector<std::shared_ptr<StreamSlot>> slots;
+  {
+    FScopeLock lock(&slots_mutex_);
+    for (const auto& slot : slots_) {
+      slots.push_back(slot.second);
+    }
+  }
+  for (const std::shared_ptr<StreamSlot>& slot : slots) {
+    std::shared_ptr<TRTCFrameBuffer> released;
+    FScopeLock lock(&slot->mutex);
+    released.swap(slot->latest);
+    ++slot->sequence;
+  }
+  last_frames_.clear();
+}
+
+void TRTCVideoFrameHub::addFrameTap(TRTCVideoFrameTap* tap) {
+  FWriteScopeLock lock(taps_lock_);
+  if (tap && std::find(taps_.begin(), taps_.end(), tap) == taps_.end()) {
+    taps_.push_back(tap);
+  }
+}
+
+void TRTCVideoFrameHub::removeFrameTap(TRTCVideoFrameTap* tap) {
+  FWriteScopeLock lock(taps_lock_);
+  taps_.erase(std::remove(taps_.begin(), taps_.end(), tap), taps_.end());
+}
+
+void TRTCVideoFrameHub::onRenderVideoFrame(const char* userId, TRTCVideoStreamType streamType, TRTCVideoFrame* frame) {
+  if (frame && userId && userId[0] != '\0') {
+    deliverFrame(TRTCStreamKey(userId, streamType), *frame);
+  }
+}
+
+std::shared_ptr<TRTCVideoFrameHub::StreamSlot> TRTCVideoFrameHub::findSlot(const TRTCStreamKey& key,
+                                                                           bool create) const {
+  FScopeLock lock(&slots_mutex_);
+  auto it = slots_.find(key);
+  if (it != slots_.end()) {
+    return it->second;
+  }
+  if (!create) {
+    return nullptr;
+  }
+  std::shared_ptr<StreamSlot> slot = std::make_shared<StreamSlot>();
+  slots_.emplace(key, slot);
+  return slot;
+}
+
+void TRTCVideoFrameHub::deliverFrame(const TRTCStreamKey& key, const TRTCVideoFrame& frame) {
+  const TRTCFrameView source = TRTCFrameView::fromVideoFrame(frame);
+  if (!source.isValid()) {
+    return;
+  }
+  {
+    // Render threads only share the lock for reading, so taps of different streams run concurrently.
+    FReadScopeLock lock(taps_lock_);
+    for (TRTCVideoFrameTap* tap : taps_) {
+      tap->onFrame(key, source);
+    }
+  }
+  std::shared_ptr<StreamSlot> slot = findSlot(key, true);
+  uint32_t displayWidth;
+  uint32_t displayHeight;
+  {
+    FScopeLock lock(&slot->mutex);
+    displayWidth = slot->displayWidth;
+    displayHeight = slot->displayHeight;
+  }
+
+  uint32_t width;
+  uint32_t height;
+  uint32_t boxFactor;
+  computeDownscaleSize(downscale_mode_.load(std::memory_order_relaxed), source.width, source.height, displayWidth,
+                       displayHeight, &width, &height, &boxFactor);
+  std::shared_ptr<TRTCFrameBuffer> buffer = pool_.acquire(kTRTCNativePixelFormat, width, height);
+  if (!buffer) {
+    return;
+  }
+  const bool converted = (width == source.width && height == source.height)
+                             ? convertFrame(source, buffer->view())
+                             : scaleFrame(source, buffer->view(), boxFactor);
+  if (!converted) {
+    return;
+  }
+  buffer->setTimestamp(source.timestamp);
+
+  // The previous frame is released outside the lock; it goes back to the pool once no upload references it anymore.
+  std::shared_ptr<TRTCFrameBuffer> previous = std::move(buffer);
+  FScopeLock lock(&slot->mutex);
+  slot->latest.swap(previous);
+  ++slot->sequence;
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,259 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCViewSubscriber.h"
+
+#include <algorithm>
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+// Camera pitch never extrapolates past straight up or down.
+constexpr float kMaxPitch = 89.f;
+// Shortest interval velocities are measured over; frames closer than this are merged.
+constexpr double kMinVelocityInterval = 1.0 / 240.0;
+
+FVector smoothed(const FVector& previous, const FVector& sample, float weight) {
+  return previous + (sample - previous) * weight;
+}
+
+}  // namespace
+
+TRTCViewSubscriber::TRTCViewSubscriber(TRTCVideoFrameHub& hub,
+                                       const TRTCRoster& roster,
+                                       const TRTCViewSubscriberConfig& config)
+    : hub_(hub), roster_(roster), config_(config) {}
+
+TRTCViewSubscriber::~TRTCViewSubscriber() {
+  expire(0, true);
+}
+
+void TRTCViewSubscriber::setParticipant(TRTCUserHandle handle, const FVector& location) {
+  const uint32_t slot = roster_.slot(handle);
+  if (slot == kTRTCInvalidSlot) {
+    return;
+  }
+  if (slot >= participants_.size()) {
+    participants_.resize(roster_.slotCount());
+  }
+  const double now = FPlatformTime::Seconds();
+  Participant& participant = participants_[slot];
+  if (participant.handle != handle) {
+    participant = Participant();
+    participant.handle = handle;
+    const char* userId = roster_.userId(handle);
+    participant.userId = userId ? userId : "";
+  }
+  const double interval = now - participant.sampledAt;
+  if (!participant.placed || interval >= kMinVelocityInterval) {
+    if (participant.placed) {
+      const FVector velocity = (location - participant.sampledLocation) / static_cast<float>(interval);
+      participant.velocity = smoothed(participant.velocity, velocity, config_.velocitySmoothing);
+    }
+    participant.sampledLocation = location;
+    participant.sampledAt = now;
+  }
+  participant.location = location;
+  participant.lastMoved = now;
+  participant.placed = true;
+}
+
+void TRTCViewSubscriber::removeParticipant(TRTCUserHandle handle) {
+  const uint32_t slot = roster_.slot(handle);
+  if (slot < participants_.size() && participants_[slot].handle == handle) {
+    participants_[slot] = Participant();
+  }
+}
+
+TRTCViewSubscriber::View TRTCViewSubscriber::makeView(const FVector& location,
+                                                      const FRotator& rotation,
+                                                      float fovDegrees,
+                                                      float aspect,
+                                                      float viewportHeight) {
+  const FRotationMatrix axes(rotation);
+  View view;
+  view.location = location;
+  view.forward = axes.GetUnitAxis(EAxis::X);
+  view.right = axes.GetUnitAxis(EAxis::Y);
+  view.up = axes.GetUnitAxis(EAxis::Z);
+  view.tanHalfX = FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(fovDegrees, 1.f, 170.f) * 0.5f));
+  view.tanHalfY = view.tanHalfX / FMath::Max(aspect, 0.01f);
+  view.viewportHeight = viewportHeight;
+  return view;
+}
+
+float TRTCViewSubscriber::projectedHeight(const View& view, const FVector& location) const {
+  const FVector offset = location - view.location;
+  const float depth = static_cast<float>(FVector::DotProduct(offset, view.forward));
+  const float radius = config_.boundsRadius;
+  if (depth <= -radius) {
+    return -1.f;
+  }
+  // Sphere against the side planes: the plane distance of a point at lateral offset x is (x - depth * tan) * cos, so
+  // the sphere overlaps while x <= depth * tan + radius / cos, with 1 / cos = sqrt(1 + tan^2).
+  const float x = static_cast<float>(FMath::Abs(FVector::DotProduct(offset, view.right)));
+  const float y = static_cast<float>(FMath::Abs(FVector::DotProduct(offset, view.up)));
+  if (x > depth * view.tanHalfX + radius * FMath::Sqrt(1.f + view.tanHalfX * view.tanHalfX) ||
+      y > depth * view.tanHalfY + radius * FMath::Sqrt(1.f + view.tanHalfY * view.tanHalfY)) {
+    return -1.f;
+  }
+  // Sized by distance rather than depth, so that a participant does not grow while crossing the edge of the view.
+  const float distance = FMath::Sqrt(static_cast<float>(FVector::DotProduct(offset, offset)));
+  if (distance <= radius) {
+    // Around the camera: as large as the screen.
+    return view.viewportHeight;
+  }
+  return FMath::Min(view.viewportHeight, view.viewportHeight * radius / (distance * view.tanHalfY));
+}
+
+void TRTCViewSubscriber::tick(const FVector& location,
+                              const FRotator& cameraRotation,
+                              float fovDegrees,
+                              float viewportWidth,
+                              float viewportHeight) {
+  const double now = FPlatformTime::Seconds();
+  const double interval = now - last_tick_;
+  // Camera managers report pitch in [0, 360); looking slightly down must not read as looking straight up.
+  FRotator rotation = cameraRotation;
+  rotation.Pitch = FRotator::NormalizeAxis(rotation.Pitch);
+  if (has_camera_ && interval >= kMinVelocityInterval) {
+    const float seconds = static_cast<float>(interval);
+    const float weight = config_.velocitySmoothing;
+    const float yawRate =
+        static_cast<float>(FMath::FindDeltaAngleDegrees(camera_rotation_.Yaw, rotation.Yaw)) / seconds;
+    const float pitchRate =
+        static_cast<float>(FMath::FindDeltaAngleDegrees(camera_rotation_.Pitch, rotation.Pitch)) / seconds;
+    yaw_rate_ += (yawRate - yaw_rate_) * weight;
+    pitch_rate_ += (pitchRate - pitch_rate_) * weight;
+    camera_velocity_ = smoothed(camera_velocity_, (location - camera_location_) / seconds, weight);
+  }
+  if (!has_camera_ || interval >= kMinVelocityInterval) {
+    camera_location_ = location;
+    camera_rotation_ = rotation;
+    last_tick_ = now;
+  }
+  has_camera_ = true;
+
+  const float aspect = viewportHeight > 0.f ? viewportWidth / viewportHeight : 1.f;
+  const View current = makeView(location, rotation, fovDegrees, aspect, viewportHeight);
+  const uint32_t steps = FMath::Max(config_.lookaheadSteps, 1u);
+  predicted_views_.clear();
+  for (uint32_t step = 1; step <= steps; ++step) {
+    const float ahead = config_.lookaheadSeconds * step / steps;
+    FRotator predicted = rotation;
+    predicted.Yaw += yaw_rate_ * ahead;
+    predicted.Pitch = FMath::Clamp(static_cast<float>(predicted.Pitch) + pitch_rate_ * ahead, -kMaxPitch, kMaxPitch);
+    predicted_views_.push_back(makeView(location + camera_velocity_ * ahead, predicted, fovDegrees, aspect,
+                                        viewportHeight));
+  }
+
+  stats_.visible = 0;
+  stats_.predicted = 0;
+  upcoming_.clear();
+  for (uint32_t slot = 0; slot < participants_.size(); ++slot) {
+    Participant& participant = participants_[slot];
+    if (participant.handle == kTRTCInvalidUserHandle) {
+      continue;
+    }
+    if (!roster_.isValid(participant.handle)) {
+      participant = Participant();
+      continue;
+    }
+    if (!participant.placed || !(roster_.flags(participant.handle) & TRTCUserFlag_VideoAvailable)) {
+      continue;
+    }
+    // Participants not moved for longer than the lookahead are standing still.
+    if (now - participant.lastMoved > config_.lookaheadSeconds) {
+      participant.velocity = FVector::ZeroVector;
+    }
+    const float height = projectedHeight(current, participant.location);
+    if (height >= 0.f) {
+      ++stats_.visible;
+      want(participant.userId,
+           height >= config_.bigStreamMinHeight ? TRTCVideoStreamTypeBig : TRTCVideoStreamTypeSmall,
+           false,
+           now);
+      continue;
+    }
+    for (uint32_t step = 0; step < steps; ++step) {
+      const float ahead = config_.lookaheadSeconds * (step + 1) / steps;
+      if (projectedHeight(predicted_views_[step], participant.location + participant.velocity * ahead) >= 0.f) {
+        upcoming_.emplace_back(ahead, slot);
+        break;
+      }
+    }
+  }
+
+  // Small stream first: it starts faster, and the participant is switched to the big stream once shown large.
+  std::sort(upcoming_.begin(), upcoming_.end());
+  if (upcoming_.size() > config_.maxPredicted) {
+    upcoming_.resize(config_.maxPredicted);
+  }
+  for (const auto& entry : upcoming_) {
+    ++stats_.predicted;
+    want(participants_[entry.second].userId, TRTCVideoStreamTypeSmall, true, now);
+  }
+
+  expire(now, false);
+  stats_.subscribed = static_cast<uint32_t>(subscriptions_.size());
+}
+
+bool TRTCViewSubscriber::subscribedType(TRTCUserHandle handle, TRTCVideoStreamType* type) const {
+  const uint32_t slot = roster_.slot(handle);
+  if (slot >= participants_.size() || participants_[slot].handle != handle) {
+    return false;
+  }
+  auto it = subscriptions_.find(participants_[slot].userId);
+  if (it == subscriptions_.end()) {
+    return false;
+  }
+  if (type) {
+    *type = it->second.type;
+  }
+  return true;
+}
+
+void TRTCViewSubscriber::want(const std::string& userId, TRTCVideoStreamType type, bool predicted, double now) {
+  auto it = subscriptions_.find(userId);
+  if (it == subscriptions_.end()) {
+    Subscription& subscription = subscriptions_[userId];
+    subscription.type = type;
+    subscription.lastWanted = now;
+    subscription.predicted = predicted;
+    hub_.acquireRemoteView(userId.c_str(), this, type);
+    return;
+  }
+  Subscription& subscription = it->second;
+  subscription.lastWanted = now;
+  if (predicted) {
+    // Whatever the participant is already receiving is good enough to come back into view with.
+    return;
+  }
+  if (subscription.predicted) {
+    subscription.predicted = false;
+    ++stats_.predictionHits;
+  }
+  if (subscription.type != type) {
+    subscription.type = type;
+    hub_.acquireRemoteView(userId.c_str(), this, type);
+  }
+}
+
+void TRTCViewSubscriber::expire(double now, bool all) {
+  for (auto it = subscriptions_.begin(); it != subscriptions_.end();) {
+    const bool present = roster_.find(it->first.c_str()) != kTRTCInvalidUserHandle;
+    if (!all && present && now - it->second.lastWanted < config_.unsubscribeDelay) {
+      ++it;
+      continue;
+    }
+    if (it->second.predicted) {
+      ++stats_.predictionMisses;
+    }
+    hub_.releaseRemoteView(it->first.c_str(), this);
+    it = subscriptions_.erase(it);
+  }
+}
+
+}  // namespace ue
+}  // namespace liteav
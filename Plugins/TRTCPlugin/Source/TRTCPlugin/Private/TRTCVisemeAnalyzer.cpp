@@ -0,0 +1,247 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCVisemeAnalyzer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "DSP/FFTAlgorithm.h"
+#include "Misc/ScopeLock.h"
+#include "TRTCPlugin.h"
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+constexpr uint32_t kLog2WindowFrames = 8;
+// Upper edge of each band in FFT bins of 62.5 Hz; the first band starts at 80 Hz (bin 2) and the last ends at Nyquist.
+constexpr uint32_t kFirstBin = 2;
+constexpr uint32_t kBandEnd[kTRTCVisemeBands] = {5, 16, 40, 129};
+constexpr float kBinHz = static_cast<float>(TRTCVisemeAnalyzer::kSampleRate) / TRTCVisemeAnalyzer::kWindowFrames;
+constexpr float kSilenceFloorDb = -100.f;
+
+uint32_t index(TRTCViseme viseme) {
+  return static_cast<uint32_t>(viseme);
+}
+
+float approach(float value, float target, float attack, float release) {
+  return value + (target - value) * (target > value ? attack : release);
+}
+
+}  // namespace
+
+struct TRTCVisemeAnalyzer::Speaker {
+  // Latest window of audio, oldest sample first.
+  float history[kWindowFrames] = {};
+  float hop[kHopFrames] = {};
+  uint32_t hopFill = 0;
+  double lastAudio = 0;
+  TRTCVisemeFeatures features;
+  Published* published = nullptr;
+};
+
+TRTCVisemeAnalyzer::TRTCVisemeAnalyzer(const TRTCVisemeConfig& config)
+    : config_(config), window_(kWindowFrames), windowed_(kWindowFrames) {
+  Audio::FFFTSettings settings;
+  settings.Log2Size = kLog2WindowFrames;
+  settings.bArrayIsAligned = false;
+  settings.bEnableHardwareAcceleration = true;
+  fft_ = Audio::FFFTFactory::NewFFTAlgorithm(settings);
+  if (fft_) {
+    spectrum_.resize(fft_->NumOutputFloats());
+  } else {
+    UE_LOG(LogTRTCPlugin, Warning, TEXT("TRTCVisemeAnalyzer: no FFT of %u points available"), kWindowFrames);
+  }
+  for (uint32_t i = 0; i < kWindowFrames; ++i) {
+    window_[i] = 0.5f - 0.5f * std::cos(2.f * PI * i / kWindowFrames);
+  }
+}
+
+TRTCVisemeAnalyzer::~TRTCVisemeAnalyzer() = default;
+
+TRTCAudioConsumerOptions TRTCVisemeAnalyzer::consumerOptions() const {
+  TRTCAudioConsumerOptions options;
+  options.sources = TRTCAudioSource_Remote;
+  options.format.sampleRate = kSampleRate;
+  options.format.channels = 1;
+  options.format.sampleType = TRTCAudioSampleType::Float32;
+  options.delivery = TRTCAudioDelivery::Queued;
+  options.queueBlocks = config_.queueBlocks;
+  options.dropPolicy = TRTCAudioDropPolicy::DropOldest;
+  return options;
+}
+
+bool TRTCVisemeAnalyzer::latest(const char* userId, TRTCVisemeFeatures& features) const {
+  if (!userId) {
+    return false;
+  }
+  const double now = FPlatformTime::Seconds();
+  FScopeLock lock(&mutex_);
+  auto it = published_.find(userId);
+  if (it == published_.end()) {
+    return false;
+  }
+  features = current(it->second, now);
+  return true;
+}
+
+void TRTCVisemeAnalyzer::snapshot(std::vector<TRTCVisemeResult>& results) const {
+  const double now = FPlatformTime::Seconds();
+  FScopeLock lock(&mutex_);
+  results.resize(published_.size());
+  size_t i = 0;
+  for (const auto& entry : published_) {
+    results[i].userId.assign(entry.first);
+    results[i].features = current(entry.second, now);
+    ++i;
+  }
+}
+
+TRTCVisemeStats TRTCVisemeAnalyzer::stats() const {
+  TRTCVisemeStats stats;
+  stats.hops = hops_.load(std::memory_order_relaxed);
+  if (stats.hops > 0) {
+    stats.averageHopMicroseconds = FPlatformTime::GetSecondsPerCycle64() *
+                                   static_cast<double>(analysis_cycles_.load(std::memory_order_relaxed)) * 1e6 /
+                                   static_cast<double>(stats.hops);
+  }
+  FScopeLock lock(&mutex_);
+  stats.speakers = static_cast<uint32_t>(published_.size());
+  return stats;
+}
+
+void TRTCVisemeAnalyzer::onAudioBlock(const TRTCAudioBlock& block) {
+  if (!fft_ || block.source != TRTCAudioSource_Remote || block.sampleRate != kSampleRate || block.channels != 1 ||
+      block.sampleType != TRTCAudioSampleType::Float32) {
+    return;
+  }
+  const double now = FPlatformTime::Seconds();
+  auto it = speakers_.find(block.userId);
+  if (it == speakers_.end()) {
+    std::unique_ptr<Speaker> speaker = std::make_unique<Speaker>();
+    FScopeLock lock(&mutex_);
+    speaker->published = &published_[block.userId];
+    it = speakers_.emplace(block.userId, std::move(speaker)).first;
+  }
+  Speaker& speaker = *it->second;
+  speaker.lastAudio = now;
+
+  const uint64_t start = FPlatformTime::Cycles64();
+  uint32_t hops = 0;
+  const float* samples = block.floatSamples();
+  for (uint32_t consumed = 0; consumed < block.frames;) {
+    const uint32_t count = std::min(block.frames - consumed, kHopFrames - speaker.hopFill);
+    std::memcpy(speaker.hop + speaker.hopFill, samples + consumed, count * sizeof(float));
+    speaker.hopFill += count;
+    consumed += count;
+    if (speaker.hopFill == kHopFrames) {
+      analyze(speaker);
+      speaker.hopFill = 0;
+      ++hops;
+    }
+  }
+  if (hops > 0) {
+    analysis_cycles_.fetch_add(FPlatformTime::Cycles64() - start, std::memory_order_relaxed);
+    hops_.fetch_add(hops, std::memory_order_relaxed);
+    FScopeLock lock(&mutex_);
+    speaker.published->features = speaker.features;
+    speaker.published->updated = now;
+  }
+  if (now - last_sweep_ > 1.0) {
+    last_sweep_ = now;
+    forgetIdle(now);
+  }
+}
+
+void TRTCVisemeAnalyzer::analyze(Speaker& speaker) {
+  std::memmove(speaker.history, speaker.history + kHopFrames, (kWindowFrames - kHopFrames) * sizeof(float));
+  std::memcpy(speaker.history + kWindowFrames - kHopFrames, speaker.hop, kHopFrames * sizeof(float));
+
+  float hopEnergy = 0.f;
+  for (uint32_t i = 0; i < kHopFrames; ++i) {
+    hopEnergy += speaker.hop[i] * speaker.hop[i];
+  }
+  const float energyDb = hopEnergy > 0.f ? 10.f * std::log10(hopEnergy / kHopFrames) : kSilenceFloorDb;
+
+  for (uint32_t i = 0; i < kWindowFrames; ++i) {
+    windowed_[i] = speaker.history[i] * window_[i];
+  }
+  fft_->ForwardRealToComplex(windowed_.data(), spectrum_.data());
+
+  float bands[kTRTCVisemeBands] = {};
+  float total = 0.f;
+  float weightedHz = 0.f;
+  uint32_t bin = kFirstBin;
+  for (uint32_t band = 0; band < kTRTCVisemeBands; ++band) {
+    for (; bin < kBandEnd[band]; ++bin) {
+      const float re = spectrum_[2 * bin];
+      const float im = spectrum_[2 * bin + 1];
+      const float power = re * re + im * im;
+      bands[band] += power;
+      weightedHz += power * bin * kBinHz;
+    }
+    total += bands[band];
+  }
+
+  TRTCVisemeFeatures& features = speaker.features;
+  features.energyDb = std::max(energyDb, kSilenceFloorDb);
+  features.centroidHz = total > 0.f ? weightedHz / total : 0.f;
+  for (uint32_t band = 0; band < kTRTCVisemeBands; ++band) {
+    features.bands[band] = total > 0.f ? bands[band] / total : 0.f;
+  }
+
+  // How much of a voice there is, from nothing at `silenceDb` to full at `speechDb`. Quiet voicing reads as closed
+  // lips, louder voicing is split between the shapes by where its energy sits.
+  const float range = std::max(config_.speechDb - config_.silenceDb, 1.f);
+  const float loudness = std::min(std::max((energyDb - config_.silenceDb) / range, 0.f), 1.f);
+  const float* share = features.bands;
+  float target[kTRTCVisemeCount] = {};
+  if (loudness <= 0.f || total <= 0.f) {
+    target[index(TRTCViseme::Silence)] = 1.f;
+  } else {
+    const float voiced = loudness * loudness;
+    target[index(TRTCViseme::Closed)] = 1.f - voiced;
+    target[index(TRTCViseme::Round)] = voiced * share[0];
+    target[index(TRTCViseme::Open)] = voiced * share[1];
+    target[index(TRTCViseme::Spread)] = voiced * share[2];
+    target[index(TRTCViseme::Fricative)] = voiced * share[3];
+  }
+  const float openTarget = loudness * (share[1] + 0.6f * share[0] + 0.5f * share[2] + 0.3f * share[3]);
+  features.mouthOpen = approach(features.mouthOpen, openTarget, config_.attack, config_.release);
+
+  uint32_t best = 0;
+  for (uint32_t i = 0; i < kTRTCVisemeCount; ++i) {
+    features.weights[i] = approach(features.weights[i], target[i], config_.attack, config_.release);
+    if (features.weights[i] > features.weights[best]) {
+      best = i;
+    }
+  }
+  features.viseme = static_cast<TRTCViseme>(best);
+  ++features.sequence;
+}
+
+void TRTCVisemeAnalyzer::forgetIdle(double now) {
+  for (auto it = speakers_.begin(); it != speakers_.end();) {
+    if (now - it->second->lastAudio > config_.forgetSeconds) {
+      FScopeLock lock(&mutex_);
+      published_.erase(it->first);
+      it = speakers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+TRTCVisemeFeatures TRTCVisemeAnalyzer::current(const Published& published, double now) const {
+  if (now - published.updated <= config_.staleSeconds) {
+    return published.features;
+  }
+  TRTCVisemeFeatures silent;
+  silent.sequence = published.features.sequence;
+  return silent;
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,36 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCVisemeComponent.h"
+
+using liteav::ue::TRTCViseme;
+
+UTRTCVisemeComponent::UTRTCVisemeComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer) {
+  PrimaryComponentTick.bCanEverTick = true;
+  PrimaryComponentTick.TickGroup = TG_PrePhysics;
+}
+
+void UTRTCVisemeComponent::SetSource(liteav::ue::TRTCVisemeAnalyzer* InAnalyzer, const FString& UserId) {
+  Analyzer = InAnalyzer;
+  SourceUserId = TCHAR_TO_UTF8(*UserId);
+  Frame = FTRTCVisemeFrame();
+}
+
+void UTRTCVisemeComponent::TickComponent(float DeltaTime,
+                                         ELevelTick TickType,
+                                         FActorComponentTickFunction* ThisTickFunction) {
+  Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+  liteav::ue::TRTCVisemeFeatures Features;
+  if (!Analyzer || SourceUserId.empty() || !Analyzer->latest(SourceUserId.c_str(), Features)) {
+    Frame = FTRTCVisemeFrame();
+    return;
+  }
+  auto Weight = [&Features](TRTCViseme Viseme) { return Features.weights[static_cast<uint32>(Viseme)]; };
+  Frame.Viseme = static_cast<ETRTCViseme>(Features.viseme);
+  Frame.MouthOpen = Features.mouthOpen;
+  Frame.EnergyDb = Features.energyDb;
+  Frame.Closed = Weight(TRTCViseme::Closed);
+  Frame.Open = Weight(TRTCViseme::Open);
+  Frame.Round = Weight(TRTCViseme::Round);
+  Frame.Spread = Weight(TRTCViseme::Spread);
+  Frame.Fricative = Weight(TRTCViseme::Fricative);
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCVoiceComponent.h"
+
+#include "GameFramework/Actor.h"
+
+UTRTCVoiceComponent::UTRTCVoiceComponent(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer), Buffer(std::make_shared<liteav::ue::TRTCAudioJitterBuffer>()) {
+  NumChannels = 1;
+  bAllowSpatialization = true;
+}
+
+void UTRTCVoiceComponent::SetSource(liteav::ue::TRTCVoiceRouter* InRouter, const FString& UserId) {
+  if (Router && !RoutedUserId.empty()) {
+    Router->unroute(RoutedUserId.c_str(), Buffer.get());
+  }
+  Buffer->reset();
+  Router = InRouter;
+  RoutedUserId = TCHAR_TO_UTF8(*UserId);
+  if (Router && !RoutedUserId.empty()) {
+    Router->route(RoutedUserId.c_str(), Buffer);
+  }
+}
+
+UTRTCVoiceComponent* UTRTCVoiceComponent::CreateForActor(AActor* Owner,
+                                                         liteav::ue::TRTCVoiceRouter* InRouter,
+                                                         const FString& UserId) {
+  if (!Owner) {
+    return nullptr;
+  }
+  UTRTCVoiceComponent* Component = NewObject<UTRTCVoiceComponent>(Owner);
+  if (USceneComponent* Root = Owner->GetRootComponent()) {
+    Component->SetupAttachment(Root);
+  }
+  Component->RegisterComponent();
+  Component->SetSource(InRouter, UserId);
+  Component->Start();
+  return Component;
+}
+
+bool UTRTCVoiceComponent::Init(int32& SampleRate) {
+  OutputSampleRate = SampleRate;
+  NumChannels = 1;
+  return true;
+}
+
+int32 UTRTCVoiceComponent::OnGenerateAudio(float* OutAudio, int32 NumSamples) {
+  Buffer->pop(OutAudio, static_cast<uint32>(NumSamples), static_cast<uint32>(OutputSampleRate));
+  return NumSamples;
+}
+
+void UTRTCVoiceComponent::OnUnregister() {
+  SetSource(nullptr, FString());
+  Super::OnUnregister();
+}
@@ -0,0 +1,268 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCVoiceProcessor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace liteav {
+namespace ue {
+
+namespace {
+
+constexpr uint32_t kControlSamples = 32;
+constexpr uint32_t kBudgetStrikes = 3;
+constexpr double kBudgetBypassSeconds = 2.0;
+// Keeps the recursive filter state out of denormals on silence; far below 16-bit resolution.
+constexpr float kAntiDenormal = 1e-20f;
+constexpr float kAgcSpeechFloorDb = -50.f;
+constexpr float kAgcDbPerSecond = 6.f;
+
+struct Biquad {
+  float b0 = 1.f;
+  float b1 = 0.f;
+  float b2 = 0.f;
+  float a1 = 0.f;
+  float a2 = 0.f;
+};
+
+float dbToLinear(float db) {
+  return std::pow(10.f, db / 20.f);
+}
+
+// One-pole smoothing coefficient reaching 63% of a step in `ms`.
+float onePole(float ms, uint32_t sampleRate) {
+  return ms > 0.f ? std::exp(-1000.f / (ms * sampleRate)) : 0.f;
+}
+
+// Biquads of the RBJ audio EQ cookbook, normalised by a0.
+Biquad highPass(float frequencyHz, uint32_t sampleRate) {
+  const float w0 = 2.f * PI * std::min(frequencyHz, 0.45f * sampleRate) / sampleRate;
+  const float cosw = std::cos(w0);
+  const float alpha = std::sin(w0) / (2.f * 0.70710678f);
+  const float a0 = 1.f + alpha;
+  Biquad biquad;
+  biquad.b0 = (1.f + cosw) / 2.f / a0;
+  biquad.b1 = -(1.f + cosw) / a0;
+  biquad.b2 = biquad.b0;
+  biquad.a1 = -2.f * cosw / a0;
+  biquad.a2 = (1.f - alpha) / a0;
+  return biquad;
+}
+
+Biquad peaking(const TRTCVoiceEqBand& band, uint32_t sampleRate) {
+  const float w0 = 2.f * PI * std::min(band.frequencyHz, 0.45f * sampleRate) / sampleRate;
+  const float cosw = std::cos(w0);
+  const float alpha = std::sin(w0) / (2.f * std::max(band.q, 0.1f));
+  const float a = std::pow(10.f, band.gainDb / 40.f);
+  const float a0 = 1.f + alpha / a;
+  Biquad biquad;
+  biquad.b0 = (1.f + alpha * a) / a0;
+  biquad.b1 = -2.f * cosw / a0;
+  biquad.b2 = (1.f - alpha * a) / a0;
+  biquad.a1 = biquad.b1;
+  biquad.a2 = (1.f - alpha / a) / a0;
+  return biquad;
+}
+
+}  // namespace
+
+TRTCVoiceProcessor::TRTCVoiceProcessor() {
+  resetState();
+}
+
+void TRTCVoiceProcessor::setParams(const TRTCVoiceProcessorParams& params) {
+  params_[back_] = params;
+  back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kSlotMask;
+}
+
+TRTCVoiceProcessorStats TRTCVoiceProcessor::stats() const {
+  TRTCVoiceProcessorStats stats;
+  stats.processedFrames = processed_frames_.load(std::memory_order_relaxed);
+  stats.bypassedFrames = bypassed_frames_.load(std::memory_order_relaxed);
+  stats.budgetBypasses = budget_bypasses_.load(std::memory_order_relaxed);
+  stats.lastMicroseconds = last_microseconds_.load(std::memory_order_relaxed);
+  stats.gateOpen = gate_open_.load(std::memory_order_relaxed);
+  stats.agcGainDb = agc_gain_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void TRTCVoiceProcessor::processCapturedAudio(int16_t* pcm, uint32_t frames, uint32_t channels, uint32_t sampleRate) {
+  if (!pcm || frames == 0 || channels == 0 || channels > kMaxChannels || sampleRate == 0) {
+    return;
+  }
+  const bool fresh = (middle_.load(std::memory_order_acquire) & kFresh) != 0;
+  if (fresh) {
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kSlotMask;
+  }
+  if (fresh || sampleRate != sample_rate_) {
+    configure(fresh ? params_[front_] : active_, sampleRate);
+  }
+
+  const double now = FPlatformTime::Seconds();
+  if (now < bypass_until_) {
+    bypassed_frames_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const uint64_t start = FPlatformTime::Cycles64();
+  run(pcm, frames, channels);
+  const float microseconds =
+      static_cast<float>(FPlatformTime::GetSecondsPerCycle64() * (FPlatformTime::Cycles64() - start) * 1e6);
+
+  if (active_.cpuBudgetMicroseconds > 0.f && microseconds > active_.cpuBudgetMicroseconds) {
+    if (++over_budget_ >= kBudgetStrikes) {
+      over_budget_ = 0;
+      bypass_until_ = now + kBudgetBypassSeconds;
+      budget_bypasses_.fetch_add(1, std::memory_order_relaxed);
+      // The state is two seconds old when processing resumes; starting from rest avoids a click.
+      resetState();
+    }
+  } else {
+    over_budget_ = 0;
+  }
+  processed_frames_.fetch_add(1, std::memory_order_relaxed);
+  last_microseconds_.store(microseconds, std::memory_order_relaxed);
+  gate_open_.store(gate_hold_ > 0, std::memory_order_relaxed);
+  agc_gain_.store(agc_gain_db_, std::memory_order_relaxed);
+}
+
+void TRTCVoiceProcessor::configure(const TRTCVoiceProcessorParams& params, uint32_t sampleRate) {
+  active_ = params;
+  sample_rate_ = sampleRate;
+
+  // Lane 0 is the high-pass, lanes 1 to 3 the equalizer bands; unused lanes pass their input through.
+  Biquad sections[4];
+  if (params.highPassEnabled) {
+    sections[0] = highPass(params.highPassHz, sampleRate);
+  }
+  if (params.eqEnabled) {
+    for (uint32_t band = 0; band < kTRTCVoiceEqBands; ++band) {
+      if (params.eq[band].gainDb != 0.f) {
+        sections[band + 1] = peaking(params.eq[band], sampleRate);
+      }
+    }
+  }
+  float b0[4], b1[4], b2[4], a1[4], a2[4];
+  filtering_ = false;
+  for (uint32_t lane = 0; lane < 4; ++lane) {
+    const Biquad& section = sections[lane];
+    b0[lane] = section.b0;
+    b1[lane] = section.b1;
+    b2[lane] = section.b2;
+    a1[lane] = section.a1;
+    a2[lane] = section.a2;
+    filtering_ |= section.b0 != 1.f || section.b1 != 0.f || section.b2 != 0.f || section.a1 != 0.f ||
+                  section.a2 != 0.f;
+  }
+  b0_ = VectorLoad(b0);
+  b1_ = VectorLoad(b1);
+  b2_ = VectorLoad(b2);
+  a1_ = VectorLoad(a1);
+  a2_ = VectorLoad(a2);
+
+  envelope_attack_ = onePole(1.f, sampleRate);
+  envelope_release_ = onePole(60.f, sampleRate);
+  gate_open_level_ = dbToLinear(params.gateThresholdDb);
+  gate_floor_ = dbToLinear(-std::max(params.gateRangeDb, 0.f));
+  if (!params.gateEnabled) {
+    gate_gain_ = 1.f;
+    gate_hold_ = 0;
+  }
+  gate_attack_ = 1.f - onePole(2.f, sampleRate);
+  gate_release_ = 1.f - onePole(60.f, sampleRate);
+  gate_hold_samples_ = static_cast<uint32_t>(std::max(params.gateHoldMs, 0.f) * sampleRate / 1000.f);
+  dynamics_smoothing_ = 1.f - onePole(5.f, sampleRate);
+  agc_step_db_ = kAgcDbPerSecond * kControlSamples / sampleRate;
+  if (!params.agcEnabled) {
+    agc_gain_db_ = 0.f;
+  }
+  agc_gain_db_ = std::min(std::max(agc_gain_db_, -params.agcMaxGainDb), params.agcMaxGainDb);
+}
+
+void TRTCVoiceProcessor::resetState() {
+  for (Channel& channel : channels_) {
+    channel.s1 = VectorZero();
+    channel.s2 = VectorZero();
+    std::memset(channel.lanes, 0, sizeof(channel.lanes));
+  }
+  envelope_ = 0.f;
+  gate_hold_ = 0;
+  gate_gain_ = 1.f;
+  dynamics_gain_ = 1.f;
+  dynamics_target_ = 1.f;
+  control_phase_ = 0;
+}
+
+void TRTCVoiceProcessor::updateDynamics() {
+  const TRTCVoiceProcessorParams& params = active_;
+  if (!params.compressorEnabled && !params.agcEnabled) {
+    dynamics_target_ = 1.f;
+    return;
+  }
+  const float levelDb = 20.f * std::log10(std::max(envelope_, 1e-6f));
+  float gainDb = 0.f;
+  if (params.compressorEnabled && levelDb > params.compressorThresholdDb) {
+    gainDb += (params.compressorThresholdDb - levelDb) * (1.f - 1.f / std::max(params.compressorRatio, 1.f));
+  }
+  if (params.agcEnabled) {
+    const bool speech = params.gateEnabled ? gate_hold_ > 0 : levelDb > kAgcSpeechFloorDb;
+    if (speech) {
+      const float error = params.agcTargetDb - (levelDb + agc_gain_db_);
+      agc_gain_db_ += std::min(std::max(error, -agc_step_db_), agc_step_db_);
+      agc_gain_db_ = std::min(std::max(agc_gain_db_, -params.agcMaxGainDb), params.agcMaxGainDb);
+    }
+    gainDb += agc_gain_db_;
+  }
+  dynamics_target_ = dbToLinear(gainDb);
+}
+
+void TRTCVoiceProcessor::run(int16_t* pcm, uint32_t frames, uint32_t channels) {
+  const bool gating = active_.gateEnabled;
+  float samples[kMaxChannels];
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    int16_t* interleaved = pcm + static_cast<size_t>(frame) * channels;
+    float peak = 0.f;
+    for (uint32_t c = 0; c < channels; ++c) {
+      float x = interleaved[c] * (1.f / 32768.f);
+      if (filtering_) {
+        // Section k works on the sample section k - 1 produced one step earlier, so all four advance in one step.
+        Channel& state = channels_[c];
+        state.lanes[0] = x + kAntiDenormal;
+        const VectorRegister4Float in = VectorLoadAligned(state.lanes);
+        const VectorRegister4Float out = VectorMultiplyAdd(b0_, in, state.s1);
+        state.s1 = VectorSubtract(VectorMultiplyAdd(b1_, in, state.s2), VectorMultiply(a1_, out));
+        state.s2 = VectorSubtract(VectorMultiply(b2_, in), VectorMultiply(a2_, out));
+        VectorStore(out, state.lanes + 1);
+        x = state.lanes[4];
+      }
+      samples[c] = x;
+      peak = std::max(peak, std::abs(x));
+    }
+
+    envelope_ = peak + (peak > envelope_ ? envelope_attack_ : envelope_release_) * (envelope_ - peak);
+    if (gating) {
+      if (envelope_ >= gate_open_level_) {
+        gate_hold_ = gate_hold_samples_ + 1;
+      } else if (gate_hold_ > 0) {
+        --gate_hold_;
+      }
+      const float target = gate_hold_ > 0 ? 1.f : gate_floor_;
+      gate_gain_ += (target - gate_gain_) * (target > gate_gain_ ? gate_attack_ : gate_release_);
+    }
+    if (control_phase_ == 0) {
+      updateDynamics();
+    }
+    control_phase_ = (control_phase_ + 1) % kControlSamples;
+    dynamics_gain_ += (dynamics_target_ - dynamics_gain_) * dynamics_smoothing_;
+
+    const float gain = gate_gain_ * dynamics_gain_ * 32768.f;
+    for (uint32_t c = 0; c < channels; ++c) {
+      const float value = samples[c] * gain;
+      interleaved[c] = static_cast<int16_t>(std::min(32767.f, std::max(-32768.f, value)));
+    }
+  }
+}
+
+}  // namespace ue
+}  // namespace liteav
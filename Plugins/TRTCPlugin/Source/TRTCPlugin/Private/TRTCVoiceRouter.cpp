@@ -0,0 +1,52 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#include "TRTCVoiceRouter.h"
+
+namespace liteav {
+namespace ue {
+
+void TRTCVoiceRouter::route(const char* userId, std::shared_ptr<TRTCAudioJitterBuffer> buffer) {
+  if (!userId || !buffer) {
+    return;
+  }
+  FWriteScopeLock lock(lock_);
+  routes_[userId] = std::move(buffer);
+}
+
+void TRTCVoiceRouter::unroute(const char* userId, const TRTCAudioJitterBuffer* buffer) {
+  if (!userId) {
+    return;
+  }
+  // The buffer may be released here; its owner keeps it alive while it is still being played.
+  std::shared_ptr<TRTCAudioJitterBuffer> released;
+  FWriteScopeLock lock(lock_);
+  auto it = routes_.find(userId);
+  if (it != routes_.end() && (!buffer || it->second.get() == buffer)) {
+    released = std::move(it->second);
+    routes_.erase(it);
+  }
+}
+
+TRTCAudioConsumerOptions TRTCVoiceRouter::consumerOptions() {
+  TRTCAudioConsumerOptions options;
+  options.sources = TRTCAudioSource_Remote;
+  options.format.channels = 1;
+  options.format.sampleType = TRTCAudioSampleType::Float32;
+  options.delivery = TRTCAudioDelivery::Inline;
+  return options;
+}
+
+void TRTCVoiceRouter::onAudioBlock(const TRTCAudioBlock& block) {
+  if (block.source != TRTCAudioSource_Remote || block.channels != 1 ||
+      block.sampleType != TRTCAudioSampleType::Float32) {
+    return;
+  }
+  FReadScopeLock lock(lock_);
+  auto it = routes_.find(block.userId);
+  if (it != routes_.end()) {
+    it->second->push(block.floatSamples(), block.frames, block.sampleRate);
+  }
+}
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,155 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+#include "TRTCCloudHeaderBase.h"
+
+namespace liteav {
+namespace ue {
+
+// The four audio callbacks of `ITRTCAudioFrameCallback`, as bits so that a consumer can listen to several.
+enum TRTCAudioSource : uint8_t {
+  TRTCAudioSource_Captured = 1 << 0,
+  TRTCAudioSource_LocalProcessed = 1 << 1,
+  TRTCAudioSource_Remote = 1 << 2,
+  TRTCAudioSource_Mixed = 1 << 3,
+};
+
+enum class TRTCAudioSampleType : uint8_t {
+  Int16,
+  Float32,
+};
+
+// Format a consumer wants its audio in. Zero rate or channel count keeps what the SDK delivers.
+struct TRTCAudioFormat {
+  uint32_t sampleRate = 0;
+  uint32_t channels = 0;
+  TRTCAudioSampleType sampleType = TRTCAudioSampleType::Int16;
+
+  bool operator==(const TRTCAudioFormat& other) const {
+    return sampleRate == other.sampleRate && channels == other.channels && sampleType == other.sampleType;
+  }
+};
+
+//
+// One block of interleaved audio handed to a consumer. `data` is only valid during the call.
+//
+struct TRTCAudioBlock {
+  TRTCAudioSource source = TRTCAudioSource_Remote;
+  // Remote user of `TRTCAudioSource_Remote` blocks, empty otherwise.
+  const char* userId = "";
+  uint32_t sampleRate = 0;
+  uint32_t channels = 0;
+  TRTCAudioSampleType sampleType = TRTCAudioSampleType::Int16;
+  const void* data = nullptr;
+  uint32_t frames = 0;
+  uint64_t timestamp = 0;
+
+  const int16_t* int16Samples() const { return static_cast<const int16_t*>(data); }
+  const float* floatSamples() const { return static_cast<const float*>(data); }
+  size_t bytes() const {
+    return static_cast<size_t>(frames) * channels * (sampleType == TRTCAudioSampleType::Int16 ? 2 : 4);
+  }
+};
+
+enum class TRTCAudioDelivery : uint8_t {
+  // Called on the SDK audio thread. Only for consumers that return in microseconds and never block.
+  Inline,
+  // Copied into the consumer's bounded queue and delivered on a thread of its own.
+  Queued,
+};
+
+enum class TRTCAudioDropPolicy : uint8_t {
+  // A full queue rejects new blocks; the consumer sees every block up to the overflow.
+  DropNewest,
+  // A full queue makes the consumer skip the older half of its backlog, so it catches up with live audio.
+  DropOldest,
+};
+
+struct TRTCAudioConsumerOptions {
+  uint8_t sources = TRTCAudioSource_Remote;
+  TRTCAudioFormat format;
+  TRTCAudioDelivery delivery = TRTCAudioDelivery::Queued;
+  uint32_t queueBlocks = 64;
+  TRTCAudioDropPolicy dropPolicy = TRTCAudioDropPolicy::DropOldest;
+};
+
+struct TRTCAudioConsumerStats {
+  uint64_t delivered = 0;
+  uint64_t dropped = 0;
+};
+
+class TRTCPLUGIN_API TRTCAudioFrameConsumer {
+ public:
+  virtual ~TRTCAudioFrameConsumer() = default;
+  virtual void onAudioBlock(const TRTCAudioBlock& block) = 0;
+};
+
+//
+// Modifies captured audio in place, before the SDK encodes it. Runs on the SDK capture thread, so it must neither block
+// nor allocate.
+//
+class TRTCPLUGIN_API TRTCAudioFrameProcessor {
+ public:
+  virtual ~TRTCAudioFrameProcessor() = default;
+  virtual void processCapturedAudio(int16_t* pcm, uint32_t frames, uint32_t channels, uint32_t sampleRate) = 0;
+};
+
+//
+// The one `ITRTCAudioFrameCallback` of a cloud, fanning its audio out to any number of consumers.
+//
+// Every SDK frame is converted at most once per distinct format that consumers of its source asked for; consumers
+// asking for the same format share the conversion (resampling is linear interpolation within the block, meant for
+// analysis; consumers needing the exact audio ask for the delivered rate). Queued consumers get their own bounded
+// queue and delivery thread, so a slow consumer only ever loses its own blocks and never holds up the SDK thread or
+// the other consumers.
+//
+class TRTCPLUGIN_API TRTCAudioFrameHub : public ITRTCAudioFrameCallback {
+ public:
+  TRTCAudioFrameHub();
+  TRTCAudioFrameHub(const TRTCAudioFrameHub&) = delete;
+  TRTCAudioFrameHub& operator=(const TRTCAudioFrameHub&) = delete;
+  ~TRTCAudioFrameHub() override;
+
+  void addConsumer(TRTCAudioFrameConsumer* consumer, const TRTCAudioConsumerOptions& options);
+
+  /**
+   * Stop delivering to `consumer`. Inline calls in progress are waited for and blocks still queued are discarded, so
+   * the consumer can be destroyed right after.
+   */
+  void removeConsumer(TRTCAudioFrameConsumer* consumer);
+
+  TRTCAudioConsumerStats consumerStats(const TRTCAudioFrameConsumer* consumer) const;
+
+  /**
+   * Run `processor` on every raw captured frame before consumers see it (null removes it). Captured frames are only
+   * delivered after `setCapturedRawAudioFrameCallbackFormat`. A call in progress is waited for, so the previous
+   * processor can be destroyed right after.
+   */
+  void setCaptureProcessor(TRTCAudioFrameProcessor* processor);
+
+  // ITRTCAudioFrameCallback
+  void onCapturedRawAudioFrame(TRTCAudioFrame* frame) override;
+  void onLocalProcessedAudioFrame(TRTCAudioFrame* frame) override;
+  void onPlayAudioFrame(TRTCAudioFrame* frame, const char* userId) override;
+  void onMixedPlayAudioFrame(TRTCAudioFrame* frame) override;
+
+ private:
+  class Consumer;
+
+  void dispatch(TRTCAudioSource source, TRTCAudioFrame* frame, const char* userId);
+
+  mutable FRWLock lock_;
+  std::vector<std::unique_ptr<Consumer>> consumers_;
+  TRTCAudioFrameProcessor* capture_processor_ = nullptr;
+};
+
+}  // namespace ue
+}  // namespace liteav
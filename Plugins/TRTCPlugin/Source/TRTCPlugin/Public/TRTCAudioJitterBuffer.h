@@ -0,0 +1,78 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "CoreMinimal.h"
+
+namespace liteav {
+namespace ue {
+
+struct TRTCAudioJitterConfig {
+  // Buffered audio the reader steers towards; absorbs the burstiness of SDK frame delivery.
+  uint32_t targetLatencyMs = 60;
+  // Audio beyond this is skipped by the reader so that latency stays bounded after stalls.
+  uint32_t maxLatencyMs = 200;
+  // Largest deviation from the nominal resampling ratio used to track clock drift (0.005 = 0.5%, inaudible).
+  float maxDriftCorrection = 0.005f;
+};
+
+struct TRTCAudioJitterStats {
+  uint64_t underruns = 0;
+  // Input blocks dropped because the ring was full, and input samples skipped to bound latency.
+  uint64_t droppedBlocks = 0;
+  uint64_t skippedSamples = 0;
+};
+
+//
+// Single-producer single-consumer mono audio buffer between an SDK callback thread and an audio render thread.
+//
+// The producer appends mono float samples to a ring; the consumer resamples them to the output rate with linear
+// interpolation. The resampling ratio is nudged in proportion to how far the smoothed fill level is from the target,
+// which absorbs the drift between the sender's clock and the local audio device without audible pitch change or
+// periodic glitches. Neither side takes locks or allocates after construction.
+//
+class TRTCPLUGIN_API TRTCAudioJitterBuffer {
+ public:
+  explicit TRTCAudioJitterBuffer(const TRTCAudioJitterConfig& config = TRTCAudioJitterConfig());
+  TRTCAudioJitterBuffer(const TRTCAudioJitterBuffer&) = delete;
+  TRTCAudioJitterBuffer& operator=(const TRTCAudioJitterBuffer&) = delete;
+
+  /**
+   * Producer side: append `frames` mono samples at `sampleRate`. The block is dropped whole if it does not fit.
+   */
+  void push(const float* mono, uint32_t frames, uint32_t sampleRate);
+
+  // Producer side: discard everything buffered, for example when the buffer is handed to another speaker.
+  void reset() { reset_requested_.store(true, std::memory_order_release); }
+
+  /**
+   * Consumer side: write `frames` mono samples at `outputSampleRate`. Outputs silence while buffering up to the
+   * target after an underrun, and for a zero `outputSampleRate`, which consumes nothing.
+   */
+  void pop(float* out, uint32_t frames, uint32_t outputSampleRate);
+
+  TRTCAudioJitterStats stats() const;
+
+ private:
+  const TRTCAudioJitterConfig config_;
+  std::unique_ptr<float[]> ring_;
+  uint32_t mask_ = 0;
+  alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64_t> write_{0};
+  std::atomic<uint32_t> input_rate_{48000};
+  alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64_t> read_{0};
+  std::atomic<bool> reset_requested_{false};
+  // Consumer state.
+  double phase_ = 0;
+  double smoothed_fill_ = 0;
+  bool priming_ = true;
+  std::atomic<uint64_t> underruns_{0};
+  std::atomic<uint64_t> dropped_blocks_{0};
+  std::atomic<uint64_t> skipped_samples_{0};
+};
+
+}  // namespace ue
+}  // namespace liteav
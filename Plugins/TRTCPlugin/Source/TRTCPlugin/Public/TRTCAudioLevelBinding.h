@@ -0,0 +1,94 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "TRTCRoster.h"
+#include "UObject/GCObject.h"
+
+class UMaterialParameterCollectionInstance;
+class UTexture2D;
+
+namespace liteav {
+namespace ue {
+
+struct TRTCAudioLevelConfig {
+  // Roster slots published; users in higher slots are left out. This is the width of the level texture.
+  uint32_t slots = 256;
+  // Time constants of the level smoothing when the volume rises and when it falls.
+  float attackSeconds = 0.05f;
+  float releaseSeconds = 0.3f;
+};
+
+//
+// Publishes the voice level of every user of a `TRTCRoster` to materials, once per tick for the whole room.
+//
+// Levels are smoothed per roster slot and written into a `slots` x 1 texture in one upload, which is skipped when
+// nothing changed (a silent room costs no GPU traffic). Texel `slot` holds the smoothed level in red, the speaking flag
+// in green, the raw reported volume in blue and whether the slot is occupied in alpha, so a material samples
+// `(slot + 0.5) / slots` with a point sampler. Optionally the levels of the first slots are also packed four per
+// vector parameter into a material parameter collection, for materials that cannot take a texture parameter.
+//
+// Slots come from `TRTCRoster::slot` and are stable while the user is in the room. Game thread only; tick it right
+// after the roster.
+//
+class TRTCPLUGIN_API TRTCAudioLevelBinding : public FGCObject {
+ public:
+  TRTCAudioLevelBinding(const TRTCRoster& roster, const TRTCAudioLevelConfig& config = TRTCAudioLevelConfig());
+  TRTCAudioLevelBinding(const TRTCAudioLevelBinding&) = delete;
+  TRTCAudioLevelBinding& operator=(const TRTCAudioLevelBinding&) = delete;
+  ~TRTCAudioLevelBinding() override;
+
+  UTexture2D* texture() const { return texture_; }
+
+  /**
+   * Also write the levels of slots [0, 4 * `vectorCount`) to `collection`, slot `4 * i + c` into component `c` of the
+   * vector parameter `<prefix><i>` (`Levels0`, `Levels1`, ... with the default prefix). Parameters missing from the
+   * collection are ignored. Pass nullptr to stop.
+   */
+  void bindCollection(UMaterialParameterCollectionInstance* collection,
+                      uint32_t vectorCount,
+                      const FString& prefix = TEXT("Levels"));
+
+  // Smooth the levels over `deltaSeconds` and publish them.
+  void tick(float deltaSeconds);
+
+  // Smoothed level of `slot`, from 0 to 1.
+  float level(uint32_t slot) const { return slot < levels_.size() ? levels_[slot] : 0.f; }
+
+  // FGCObject
+  void AddReferencedObjects(FReferenceCollector& collector) override;
+  FString GetReferencerName() const override;
+
+ private:
+  // Texels of one upload. Shared with the render thread until the upload completes.
+  struct Staging {
+    std::vector<FColor> texels;
+    std::atomic<bool> uploading{false};
+  };
+
+  void publishTexture();
+  void publishCollection();
+
+  const TRTCRoster& roster_;
+  const TRTCAudioLevelConfig config_;
+  UTexture2D* texture_ = nullptr;
+  TWeakObjectPtr<UMaterialParameterCollectionInstance> collection_;
+  std::vector<FName> parameter_names_;
+
+  std::vector<float> levels_;
+  std::vector<FColor> texels_;
+  // Volume, speaking flag and occupancy of each slot in this tick, laid out like the texels.
+  std::vector<FColor> reported_;
+  std::shared_ptr<Staging> staging_;
+  bool texture_dirty_ = true;
+  bool collection_dirty_ = false;
+};
+
+}  // namespace ue
+}  // namespace liteav
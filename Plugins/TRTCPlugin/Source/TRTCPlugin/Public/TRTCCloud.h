@@ -268,16 +268,19 @@ class TRTCPLUGIN_API TRTCCloud {
      * - The same user can push a stream in only one `TRTCCloud` instance at any time. If streams are pushed simultaneously in different rooms, a status mess will be caused in the cloud, leading to various bugs.
      * - The `TRTCCloud` instance created by the `createSubCloud` API cannot call APIs related to the local audio/video in the subinstance, except `switchRole`, `muteLocalVideo`, and `muteLocalAudio`. To use APIs such as the beauty filter, please use
      * the original `TRTCCloud` instance object.
-     * @return `TRTCCloud` subinstance
+     * - Every subinstance has its own event callbacks (`addCallback`) and render/audio frame callbacks, so a separate `TRTCVideoFrameHub` can be attached to each
+     * of them to route their frames independently.
+     * @return `TRTCCloud` subinstance, owned by the caller until it is passed to `destroySubCloud`; nullptr if the SDK could not create one.
      */
-    // ITRTCCloud* createSubCloud();
+    TRTCCloud* createSubCloud();
 
     /**
      * 2.10 Terminate room subinstance
      *
-     * @param subCloud
+     * Releases the SDK subinstance and deletes the `subCloud` wrapper. Remove its callbacks and detach any `TRTCVideoFrameHub` attached to it first.
+     * @param subCloud Subinstance returned by `createSubCloud` on this instance.
      */
-    // void destroySubCloud(ITRTCCloud* subCloud);
+    void destroySubCloud(TRTCCloud* subCloud);
 
     /////////////////////////////////////////////////////////////////////////////////
     //
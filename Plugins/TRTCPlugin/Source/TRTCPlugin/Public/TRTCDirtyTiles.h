@@ -0,0 +1,70 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "Engine/Texture2D.h"
+#include "TRTCFrameView.h"
+
+namespace liteav {
+namespace ue {
+
+//
+// Finds the parts of a frame that changed since the previous one, so that mostly static streams such as screen shares
+// upload only those into their texture.
+//
+// Frames are cut into square tiles whose contents are hashed (four 32-bit lanes per 16 bytes, on the engine's vector
+// intrinsics, rows split across workers for large frames) and compared with the hashes of the previous frame. Changed
+// tiles are merged into horizontal runs, and runs spanning the same columns on consecutive tile rows into one region.
+// The first frame, a change of size or format, or a frame where more than `fullUploadRatio` of the tiles changed asks
+// for a full upload instead, which is cheaper than many small regions.
+//
+// Interleaved formats only. Regions assume the texture holds the previous frame passed here: call `reset` whenever
+// it does not, e.g. after recreating it or uploading another frame.
+//
+class TRTCPLUGIN_API TRTCDirtyTiles {
+ public:
+  static constexpr uint32_t kDefaultTileSize = 64;
+
+  explicit TRTCDirtyTiles(uint32_t tileSize = kDefaultTileSize, float fullUploadRatio = 0.5f);
+
+  /**
+   * Compare `view` with the previous frame and remember it for the next call.
+   *
+   * @param regions Receives the changed regions, in pixels, with their source offsets set to the same position in
+   *                `view`. Empty when nothing changed.
+   * @return false if the whole frame should be uploaded; `regions` is then empty.
+   */
+  bool diff(const TRTCFrameView& view, std::vector<FUpdateTextureRegion2D>* regions);
+
+  // Forget the previous frame; the next `diff` asks for a full upload.
+  void reset() { valid_ = false; }
+
+  // Tiles per frame, and tiles found changed by the latest `diff`.
+  uint32_t tileCount() const { return columns_ * rows_; }
+  uint32_t changedTiles() const { return changed_; }
+
+ private:
+  void hashRows(const TRTCFrameView& view, uint32_t rowBegin, uint32_t rowEnd);
+
+  const uint32_t tile_size_;
+  const float full_upload_ratio_;
+
+  bool valid_ = false;
+  TRTCVideoPixelFormat format_ = TRTCVideoPixelFormat_Unknown;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  uint32_t columns_ = 0;
+  uint32_t rows_ = 0;
+  uint32_t changed_ = 0;
+  // Hash of each pixel row's segment in each tile column, row major; folded into `tile_hashes_` per tile.
+  std::vector<uint64_t> segment_hashes_;
+  std::vector<uint64_t> tile_hashes_;
+  std::vector<uint8_t> dirty_;
+};
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,196 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "TRTCCloud.h"
+#include "TRTCRoster.h"
+
+namespace liteav {
+namespace ue {
+
+// What is received from one remote user, in increasing cost.
+enum class TRTCDownlinkLevel : uint8_t {
+  Off,
+  AudioOnly,
+  Small,
+  Big,
+  Count,
+};
+
+constexpr uint32_t kTRTCDownlinkLevelCount = static_cast<uint32_t>(TRTCDownlinkLevel::Count);
+
+struct TRTCDownlinkConfig {
+  // Fixed downlink budget; zero estimates it from `onStatistics` and `onNetworkQuality`, starting at
+  // `initialBudgetKbps` and staying within [`minBudgetKbps`, `maxBudgetKbps`].
+  uint32_t budgetKbps = 0;
+  uint32_t initialBudgetKbps = 2000;
+  uint32_t minBudgetKbps = 300;
+  uint32_t maxBudgetKbps = 10000;
+
+  // Cost of each level until the statistics measured the user's actual bitrates.
+  uint32_t audioKbps = 40;
+  uint32_t smallKbps = 150;
+  uint32_t bigKbps = 900;
+
+  // Priority of a user is 1, plus `pinnedWeight` when pinned, plus `speakerWeight / (1 + rank)` for the
+  // `speakerRanks` most recent speakers of the last `speakerMemorySeconds`.
+  float pinnedWeight = 4.f;
+  float speakerWeight = 3.f;
+  uint32_t speakerRanks = 8;
+  double speakerMemorySeconds = 30.0;
+  // Video is only worth receiving for users shown on screen (or pinned), and the big stream only for users shown at
+  // least `bigMinAreaPixels` large; its value grows with the area, up to four times that size, scaled by `areaWeight`.
+  uint32_t bigMinAreaPixels = 320 * 180;
+  float areaWeight = 2.f;
+  // Bonus on the value of the level a user currently receives, so that near ties do not flap.
+  float stickiness = 0.25f;
+
+  // Rate limits of the SDK calls: a user is upgraded at most once per `minSwitchSeconds`, and at most
+  // `maxChangesPerSecond` users change level per second. Downgrades skip the per-user limit so the budget holds.
+  double minSwitchSeconds = 2.0;
+  uint32_t maxChangesPerSecond = 8;
+};
+
+struct TRTCDownlinkStats {
+  uint32_t budgetKbps = 0;
+  // Expected bitrate of the allocated levels.
+  uint32_t allocatedKbps = 0;
+  // Receive rate from the latest statistics.
+  uint32_t measuredKbps = 0;
+  // Users allocated each level.
+  uint32_t users[kTRTCDownlinkLevelCount] = {};
+  uint64_t solves = 0;
+  uint64_t changes = 0;
+  // Level changes held back by the rate limits, counted once each however many ticks they wait.
+  uint64_t deferred = 0;
+};
+
+//
+// Shares one downlink budget between the remote users of a room by choosing, per user, between the big stream, the
+// small stream, audio only, or nothing.
+//
+// The choice maximises the priority-weighted value of what is received within the budget: a greedy multiple-choice
+// knapsack that repeatedly grants the upgrade with the best value per kbps that still fits, which receives audio from
+// nearly everybody before any video, and big streams only where they are shown large. Costs are learnt per user from
+// `onStatistics`. The allocation is only solved again when an input changed: a user entered, left or started
+// speaking, the availability of their streams, their pin or screen area, or the budget moved by more than 5%. Changes
+// are applied with `muteRemoteAudio`, `muteRemoteVideoStream` and `setRemoteVideoStreamType`, downgrades first and
+// within the rate limits of the configuration.
+//
+// Add the allocator as a callback of the cloud; statistics are queued and applied by `tick()`, which runs on the game
+// thread right after the roster's. Views still have to be started by the application.
+//
+class TRTCPLUGIN_API TRTCDownlinkAllocator : public ITRTCCloudCallback {
+ public:
+  TRTCDownlinkAllocator(TRTCCloud& cloud,
+                        const TRTCRoster& roster,
+                        const TRTCDownlinkConfig& config = TRTCDownlinkConfig());
+  TRTCDownlinkAllocator(const TRTCDownlinkAllocator&) = delete;
+  TRTCDownlinkAllocator& operator=(const TRTCDownlinkAllocator&) = delete;
+  ~TRTCDownlinkAllocator() override;
+
+  // Pinned users rank higher and count as shown large.
+  void setPinned(TRTCUserHandle handle, bool pinned);
+  // Pixels covered by the user's video on screen, summed over the places showing it; zero when not shown.
+  void setScreenArea(TRTCUserHandle handle, uint32_t pixels);
+  // Fix the budget, or go back to estimating it with zero.
+  void setBudgetKbps(uint32_t kbps);
+
+  void tick();
+
+  // Level allocated to the user, which may not be applied yet.
+  TRTCDownlinkLevel level(TRTCUserHandle handle) const;
+
+  TRTCDownlinkStats stats() const { return stats_; }
+
+  // ITRTCCloudCallback
+  void onError(TXLiteAVError /*errCode*/, const char* /*errMsg*/, void* /*extraInfo*/) override {}
+  void onWarning(TXLiteAVWarning /*warningCode*/, const char* /*warningMsg*/, void* /*extraInfo*/) override {}
+  void onEnterRoom(int /*result*/) override {}
+  void onExitRoom(int /*reason*/) override {}
+  void onNetworkQuality(TRTCQualityInfo localQuality,
+                        TRTCQualityInfo* remoteQuality,
+                        uint32_t remoteQualityCount) override;
+  void onStatistics(const TRTCStatistics& statistics) override;
+
+ private:
+  // Level of a user whose SDK state is unknown, so every call is issued on its first change.
+  static constexpr uint8_t kUnapplied = 0xFF;
+
+  struct User {
+    TRTCUserHandle handle = kTRTCInvalidUserHandle;
+    uint8_t flags = 0;
+    bool pinned = false;
+    uint32_t area = 0;
+    double lastSpoke = -1e9;
+    uint32_t rank = 0xFFFFFFFFu;
+    // Learnt cost of each level in kbps, zero until measured.
+    float measuredKbps[kTRTCDownlinkLevelCount] = {};
+    float priority = 1.f;
+    TRTCDownlinkLevel target = TRTCDownlinkLevel::Off;
+    uint8_t applied = kUnapplied;
+    double lastChange = -1e9;
+    // The change to `target` has been held back and counted in the stats.
+    bool deferred = false;
+  };
+
+  struct RemoteBitrate {
+    std::string userId;
+    TRTCVideoStreamType streamType;
+    uint32_t videoKbps;
+    uint32_t audioKbps;
+  };
+
+  struct PendingStatistics {
+    bool fresh = false;
+    uint64_t receivedBytes = 0;
+    uint32_t downLoss = 0;
+    double time = 0;
+    std::vector<RemoteBitrate> remotes;
+  };
+
+  User* userOf(TRTCUserHandle handle);
+  const User* userOf(TRTCUserHandle handle) const;
+  void syncUsers(double now);
+  void updateBudget();
+  float cost(const User& user, TRTCDownlinkLevel level) const;
+  void solve();
+  void apply(double now, float deltaSeconds);
+  void applyLevel(User& user, TRTCDownlinkLevel level, double now);
+
+  TRTCCloud& cloud_;
+  const TRTCRoster& roster_;
+  const TRTCDownlinkConfig config_;
+
+  // Indexed by roster slot.
+  std::vector<User> users_;
+  std::vector<uint32_t> speakers_;
+  std::vector<uint32_t> previous_speakers_;
+  // Slots whose allocated level is not applied yet.
+  std::vector<uint32_t> pending_;
+  bool dirty_ = true;
+  uint32_t fixed_budget_kbps_ = 0;
+  float budget_kbps_ = 0;
+  float solved_budget_kbps_ = 0;
+  float change_tokens_ = 0;
+  double last_tick_ = 0;
+
+  uint64_t last_received_bytes_ = 0;
+  double last_statistics_time_ = 0;
+  float measured_kbps_ = 0;
+
+  FCriticalSection mutex_;
+  PendingStatistics incoming_;
+  PendingStatistics draining_;
+  TRTCQuality quality_ = TRTCQuality_Unknown;
+
+  TRTCDownlinkStats stats_;
+};
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,71 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "TRTCFrameView.h"
+
+namespace liteav {
+namespace ue {
+
+//
+// Frame memory owned by the plugin. Every plane row is padded to `kTRTCFrameStrideAlignment` and the allocation
+// itself is aligned the same way.
+//
+class TRTCPLUGIN_API TRTCFrameBuffer {
+ public:
+  TRTCFrameBuffer(TRTCVideoPixelFormat format, uint32_t width, uint32_t height);
+  TRTCFrameBuffer(const TRTCFrameBuffer&) = delete;
+  TRTCFrameBuffer& operator=(const TRTCFrameBuffer&) = delete;
+  ~TRTCFrameBuffer();
+
+  const TRTCFrameView& view() const { return view_; }
+  TRTCVideoPixelFormat format() const { return view_.format; }
+  uint32_t width() const { return view_.width; }
+  uint32_t height() const { return view_.height; }
+  size_t size() const { return size_; }
+
+  uint64_t timestamp() const { return view_.timestamp; }
+  void setTimestamp(uint64_t timestamp) { view_.timestamp = timestamp; }
+
+ private:
+  uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  TRTCFrameView view_;
+};
+
+//
+// Thread-safe free list of frame buffers, bucketed by (format, width, height). Buffers handed out by `acquire` go
+// back to the pool when the last reference drops, so steady-state frame delivery does not touch the heap.
+//
+class TRTCPLUGIN_API TRTCFrameBufferPool {
+ public:
+  // `maxBuffersPerSize` bounds how many idle buffers of one size are kept; the rest are freed on release.
+  explicit TRTCFrameBufferPool(uint32_t maxBuffersPerSize = 4);
+  TRTCFrameBufferPool(const TRTCFrameBufferPool&) = delete;
+  TRTCFrameBufferPool& operator=(const TRTCFrameBufferPool&) = delete;
+  ~TRTCFrameBufferPool();
+
+  /**
+   * Take an idle buffer of the requested format and size, allocating one if none is available.
+   *
+   * The returned buffer may be released on any thread, including after the pool itself has been destroyed.
+   */
+  std::shared_ptr<TRTCFrameBuffer> acquire(TRTCVideoPixelFormat format, uint32_t width, uint32_t height);
+
+  // Free every idle buffer.
+  void trim();
+
+  // Bytes held by idle buffers.
+  size_t idleBytes() const;
+
+ private:
+  struct State;
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,150 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include "TRTCFrameView.h"
+
+namespace liteav {
+namespace ue {
+
+enum class TRTCDownscaleMode {
+  // Divide both dimensions by the largest power of two that keeps the frame at least as large as the display, using
+  // an exact box filter. Keeps texture sizes stable while the display size animates.
+  PowerOfTwo,
+  // Scale to the smallest size that still covers the display, preserving the aspect ratio, with a bilinear filter.
+  Exact,
+};
+
+/**
+ * Size a frame of `srcWidth` x `srcHeight` should be downscaled to before being shown at `displayWidth` x
+ * `displayHeight` pixels.
+ *
+ * Frames are never upscaled; an unknown (zero) display size keeps the source size. Results are rounded to even
+ * dimensions so that planar formats keep whole chroma samples.
+ * @param boxFactor Receives the box filter factor in `PowerOfTwo` mode, 1 otherwise.
+ */
+TRTCPLUGIN_API void computeDownscaleSize(TRTCDownscaleMode mode,
+                                         uint32_t srcWidth,
+                                         uint32_t srcHeight,
+                                         uint32_t displayWidth,
+                                         uint32_t displayHeight,
+                                         uint32_t* dstWidth,
+                                         uint32_t* dstHeight,
+                                         uint32_t* boxFactor);
+
+//
+// Per-format downscale kernels. Every plane is processed with its own channel count as a compile-time constant.
+//
+template <TRTCVideoPixelFormat Format>
+struct TRTCFrameScaler {
+  using Traits = TRTCPixelFormatTraits<Format>;
+
+  // `dst` must be exactly `src` divided by `factor` (rounded down) in both dimensions. Rows are destination rows.
+  static void boxDownscaleRows(const TRTCFrameView& src,
+                               const TRTCFrameView& dst,
+                               uint32_t factor,
+                               uint32_t rowBegin,
+                               uint32_t rowEnd) {
+    for (int plane = 0; plane < Traits::kPlaneCount; ++plane) {
+      const uint32_t first = Traits::planeHeight(plane, rowBegin);
+      const uint32_t last = Traits::planeHeight(plane, rowEnd);
+      if (plane == 0) {
+        boxPlane<Traits::planeBytesPerPixel(0)>(src, dst, plane, factor, first, last);
+      } else {
+        boxPlane<Traits::planeBytesPerPixel(1)>(src, dst, plane, factor, first, last);
+      }
+    }
+  }
+
+  static void bilinearRows(const TRTCFrameView& src, const TRTCFrameView& dst, uint32_t rowBegin, uint32_t rowEnd) {
+    for (int plane = 0; plane < Traits::kPlaneCount; ++plane) {
+      const uint32_t first = Traits::planeHeight(plane, rowBegin);
+      const uint32_t last = Traits::planeHeight(plane, rowEnd);
+      if (plane == 0) {
+        bilinearPlane<Traits::planeBytesPerPixel(0)>(src, dst, plane, first, last);
+      } else {
+        bilinearPlane<Traits::planeBytesPerPixel(1)>(src, dst, plane, first, last);
+      }
+    }
+  }
+
+ private:
+  template <uint32_t Channels>
+  static void boxPlane(const TRTCFrameView& src,
+                       const TRTCFrameView& dst,
+                       int plane,
+                       uint32_t factor,
+                       uint32_t rowBegin,
+                       uint32_t rowEnd) {
+    const uint32_t dstWidth = Traits::planeWidth(plane, dst.width);
+    const uint32_t area = factor * factor;
+    const uint32_t rounding = area / 2;
+    for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+      uint8_t* dstRow = dst.planes[plane] + static_cast<size_t>(y) * dst.strides[plane];
+      const uint8_t* srcBlock = src.planes[plane] + static_cast<size_t>(y) * factor * src.strides[plane];
+      for (uint32_t x = 0; x < dstWidth; ++x) {
+        uint32_t sums[Channels] = {};
+        const uint8_t* srcRow = srcBlock + static_cast<size_t>(x) * factor * Channels;
+        for (uint32_t dy = 0; dy < factor; ++dy) {
+          const uint8_t* pixel = srcRow;
+          for (uint32_t dx = 0; dx < factor; ++dx) {
+            for (uint32_t c = 0; c < Channels; ++c) {
+              sums[c] += pixel[c];
+            }
+            pixel += Channels;
+          }
+          srcRow += src.strides[plane];
+        }
+        for (uint32_t c = 0; c < Channels; ++c) {
+          dstRow[x * Channels + c] = static_cast<uint8_t>((sums[c] + rounding) / area);
+        }
+      }
+    }
+  }
+
+  template <uint32_t Channels>
+  static void bilinearPlane(const TRTCFrameView& src,
+                            const TRTCFrameView& dst,
+                            int plane,
+                            uint32_t rowBegin,
+                            uint32_t rowEnd) {
+    const uint32_t srcWidth = Traits::planeWidth(plane, src.width);
+    const uint32_t srcHeight = Traits::planeHeight(plane, src.height);
+    const uint32_t dstWidth = Traits::planeWidth(plane, dst.width);
+    // 16.16 fixed-point source step, sampling pixel centres.
+    const uint64_t stepX = (static_cast<uint64_t>(srcWidth) << 16) / dstWidth;
+    const uint64_t stepY = (static_cast<uint64_t>(srcHeight) << 16) / Traits::planeHeight(plane, dst.height);
+    for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+      const int64_t fy = std::max<int64_t>(0, static_cast<int64_t>(y * stepY + stepY / 2) - 0x8000);
+      const uint32_t y0 = std::min<uint32_t>(static_cast<uint32_t>(fy >> 16), srcHeight - 1);
+      const uint32_t y1 = std::min<uint32_t>(y0 + 1, srcHeight - 1);
+      const uint32_t wy = static_cast<uint32_t>(fy & 0xFFFF) >> 8;
+      const uint8_t* row0 = src.planes[plane] + static_cast<size_t>(y0) * src.strides[plane];
+      const uint8_t* row1 = src.planes[plane] + static_cast<size_t>(y1) * src.strides[plane];
+      uint8_t* dstRow = dst.planes[plane] + static_cast<size_t>(y) * dst.strides[plane];
+      for (uint32_t x = 0; x < dstWidth; ++x) {
+        const int64_t fx = std::max<int64_t>(0, static_cast<int64_t>(x * stepX + stepX / 2) - 0x8000);
+        const uint32_t x0 = std::min<uint32_t>(static_cast<uint32_t>(fx >> 16), srcWidth - 1);
+        const uint32_t x1 = std::min<uint32_t>(x0 + 1, srcWidth - 1);
+        const uint32_t wx = static_cast<uint32_t>(fx & 0xFFFF) >> 8;
+        for (uint32_t c = 0; c < Channels; ++c) {
+          const uint32_t top = row0[x0 * Channels + c] * (256 - wx) + row0[x1 * Channels + c] * wx;
+          const uint32_t bottom = row1[x0 * Channels + c] * (256 - wx) + row1[x1 * Channels + c] * wx;
+          dstRow[x * Channels + c] = static_cast<uint8_t>((top * (256 - wy) + bottom * wy + 32768) >> 16);
+        }
+      }
+    }
+  }
+};
+
+/**
+ * Downscale `src` into `dst`, which must have the same format. Identical sizes degrade to a copy.
+ *
+ * Frames above the `TRTCParallelRows` threshold are scaled in row bands on the task graph.
+ * @param boxFactor Factor from `computeDownscaleSize`; a factor above one selects the box filter.
+ * @return false if the views are invalid or their formats differ.
+ */
+TRTCPLUGIN_API bool scaleFrame(const TRTCFrameView& src, const TRTCFrameView& dst, uint32_t boxFactor);
+
+}  // namespace ue
+}  // namespace liteav
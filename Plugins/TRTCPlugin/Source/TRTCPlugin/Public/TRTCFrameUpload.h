@@ -0,0 +1,122 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "Engine/Texture2D.h"
+#include "TRTCFrameView.h"
+
+namespace liteav {
+namespace ue {
+
+//
+// Texture format matching each uploadable pixel layout. Planar formats have no texture format and must be converted
+// with `convertFrame` first.
+//
+template <TRTCVideoPixelFormat Format>
+struct TRTCTextureFormatTraits;
+
+template <>
+struct TRTCTextureFormatTraits<TRTCVideoPixelFormat_BGRA32> {
+  static constexpr EPixelFormat kPixelFormat = PF_B8G8R8A8;
+};
+
+template <>
+struct TRTCTextureFormatTraits<TRTCVideoPixelFormat_RGBA32> {
+  static constexpr EPixelFormat kPixelFormat = PF_R8G8B8A8;
+};
+
+template <TRTCVideoPixelFormat Format>
+struct TRTCFrameUploader {
+  using Traits = TRTCPixelFormatTraits<Format>;
+  static_assert(Traits::kPlaneCount == 1, "Only interleaved frames can be uploaded, convert planar frames first");
+
+  static UTexture2D* createTexture(uint32_t width, uint32_t height) {
+    UTexture2D* texture = UTexture2D::CreateTransient(width, height, TRTCTextureFormatTraits<Format>::kPixelFormat);
+    if (texture) {
+      texture->UpdateResource();
+    }
+    return texture;
+  }
+
+  /**
+   * Queues an upload of the whole view. The view memory must stay valid until `onUploaded` runs on the render thread.
+   * A texture without a resource drops the upload, and `onUploaded` then runs right away on the calling thread.
+   */
+  static void upload(UTexture2D* texture, const TRTCFrameView& view, TFunction<void()> onUploaded) {
+    // `UpdateTextureRegions` neither queues nor cleans up without a resource.
+    if (!texture->GetResource()) {
+      if (onUploaded) {
+        onUploaded();
+      }
+      return;
+    }
+    FUpdateTextureRegion2D* region = new FUpdateTextureRegion2D(0, 0, 0, 0, view.width, view.height);
+    texture->UpdateTextureRegions(0, 1, region, view.strides[0], Traits::kBytesPerPixel, view.planes[0],
+                                  [onUploaded = MoveTemp(onUploaded)](uint8*, const FUpdateTextureRegion2D* regions) {
+                                    delete regions;
+                                    if (onUploaded) {
+                                      onUploaded();
+                                    }
+                                  });
+  }
+
+  // Queues an upload of `count` regions of the view, each read from its source offset in the view. Same contract as
+  // `upload`; with no regions nothing is queued and `onUploaded` runs right away.
+  static void uploadRegions(UTexture2D* texture,
+                            const TRTCFrameView& view,
+                            const FUpdateTextureRegion2D* regions,
+                            uint32_t count,
+                            TFunction<void()> onUploaded) {
+    if (count == 0 || !texture->GetResource()) {
+      if (onUploaded) {
+        onUploaded();
+      }
+      return;
+    }
+    FUpdateTextureRegion2D* copies = new FUpdateTextureRegion2D[count];
+    std::copy(regions, regions + count, copies);
+    texture->UpdateTextureRegions(0, count, copies, view.strides[0], Traits::kBytesPerPixel, view.planes[0],
+                                  [onUploaded = MoveTemp(onUploaded)](uint8*, const FUpdateTextureRegion2D* regions) {
+                                    delete[] regions;
+                                    if (onUploaded) {
+                                      onUploaded();
+                                    }
+                                  });
+  }
+};
+
+/**
+ * Create a transient texture able to receive frames of `format` (one of the interleaved formats).
+ *
+ * @return nullptr if the format cannot be uploaded directly.
+ */
+TRTCPLUGIN_API UTexture2D* createFrameTexture(TRTCVideoPixelFormat format, uint32_t width, uint32_t height);
+
+/**
+ * Upload `view` into `texture`, which must have been created with the same format and size.
+ *
+ * @param onUploaded Invoked on the render thread once the view memory is no longer referenced, or right away if the
+ *                   texture has no resource to upload into.
+ * @return false if the view cannot be uploaded directly.
+ */
+TRTCPLUGIN_API bool uploadFrame(UTexture2D* texture, const TRTCFrameView& view, TFunction<void()> onUploaded = nullptr);
+
+/**
+ * Upload only `regions` of `view` into `texture`, e.g. the changed tiles found by `TRTCDirtyTiles`. Nothing is queued
+ * when `regions` is empty.
+ *
+ * @param onUploaded Invoked on the render thread once the view memory is no longer referenced, or right away if
+ *                   `regions` is empty or the texture has no resource to upload into.
+ * @return false if the view cannot be uploaded directly.
+ */
+TRTCPLUGIN_API bool uploadFrameRegions(UTexture2D* texture,
+                                       const TRTCFrameView& view,
+                                       const std::vector<FUpdateTextureRegion2D>& regions,
+                                       TFunction<void()> onUploaded = nullptr);
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,299 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "TRTCCloudHeaderBase.h"
+
+namespace liteav {
+namespace ue {
+
+//
+// Pixel format the plugin requests from the render callbacks. Android only delivers RGBA32 buffers, the other
+// platforms deliver BGRA32, and textures created for this format are uploaded without any swizzle.
+//
+#if PLATFORM_ANDROID
+constexpr TRTCVideoPixelFormat kTRTCNativePixelFormat = TRTCVideoPixelFormat_RGBA32;
+#else
+constexpr TRTCVideoPixelFormat kTRTCNativePixelFormat = TRTCVideoPixelFormat_BGRA32;
+#endif
+
+// Row pitch alignment of buffers owned by the plugin, so every row starts on a cache line and a full SIMD register.
+constexpr uint32_t kTRTCFrameStrideAlignment = 64;
+
+constexpr uint32_t alignFrameStride(uint32_t rowBytes) {
+  return (rowBytes + kTRTCFrameStrideAlignment - 1) & ~(kTRTCFrameStrideAlignment - 1);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//                    Pixel format traits
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+template <TRTCVideoPixelFormat Format>
+struct TRTCPixelFormatTraits;
+
+// Interleaved 8-bit four channel layouts; the indices give the byte offset of each channel inside a pixel.
+template <int Red, int Green, int Blue, int Alpha>
+struct TRTCPackedPixelTraits {
+  static constexpr int kPlaneCount = 1;
+  static constexpr uint32_t kBytesPerPixel = 4;
+  static constexpr int kRed = Red;
+  static constexpr int kGreen = Green;
+  static constexpr int kBlue = Blue;
+  static constexpr int kAlpha = Alpha;
+
+  static constexpr uint32_t planeWidth(int /*plane*/, uint32_t width) { return width; }
+  static constexpr uint32_t planeHeight(int /*plane*/, uint32_t height) { return height; }
+  static constexpr uint32_t planeBytesPerPixel(int /*plane*/) { return kBytesPerPixel; }
+};
+
+template <>
+struct TRTCPixelFormatTraits<TRTCVideoPixelFormat_BGRA32> : TRTCPackedPixelTraits<2, 1, 0, 3> {};
+
+template <>
+struct TRTCPixelFormatTraits<TRTCVideoPixelFormat_RGBA32> : TRTCPackedPixelTraits<0, 1, 2, 3> {};
+
+// Planar Y, U, V with both chroma planes subsampled by two in each direction.
+template <>
+struct TRTCPixelFormatTraits<TRTCVideoPixelFormat_I420> {
+  static constexpr int kPlaneCount = 3;
+
+  static constexpr uint32_t planeWidth(int plane, uint32_t width) { return plane == 0 ? width : (width + 1) / 2; }
+  static constexpr uint32_t planeHeight(int plane, uint32_t height) { return plane == 0 ? height : (height + 1) / 2; }
+  static constexpr uint32_t planeBytesPerPixel(int /*plane*/) { return 1; }
+};
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//                    Frame view
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+//
+// Non-owning description of a video image: format, plane pointers and per-plane row strides. A view never assumes a
+// tightly packed buffer, so the same routines work on SDK callback buffers and on padded buffers owned by the plugin.
+//
+struct TRTCPLUGIN_API TRTCFrameView {
+  TRTCVideoPixelFormat format = TRTCVideoPixelFormat_Unknown;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint8_t* planes[3] = {nullptr, nullptr, nullptr};
+  uint32_t strides[3] = {0, 0, 0};
+  // Capture timestamp in ms, as delivered in `TRTCVideoFrame::timestamp`.
+  uint64_t timestamp = 0;
+
+  bool isValid() const;
+
+  /**
+   * Describe the tightly packed buffer of an SDK render callback frame.
+   *
+   * @return An invalid view if the frame is not a memory buffer, has an unsupported pixel format, or its `length` is
+   * smaller than its dimensions require.
+   */
+  static TRTCFrameView fromVideoFrame(const TRTCVideoFrame& frame);
+
+  // Number of bytes needed to hold a frame of the given format and size with the given per-plane strides.
+  static size_t bufferSize(TRTCVideoPixelFormat format, uint32_t height, const uint32_t strides[3]);
+
+  // Stride of every plane of a plugin-owned buffer, padded to `kTRTCFrameStrideAlignment`.
+  static void alignedStrides(TRTCVideoPixelFormat format, uint32_t width, uint32_t strides[3]);
+
+  // Point the planes at consecutive regions of `base`, laid out with the current `format`, `height` and `strides`.
+  void assignPlanes(uint8_t* base);
+};
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//                    Copy and conversion routines
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+//
+// Copies rows of every plane between two views of the same format and size. Strides may differ on both sides.
+//
+// All kernels below work on a band of image rows [rowBegin, rowEnd) so that large frames can be split across worker
+// threads; bands must start on an even row so that subsampled chroma rows are never shared between two bands.
+//
+template <TRTCVideoPixelFormat Format>
+struct TRTCFrameCopier {
+  using Traits = TRTCPixelFormatTraits<Format>;
+
+  static void copy(const TRTCFrameView& src, const TRTCFrameView& dst) { copyRows(src, dst, 0, src.height); }
+
+  static void copyRows(const TRTCFrameView& src, const TRTCFrameView& dst, uint32_t rowBegin, uint32_t rowEnd) {
+    for (int plane = 0; plane < Traits::kPlaneCount; ++plane) {
+      const uint32_t rowBytes = Traits::planeWidth(plane, src.width) * Traits::planeBytesPerPixel(plane);
+      const uint32_t first = Traits::planeHeight(plane, rowBegin);
+      const uint32_t rows = Traits::planeHeight(plane, rowEnd) - first;
+      const uint8_t* srcRow = src.planes[plane] + static_cast<size_t>(first) * src.strides[plane];
+      uint8_t* dstRow = dst.planes[plane] + static_cast<size_t>(first) * dst.strides[plane];
+      if (src.strides[plane] == rowBytes && dst.strides[plane] == rowBytes) {
+        std::memcpy(dstRow, srcRow, static_cast<size_t>(rowBytes) * rows);
+        continue;
+      }
+      for (uint32_t row = 0; row < rows; ++row) {
+        std::memcpy(dstRow, srcRow, rowBytes);
+        srcRow += src.strides[plane];
+        dstRow += dst.strides[plane];
+      }
+    }
+  }
+};
+
+//
+// Converts a view of format `Src` into a view of format `Dst` with the same size. Every supported pair is a
+// specialisation, so the per-pixel loops are compiled for one fixed layout and carry no format branches.
+//
+template <TRTCVideoPixelFormat Src, TRTCVideoPixelFormat Dst>
+struct TRTCFrameConverter;
+
+template <TRTCVideoPixelFormat Format>
+struct TRTCFrameConverter<Format, Format> {
+  static void convert(const TRTCFrameView& src, const TRTCFrameView& dst) { TRTCFrameCopier<Format>::copy(src, dst); }
+
+  static void convertRows(const TRTCFrameView& src, const TRTCFrameView& dst, uint32_t rowBegin, uint32_t rowEnd) {
+    TRTCFrameCopier<Format>::copyRows(src, dst, rowBegin, rowEnd);
+  }
+};
+
+// BGRA32 <-> RGBA32 only exchanges bytes 0 and 2 of every pixel, which vectorises as plain 32-bit integer math.
+template <TRTCVideoPixelFormat Src, TRTCVideoPixelFormat Dst>
+struct TRTCRedBlueSwapConverter {
+  static void convert(const TRTCFrameView& src, const TRTCFrameView& dst) { convertRows(src, dst, 0, src.height); }
+
+  static void convertRows(const TRTCFrameView& src, const TRTCFrameView& dst, uint32_t rowBegin, uint32_t rowEnd) {
+    for (uint32_t row = rowBegin; row < rowEnd; ++row) {
+      const uint8_t* srcRow = src.planes[0] + static_cast<size_t>(row) * src.strides[0];
+      uint8_t* dstRow = dst.planes[0] + static_cast<size_t>(row) * dst.strides[0];
+      for (uint32_t x = 0; x < src.width; ++x) {
+        uint32_t pixel;
+        std::memcpy(&pixel, srcRow + x * 4, 4);
+        pixel = (pixel & 0xFF00FF00u) | ((pixel >> 16) & 0x000000FFu) | ((pixel & 0x000000FFu) << 16);
+        std::memcpy(dstRow + x * 4, &pixel, 4);
+      }
+    }
+  }
+};
+
+template <>
+struct TRTCFrameConverter<TRTCVideoPixelFormat_BGRA32, TRTCVideoPixelFormat_RGBA32>
+    : TRTCRedBlueSwapConverter<TRTCVideoPixelFormat_BGRA32, TRTCVideoPixelFormat_RGBA32> {};
+
+template <>
+struct TRTCFrameConverter<TRTCVideoPixelFormat_RGBA32, TRTCVideoPixelFormat_BGRA32>
+    : TRTCRedBlueSwapConverter<TRTCVideoPixelFormat_RGBA32, TRTCVideoPixelFormat_BGRA32> {};
+
+// I420 (BT.601, limited range) to an interleaved layout, in 8-bit fixed point.
+template <TRTCVideoPixelFormat Dst>
+struct TRTCI420ToPackedConverter {
+  using DstTraits = TRTCPixelFormatTraits<Dst>;
+
+  static uint8_t clampToByte(int value) { return static_cast<uint8_t>(std::min(std::max(value, 0), 255)); }
+
+  static void convert(const TRTCFrameView& src, const TRTCFrameView& dst) { convertRows(src, dst, 0, src.height); }
+
+  static void convertRows(const TRTCFrameView& src, const TRTCFrameView& dst, uint32_t rowBegin, uint32_t rowEnd) {
+    for (uint32_t row = rowBegin; row < rowEnd; ++row) {
+      const uint8_t* yRow = src.planes[0] + static_cast<size_t>(row) * src.strides[0];
+      const uint8_t* uRow = src.planes[1] + static_cast<size_t>(row / 2) * src.strides[1];
+      const uint8_t* vRow = src.planes[2] + static_cast<size_t>(row / 2) * src.strides[2];
+      uint8_t* dstRow = dst.planes[0] + static_cast<size_t>(row) * dst.strides[0];
+      for (uint32_t x = 0; x < src.width; ++x) {
+        const int c = 298 * (static_cast<int>(yRow[x]) - 16) + 128;
+        const int d = static_cast<int>(uRow[x / 2]) - 128;
+        const int e = static_cast<int>(vRow[x / 2]) - 128;
+        uint8_t* pixel = dstRow + x * 4;
+        pixel[DstTraits::kRed] = clampToByte((c + 409 * e) >> 8);
+        pixel[DstTraits::kGreen] = clampToByte((c - 100 * d - 208 * e) >> 8);
+        pixel[DstTraits::kBlue] = clampToByte((c + 516 * d) >> 8);
+        pixel[DstTraits::kAlpha] = 0xFF;
+      }
+    }
+  }
+};
+
+template <>
+struct TRTCFrameConverter<TRTCVideoPixelFormat_I420, TRTCVideoPixelFormat_BGRA32>
+    : TRTCI420ToPackedConverter<TRTCVideoPixelFormat_BGRA32> {};
+
+template <>
+struct TRTCFrameConverter<TRTCVideoPixelFormat_I420, TRTCVideoPixelFormat_RGBA32>
+    : TRTCI420ToPackedConverter<TRTCVideoPixelFormat_RGBA32> {};
+
+// Interleaved layout to I420 (BT.601, limited range), in 8-bit fixed point. Rows are processed in pairs and every
+// chroma sample is taken from the average colour of its 2x2 block.
+template <TRTCVideoPixelFormat Src>
+struct TRTCPackedToI420Converter {
+  using SrcTraits = TRTCPixelFormatTraits<Src>;
+
+  static uint8_t luma(int r, int g, int b) {
+    return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+  }
+
+  static void convert(const TRTCFrameView& src, const TRTCFrameView& dst) { convertRows(src, dst, 0, src.height); }
+
+  static void convertRows(const TRTCFrameView& src, const TRTCFrameView& dst, uint32_t rowBegin, uint32_t rowEnd) {
+    for (uint32_t row = rowBegin; row < rowEnd; row += 2) {
+      const bool pair = row + 1 < rowEnd;
+      const uint8_t* top = src.planes[0] + static_cast<size_t>(row) * src.strides[0];
+      const uint8_t* bottom = pair ? top + src.strides[0] : top;
+      uint8_t* yTop = dst.planes[0] + static_cast<size_t>(row) * dst.strides[0];
+      uint8_t* yBottom = yTop + dst.strides[0];
+      uint8_t* uRow = dst.planes[1] + static_cast<size_t>(row / 2) * dst.strides[1];
+      uint8_t* vRow = dst.planes[2] + static_cast<size_t>(row / 2) * dst.strides[2];
+      for (uint32_t x = 0; x < src.width; x += 2) {
+        const uint32_t next = x + 1 < src.width ? x + 1 : x;
+        const uint8_t* block[4] = {top + x * 4, top + next * 4, bottom + x * 4, bottom + next * 4};
+        int r = 0;
+        int g = 0;
+        int b = 0;
+        for (const uint8_t* pixel : block) {
+          r += pixel[SrcTraits::kRed];
+          g += pixel[SrcTraits::kGreen];
+          b += pixel[SrcTraits::kBlue];
+        }
+        yTop[x] = luma(block[0][SrcTraits::kRed], block[0][SrcTraits::kGreen], block[0][SrcTraits::kBlue]);
+        yTop[next] = luma(block[1][SrcTraits::kRed], block[1][SrcTraits::kGreen], block[1][SrcTraits::kBlue]);
+        if (pair) {
+          yBottom[x] = luma(block[2][SrcTraits::kRed], block[2][SrcTraits::kGreen], block[2][SrcTraits::kBlue]);
+          yBottom[next] = luma(block[3][SrcTraits::kRed], block[3][SrcTraits::kGreen], block[3][SrcTraits::kBlue]);
+        }
+        r = (r + 2) >> 2;
+        g = (g + 2) >> 2;
+        b = (b + 2) >> 2;
+        uRow[x / 2] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        vRow[x / 2] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+      }
+    }
+  }
+};
+
+template <>
+struct TRTCFrameConverter<TRTCVideoPixelFormat_BGRA32, TRTCVideoPixelFormat_I420>
+    : TRTCPackedToI420Converter<TRTCVideoPixelFormat_BGRA32> {};
+
+template <>
+struct TRTCFrameConverter<TRTCVideoPixelFormat_RGBA32, TRTCVideoPixelFormat_I420>
+    : TRTCPackedToI420Converter<TRTCVideoPixelFormat_RGBA32> {};
+
+/**
+ * Convert `src` into `dst` (same size, any supported format pair).
+ *
+ * The format pair is resolved once per frame and dispatched to the matching `TRTCFrameConverter` specialisation.
+ * Frames above the `TRTCParallelRows` threshold are converted in row bands on the task graph.
+ * @return false if the views are invalid, their sizes differ, or the pair is not supported.
+ */
+TRTCPLUGIN_API bool convertFrame(const TRTCFrameView& src, const TRTCFrameView& dst);
+
+/**
+ * Fill `dst` with an opaque grey placeholder (used before the first frame arrives and after a stream stops).
+ */
+TRTCPLUGIN_API void fillFramePlaceholder(const TRTCFrameView& dst);
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,133 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Blueprint/UserWidget.h"
+#include "CoreMinimal.h"
+#include "TRTCCloud.h"
+#include "TRTCRoster.h"
+#include "TRTCVideoFrameHub.h"
+
+#include "TRTCGalleryWidget.generated.h"
+
+class UCanvasPanel;
+class UImage;
+class UTexture2D;
+
+USTRUCT()
+struct FTRTCGalleryTile {
+  GENERATED_BODY()
+
+  UPROPERTY()
+  UImage* Image = nullptr;
+
+  UPROPERTY()
+  UTexture2D* Texture = nullptr;
+
+  // Roster handle of the participant shown; kTRTCInvalidUserHandle while the tile is free.
+  uint32 Handle = liteav::ue::kTRTCInvalidUserHandle;
+  // Position of the participant in the gallery.
+  int32 Index = INDEX_NONE;
+  std::string UserId;
+  uint64 Sequence = 0;
+  // Stream type the tile reported its display size for, if any.
+  bool HasDisplaySize = false;
+  liteav::TRTCVideoStreamType DisplaySizeType = liteav::TRTCVideoStreamTypeBig;
+};
+
+/**
+ * Participant gallery that only instantiates the tiles in view.
+ *
+ * Participants come from a `TRTCRoster` and are laid out in a scrolling grid. Tiles (an image each) exist only for the
+ * visible rows plus `OverscanRows`, and are rebound to other participants as the grid scrolls; their textures come
+ * from a pool sized by the number of tiles. Video subscription follows visibility: tiles tall enough on screen get the
+ * big stream, other visible and overscan tiles the small stream, and participants that stay out of view for
+ * `UnsubscribeDelay` seconds are unsubscribed. Layout, texture memory and decoding therefore scale with the viewport,
+ * not with the room.
+ */
+UCLASS()
+class TRTCPLUGIN_API UTRTCGalleryWidget : public UUserWidget {
+  GENERATED_BODY()
+
+ public:
+  /**
+   * Connect the gallery to the room. The gallery subscribes through the hub's shared remote views, so other
+   * components showing the same users keep their video. `Cloud` may be null, in which case attaching and subscribing
+   * are left to the caller. All three objects must outlive the gallery or be reset with nullptr.
+   */
+  void SetSources(liteav::ue::TRTCCloud* Cloud, liteav::ue::TRTCVideoFrameHub* Hub, liteav::ue::TRTCRoster* Roster);
+
+  UFUNCTION(BlueprintCallable, Category = "TRTC")
+  void SetScrollOffset(float Offset);
+
+  UFUNCTION(BlueprintPure, Category = "TRTC")
+  float GetScrollOffset() const { return ScrollOffset; }
+
+  UFUNCTION(BlueprintPure, Category = "TRTC")
+  float GetContentHeight() const { return ContentHeight; }
+
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TRTC")
+  FVector2D TileSize = FVector2D(320.f, 180.f);
+
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TRTC")
+  float TileSpacing = 8.f;
+
+  // Tiles at least this many pixels tall on screen subscribe the big stream; smaller ones the small stream.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TRTC")
+  float BigStreamMinHeight = 360.f;
+
+  // Seconds a participant stays subscribed after scrolling out of view, so that quick scrolling does not churn. Tiles
+  // scrolling back show the hub's cached last frame until video resumes, so this can stay short.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TRTC")
+  float UnsubscribeDelay = 1.f;
+
+  // Rows above and below the viewport whose tiles are kept bound and fed with the small stream.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TRTC")
+  int32 OverscanRows = 1;
+
+ protected:
+  TSharedRef<SWidget> RebuildWidget() override;
+  void NativeTick(const FGeometry& MyGeometry, float InDeltaTime) override;
+  FReply NativeOnMouseWheel(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent) override;
+  void NativeDestruct() override;
+
+ private:
+  struct FSubscription {
+    liteav::TRTCVideoStreamType Type = liteav::TRTCVideoStreamTypeBig;
+    double LastWanted = 0;
+  };
+
+  void LayoutTiles(const FGeometry& Geometry);
+  int32 AcquireTile();
+  void ReleaseTile(FTRTCGalleryTile& Tile);
+  void RefreshTile(FTRTCGalleryTile& Tile, liteav::TRTCVideoStreamType Type, uint32 PixelWidth, uint32 PixelHeight);
+  UTexture2D* AcquireTexture(uint32 Width, uint32 Height);
+  void ReleaseTexture(UTexture2D* Texture);
+  void WantStream(const std::string& UserId, liteav::TRTCVideoStreamType Type, double Now);
+  void ExpireSubscriptions(double Now, bool All);
+
+  UPROPERTY()
+  UCanvasPanel* Canvas = nullptr;
+
+  UPROPERTY()
+  TArray<FTRTCGalleryTile> Tiles;
+
+  UPROPERTY()
+  TArray<UTexture2D*> FreeTextures;
+
+  liteav::ue::TRTCCloud* Cloud = nullptr;
+  liteav::ue::TRTCVideoFrameHub* Hub = nullptr;
+  liteav::ue::TRTCRoster* Roster = nullptr;
+
+  // Users of the roster in gallery order, rebuilt only when its membership changes.
+  std::vector<liteav::ue::TRTCUserHandle> Participants;
+  uint64 ParticipantsRevision = MAX_uint64;
+  TMap<uint32, int32> HandleToTile;
+  std::map<std::string, FSubscription> Subscriptions;
+  float ScrollOffset = 0.f;
+  float ContentHeight = 0.f;
+};
@@ -0,0 +1,72 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+
+#include "CoreMinimal.h"
+#include "TRTCFrameBuffer.h"
+#include "TRTCStreamKey.h"
+
+namespace liteav {
+namespace ue {
+
+struct TRTCLastFrameCacheConfig {
+  // Frames are box-downscaled by powers of two until they would drop below this size.
+  uint32_t maxWidth = 320;
+  uint32_t maxHeight = 180;
+  // The least recently used frames are evicted beyond either limit.
+  size_t maxBytes = 8 * 1024 * 1024;
+  uint32_t maxFrames = 256;
+};
+
+//
+// Small downscaled copy of the last frame of streams that stopped, kept in an LRU under a memory cap.
+//
+// Views show the cached frame while a stream resumes (re-subscription, video re-enabled, a tile scrolled back into
+// view) instead of a placeholder until the next keyframe. Because a stopped stream costs at most a thumbnail, views can
+// unsubscribe off-screen streams early.
+//
+class TRTCPLUGIN_API TRTCLastFrameCache {
+ public:
+  explicit TRTCLastFrameCache(const TRTCLastFrameCacheConfig& config = TRTCLastFrameCacheConfig());
+  TRTCLastFrameCache(const TRTCLastFrameCache&) = delete;
+  TRTCLastFrameCache& operator=(const TRTCLastFrameCache&) = delete;
+
+  // Apply new limits; frames beyond them are evicted right away, cached frames keep their size.
+  void setConfig(const TRTCLastFrameCacheConfig& config);
+
+  // Keep a downscaled copy of `frame` as the last frame of `key`, replacing the previous one.
+  void store(const TRTCStreamKey& key, const TRTCFrameView& frame);
+
+  // Cached frame of `key` (marked as recently used), or nullptr.
+  std::shared_ptr<const TRTCFrameBuffer> find(const TRTCStreamKey& key);
+
+  void erase(const TRTCStreamKey& key);
+  void clear();
+
+  // Bytes held by cached frames.
+  size_t bytes() const;
+
+ private:
+  struct Entry {
+    TRTCStreamKey key;
+    std::shared_ptr<const TRTCFrameBuffer> frame;
+  };
+
+  void evict();
+
+  mutable FCriticalSection mutex_;
+  TRTCLastFrameCacheConfig config_;
+  // Most recently used first.
+  std::list<Entry> entries_;
+  std::map<TRTCStreamKey, std::list<Entry>::iterator> index_;
+  size_t bytes_ = 0;
+};
+
+}  // namespace ue
+}  // namespace liteav
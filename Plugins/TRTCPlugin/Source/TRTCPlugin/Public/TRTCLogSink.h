@@ -0,0 +1,91 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "CoreMinimal.h"
+#include "TRTCCloudHeaderBase.h"
+#include "TRTCMpscQueue.h"
+
+namespace liteav {
+namespace ue {
+
+struct TRTCLogSinkConfig {
+  // Forward lines to `UE_LOG` under the `LogTRTCSDK` category.
+  bool toUELog = true;
+  // Directory of the rotating gzip log files; empty disables file output.
+  FString fileDirectory;
+  // Compressed size at which the current file is rotated, and number of files kept.
+  uint64_t maxFileBytes = 4 * 1024 * 1024;
+  uint32_t maxFiles = 4;
+  // Lines buffered between the SDK threads and the drain thread.
+  uint32_t ringLines = 4096;
+  // Info-and-below lines accepted per module per second; warnings and errors are never limited. Zero disables it.
+  uint32_t maxLinesPerSecond = 200;
+};
+
+struct TRTCLogSinkStats {
+  uint64_t written = 0;
+  uint64_t droppedFull = 0;
+  uint64_t droppedRateLimited = 0;
+  uint64_t truncated = 0;
+};
+
+//
+// `ITRTCLogCallback` that never blocks the SDK thread calling it.
+//
+// `onLog` copies the line into a fixed-size slot of a lock-free ring and returns; a lowest-priority thread drains the
+// ring into `UE_LOG` and/or gzip files, written in large batches (each batch is one gzip member, so files stay valid
+// for `gunzip` and can be cut at any batch). Lines are dropped instead of waiting when the ring is full or a module
+// exceeds its rate, and the drain thread logs how many were dropped.
+//
+// Call `setLogCallback(nullptr)` before destroying the sink; the destructor drains what is left.
+//
+class TRTCPLUGIN_API TRTCLogSink : public ITRTCLogCallback {
+ public:
+  static constexpr uint32_t kMaxLineBytes = 480;
+  static constexpr uint32_t kMaxModuleBytes = 24;
+
+  explicit TRTCLogSink(const TRTCLogSinkConfig& config);
+  TRTCLogSink(const TRTCLogSink&) = delete;
+  TRTCLogSink& operator=(const TRTCLogSink&) = delete;
+  ~TRTCLogSink() override;
+
+  TRTCLogSinkStats stats() const;
+
+  // ITRTCLogCallback
+  void onLog(const char* log, TRTCLogLevel level, const char* module) override;
+
+ private:
+  class Worker;
+
+  struct Line {
+    TRTCLogLevel level;
+    char module[kMaxModuleBytes];
+    char text[kMaxLineBytes];
+  };
+
+  struct RateBucket {
+    std::atomic<uint32_t> second{0};
+    std::atomic<uint32_t> count{0};
+  };
+
+  static constexpr uint32_t kRateBuckets = 64;
+
+  bool admit(TRTCLogLevel level, const char* module);
+
+  const TRTCLogSinkConfig config_;
+  TRTCMpscQueue<Line> ring_;
+  RateBucket rate_buckets_[kRateBuckets];
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> dropped_full_{0};
+  std::atomic<uint64_t> dropped_rate_limited_{0};
+  std::atomic<uint64_t> truncated_{0};
+  std::unique_ptr<Worker> worker_;
+};
+
+}  // namespace ue
+}  // namespace liteav
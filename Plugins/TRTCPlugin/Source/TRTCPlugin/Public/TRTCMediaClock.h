@@ -0,0 +1,104 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "CoreMinimal.h"
+#include "TRTCCloud.h"
+
+namespace liteav {
+namespace ue {
+
+// Clocks custom frames can be timed with.
+enum class TRTCClockDomain : uint8_t {
+  // `FPlatformTime::Seconds()`, the reference every other domain is mapped through.
+  Platform,
+  // Frame times of the game thread, typically `FApp::GetCurrentTime()`.
+  Game,
+  // Times taken on the render or RHI thread, e.g. GPU frame timestamps.
+  Render,
+  // The audio device clock, as passed to `ISubmixBufferListener::OnNewSubmixBuffer`.
+  Audio,
+  Count,
+};
+
+constexpr uint32_t kTRTCClockDomainCount = static_cast<uint32_t>(TRTCClockDomain::Count);
+
+struct TRTCMediaClockConfig {
+  // How often the worker reads `generateCustomPTS` against the platform clock.
+  uint32_t samplePeriodMs = 250;
+  // Time constant of the offset and rate fits; longer fits are smoother but follow drift changes later.
+  double fitSeconds = 30.0;
+  // Rates further than this from the platform clock are clamped, so a burst of bad observations cannot run away.
+  double maxDriftPpm = 2000.0;
+  // An observation this far off the fit means the clock jumped (device reset, pause); the fit starts over.
+  double resyncMs = 100.0;
+};
+
+struct TRTCClockDomainStats {
+  // The domain has been observed; unobserved domains map as if they were the platform clock.
+  bool locked = false;
+  // Rate against the platform clock, or for `Platform` the SDK clock's rate against it, in parts per million.
+  double driftPpm = 0;
+  // Average distance of the observations from the fit.
+  double jitterMs = 0;
+  uint64_t observations = 0;
+  uint64_t resyncs = 0;
+};
+
+//
+// Maps the engine's clocks onto the timestamp domain of `generateCustomPTS`, so that custom video and audio frames
+// stamped from different threads stay in sync at the receiver.
+//
+// Each domain is related to the platform clock by a line fitted over (domain time, platform time) pairs passed to
+// `observe`, and the platform clock to the SDK clock by pairs a worker samples every `samplePeriodMs`. Both fits are
+// exponentially weighted least squares, so they estimate the drift between the clocks as well as their offset and
+// average out the scheduling jitter of individual observations. A frame is then stamped with the time it was
+// captured in whatever clock was at hand, instead of the time `generateCustomPTS` happens to be called on the send
+// path, which removes the per-path delivery delays receivers would otherwise have to absorb in their jitter buffers.
+//
+// All methods are thread-safe.
+//
+class TRTCPLUGIN_API TRTCMediaClock {
+ public:
+  TRTCMediaClock(TRTCCloud& cloud, const TRTCMediaClockConfig& config = TRTCMediaClockConfig());
+  TRTCMediaClock(const TRTCMediaClock&) = delete;
+  TRTCMediaClock& operator=(const TRTCMediaClock&) = delete;
+  ~TRTCMediaClock();
+
+  /**
+   * Record that `domainSeconds` in `domain` happened at `platformSeconds`. Call it regularly from the thread owning
+   * the clock, e.g. once per frame or audio buffer. Observations of `Platform` are ignored.
+   */
+  void observe(TRTCClockDomain domain, double domainSeconds, double platformSeconds);
+  void observe(TRTCClockDomain domain, double domainSeconds) {
+    observe(domain, domainSeconds, FPlatformTime::Seconds());
+  }
+
+  // Timestamp for `TRTCVideoFrame::timestamp` or `TRTCAudioFrame::timestamp`, in ms, of an instant in `domain`.
+  uint64_t pts(TRTCClockDomain domain, double domainSeconds) const;
+  uint64_t ptsNow() const { return pts(TRTCClockDomain::Platform, FPlatformTime::Seconds()); }
+
+  TRTCClockDomainStats stats(TRTCClockDomain domain) const;
+
+ private:
+  class Worker;
+  struct Fit;
+
+  void sampleCustomPts();
+
+  TRTCCloud& cloud_;
+  const TRTCMediaClockConfig config_;
+
+  mutable FCriticalSection mutex_;
+  // `fits_[Platform]` maps platform time to SDK time, the others map their domain to platform time.
+  std::unique_ptr<Fit[]> fits_;
+
+  std::unique_ptr<Worker> worker_;
+};
+
+}  // namespace ue
+}  // namespace liteav
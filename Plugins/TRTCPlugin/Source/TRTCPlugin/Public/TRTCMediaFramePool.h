@@ -0,0 +1,133 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "TRTCCloudHeaderBase.h"
+
+namespace liteav {
+namespace ue {
+
+struct TRTCMediaFramePoolState;
+
+//
+// Payload memory borrowed from a `TRTCMediaFramePool`, given back when the block is destroyed or reset. Blocks may be
+// released on any thread, including after the pool itself has been destroyed.
+//
+class TRTCPLUGIN_API TRTCPooledBlock {
+ public:
+  TRTCPooledBlock() = default;
+  TRTCPooledBlock(TRTCPooledBlock&& other) noexcept { swap(other); }
+  TRTCPooledBlock& operator=(TRTCPooledBlock&& other) noexcept {
+    TRTCPooledBlock(std::move(other)).swap(*this);
+    return *this;
+  }
+  TRTCPooledBlock(const TRTCPooledBlock&) = delete;
+  TRTCPooledBlock& operator=(const TRTCPooledBlock&) = delete;
+  ~TRTCPooledBlock() { reset(); }
+
+  uint8_t* data() const { return data_; }
+  // Usable bytes, at least what was asked for.
+  size_t capacity() const { return capacity_; }
+  explicit operator bool() const { return data_ != nullptr; }
+
+  void reset();
+
+  void swap(TRTCPooledBlock& other) noexcept {
+    std::swap(owner_, other.owner_);
+    std::swap(data_, other.data_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(bucket_, other.bucket_);
+  }
+
+ private:
+  friend class TRTCMediaFramePool;
+
+  std::weak_ptr<TRTCMediaFramePoolState> owner_;
+  uint8_t* data_ = nullptr;
+  size_t capacity_ = 0;
+  uint32_t bucket_ = 0;
+};
+
+//
+// A `TRTCVideoFrame` or `TRTCAudioFrame` filled in for a pooled payload. `get()` can be passed straight to
+// `sendCustomVideoData`, `sendCustomAudioData` or `mixExternalAudioFrame`, which copy the payload before returning.
+//
+template <typename Frame>
+class TRTCPooledFrame {
+ public:
+  TRTCPooledFrame() : frame_() {}
+  TRTCPooledFrame(const Frame& frame, TRTCPooledBlock block) : frame_(frame), block_(std::move(block)) {}
+  TRTCPooledFrame(TRTCPooledFrame&&) noexcept = default;
+  TRTCPooledFrame& operator=(TRTCPooledFrame&&) noexcept = default;
+
+  Frame* get() { return block_ ? &frame_ : nullptr; }
+  Frame* operator->() { return &frame_; }
+  uint8_t* data() const { return block_.data(); }
+  size_t capacity() const { return block_.capacity(); }
+  explicit operator bool() const { return static_cast<bool>(block_); }
+
+  // Give the payload back early.
+  void reset() {
+    block_.reset();
+    frame_ = Frame();
+  }
+
+ private:
+  Frame frame_;
+  TRTCPooledBlock block_;
+};
+
+using TRTCPooledVideoFrame = TRTCPooledFrame<TRTCVideoFrame>;
+using TRTCPooledAudioFrame = TRTCPooledFrame<TRTCAudioFrame>;
+
+struct TRTCMediaFramePoolStats {
+  // Blocks that had to be allocated, and blocks served from the pool.
+  uint64_t allocations = 0;
+  uint64_t reuses = 0;
+  // Reuses served from the releasing thread's own cache, without taking the pool lock.
+  uint64_t threadCacheHits = 0;
+  // Bytes idle in the shared lists; per-thread caches are not counted.
+  size_t idleBytes = 0;
+};
+
+//
+// Payload buffers for the frames handed to the SDK's send paths, so that steady-state custom capture and mixing do
+// not touch the heap.
+//
+// Blocks are bucketed by size in quarter-octave steps (at most 25% slack), from 4 KiB up. Each thread keeps a few
+// released blocks per bucket for itself and only falls back to the shared, locked lists when its cache is empty or
+// full; the shared lists keep at most `maxIdlePerBucket` blocks and free the rest. Frames are tightly packed, as the
+// SDK expects: video frames only carry a width, so rows must not be padded.
+//
+class TRTCPLUGIN_API TRTCMediaFramePool {
+ public:
+  explicit TRTCMediaFramePool(uint32_t maxIdlePerBucket = 8);
+  TRTCMediaFramePool(const TRTCMediaFramePool&) = delete;
+  TRTCMediaFramePool& operator=(const TRTCMediaFramePool&) = delete;
+  ~TRTCMediaFramePool();
+
+  // A block of at least `bytes`, or an empty block for zero bytes.
+  TRTCPooledBlock acquire(size_t bytes);
+
+  // A memory video frame of `format` (I420, BGRA32 or RGBA32); empty for other formats.
+  TRTCPooledVideoFrame acquireVideo(TRTCVideoPixelFormat format, uint32_t width, uint32_t height);
+
+  // A 16-bit PCM audio frame of `frames` samples per channel.
+  TRTCPooledAudioFrame acquireAudio(uint32_t sampleRate, uint32_t channels, uint32_t frames);
+
+  // Free every block idle in the shared lists.
+  void trim();
+
+  TRTCMediaFramePoolStats stats() const;
+
+ private:
+  std::shared_ptr<TRTCMediaFramePoolState> state_;
+};
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,109 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "CoreMinimal.h"
+
+namespace liteav {
+namespace ue {
+
+//
+// Bounded lock-free queue for many producers and one consumer (sequence-numbered cells, after D. Vyukov).
+//
+// Elements are constructed once and then filled and consumed in place, so large fixed-size records (log lines, audio
+// blocks) are not copied through temporaries. Producers never block: `tryPush` fails when the queue is full.
+//
+template <typename T>
+class TRTCMpscQueue {
+ public:
+  // `capacity` is rounded up to a power of two.
+  explicit TRTCMpscQueue(uint32_t capacity) {
+    uint32_t size = 2;
+    while (size < capacity) {
+      size *= 2;
+    }
+    mask_ = size - 1;
+    cells_ = std::make_unique<Cell[]>(size);
+    for (uint32_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+  TRTCMpscQueue(const TRTCMpscQueue&) = delete;
+  TRTCMpscQueue& operator=(const TRTCMpscQueue&) = delete;
+
+  uint32_t capacity() const { return mask_ + 1; }
+
+  // Approximate number of queued elements.
+  uint32_t size() const {
+    const uint64_t head = dequeue_pos_.load(std::memory_order_relaxed);
+    const uint64_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+    return tail > head ? static_cast<uint32_t>(tail - head) : 0;
+  }
+
+  /**
+   * Claim a cell and call `fill(T&)` on it. Safe from any number of threads.
+   * @param position Receives the queue position of the element, if not null.
+   * @return false if the queue is full; `fill` is not called then.
+   */
+  template <typename Fill>
+  bool tryPush(const Fill& fill, uint64_t* position = nullptr) {
+    uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      const uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    fill(cell->value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    if (position) {
+      *position = pos;
+    }
+    return true;
+  }
+
+  /**
+   * Call `consume(T&)` on the oldest element and release its cell. Consumer thread only.
+   * @return false if the queue is empty (or the oldest element is still being filled).
+   */
+  template <typename Consume>
+  bool tryPop(const Consume& consume) {
+    const uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell& cell = cells_[pos & mask_];
+    if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+      return false;
+    }
+    consume(cell.value);
+    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+    dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<uint64_t> sequence{0};
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  uint32_t mask_ = 0;
+  alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64_t> enqueue_pos_{0};
+  alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64_t> dequeue_pos_{0};
+};
+
+}  // namespace ue
+}  // namespace liteav
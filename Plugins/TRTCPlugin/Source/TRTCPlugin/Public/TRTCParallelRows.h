@@ -0,0 +1,59 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "Async/ParallelFor.h"
+#include "CoreMinimal.h"
+
+namespace liteav {
+namespace ue {
+
+//
+// Splits per-row image work into bands that run on the UE task graph. Idle workers keep pulling the next unclaimed
+// band (the calling thread participates too), so uneven bands and busy cores balance out without a fixed assignment.
+//
+// Small frames stay on the calling thread: below the threshold the dispatch and wake-up cost of the task graph is
+// larger than the work, and SDK callbacks should return as quickly as possible.
+//
+class TRTCPLUGIN_API TRTCParallelRows {
+ public:
+  // Default threshold: about one 1080p BGRA frame. 4K screen-share frames are split, camera frames are not.
+  static constexpr size_t kDefaultThresholdBytes = 8 * 1024 * 1024;
+  // Smallest band handed to a worker; keeps per-band overhead well below the work itself.
+  static constexpr uint32_t kMinBandRows = 32;
+
+  // Frames whose destination is smaller than `bytes` are processed on the calling thread. Zero disables banding.
+  static void setThresholdBytes(size_t bytes);
+  static size_t thresholdBytes();
+
+  /**
+   * Run `body(rowBegin, rowEnd)` over [0, rows).
+   *
+   * Band boundaries are always even so that 4:2:0 chroma rows are never split between two bands.
+   * @param frameBytes Size of the data produced, compared against the threshold.
+   */
+  template <typename Body>
+  static void forEachBand(uint32_t rows, size_t frameBytes, const Body& body) {
+    const size_t threshold = thresholdBytes();
+    const int32 workers = FMath::Max(1, FPlatformMisc::NumberOfWorkerThreadsToSpawn());
+    if (threshold == 0 || frameBytes < threshold || rows < kMinBandRows * 2 || workers < 2) {
+      body(0u, rows);
+      return;
+    }
+    // A few bands per worker so that a descheduled worker does not hold up the whole frame.
+    uint32_t bandRows = std::max<uint32_t>(kMinBandRows, rows / static_cast<uint32_t>(workers * 4));
+    bandRows = (bandRows + 1) & ~1u;
+    const int32 bands = static_cast<int32>((rows + bandRows - 1) / bandRows);
+    ParallelFor(bands, [&body, rows, bandRows](int32 band) {
+      const uint32_t rowBegin = static_cast<uint32_t>(band) * bandRows;
+      body(rowBegin, std::min(rows, rowBegin + bandRows));
+    });
+  }
+};
+
+}  // namespace ue
+}  // namespace liteav
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+TRTCPLUGIN_API DECLARE_LOG_CATEGORY_EXTERN(LogTRTCPlugin, Log, All);
+
 class FTRTCPluginModule : public IModuleInterface {
  public:
   /** IModuleInterface implementation */
@@ -0,0 +1,147 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "TRTCCloud.h"
+#include "TRTCVideoFrameHub.h"
+
+namespace liteav {
+namespace ue {
+
+//
+// Timing of one `TRTCRoomManager::switchRoom`, in milliseconds from the call. -1 means the event did not happen
+// before the next switch (for example a room without video).
+//
+struct TRTCRoomSwitchStats {
+  std::string roomKey;
+  // The room was promoted from the warm standby connection instead of being joined.
+  bool warm = false;
+  double enterRoomMs = -1;
+  double firstAudioMs = -1;
+  double firstVideoMs = -1;
+};
+
+//
+// Events of the room the manager currently presents. Called on the game thread.
+//
+class TRTCRoomManagerCallback {
+ public:
+  virtual ~TRTCRoomManagerCallback() {}
+
+  virtual void onRemoteUserEnterRoom(const char* userId) {}
+  virtual void onRemoteUserLeaveRoom(const char* userId) {}
+  virtual void onUserVideoAvailable(const char* userId, bool available) {}
+  virtual void onRoomSwitched(const TRTCRoomSwitchStats& stats) {}
+  virtual void onError(TXLiteAVError errCode, const char* errMsg) {}
+};
+
+//
+// Spectator room switching without a leave/join gap.
+//
+// The manager keeps two sub-clouds of `mainCloud`: the active room, and a standby connection that has already entered
+// the predicted next room as audience with remote audio and video muted. Switching to the standby room promotes it,
+// which only costs the video subscription; other rooms fall back to `ITRTCCloud::switchRoom` on the active cloud.
+// The main cloud itself is left free for publishing.
+//
+// Remote users are tracked per room and only the active room's events reach the callback; on promotion the callback
+// sees the old room's users leave and the new room's users enter. Video of the active room is subscribed
+// automatically and routed through a `TRTCVideoFrameHub` per cloud.
+//
+// All methods must be called on the game thread.
+//
+class TRTCPLUGIN_API TRTCRoomManager {
+ public:
+  // Consumers keep showing their last frame for at most this long after a switch while waiting for new video.
+  static constexpr double kHoldFrameSeconds = 3.0;
+
+  TRTCRoomManager(TRTCCloud* mainCloud, TRTCAppScene scene);
+  TRTCRoomManager(const TRTCRoomManager&) = delete;
+  TRTCRoomManager& operator=(const TRTCRoomManager&) = delete;
+  ~TRTCRoomManager();
+
+  void setCallback(TRTCRoomManagerCallback* callback);
+
+  /**
+   * Channel order used to predict the next room. After every switch the neighbour in the direction of travel (the
+   * next entry by default) is prepared as standby. `userId`, `userSig`, `strRoomId` and `privateMapKey` are copied.
+   */
+  void setRoomRing(const std::vector<TRTCParams>& rooms);
+
+  // Keep `params` warm on the standby connection, replacing the current prediction.
+  void prepareRoom(const TRTCParams& params);
+
+  /**
+   * Present `params` (also used to enter the first room), always as audience. Promotes the standby connection if it
+   * holds that room. The timing is reported through `TRTCRoomManagerCallback::onRoomSwitched` once the first video
+   * frame of the new room arrives, or when the next switch starts. If the new room cannot be entered, the manager
+   * switches back to the previous room and reports `onError`.
+   */
+  void switchRoom(const TRTCParams& params);
+
+  void exitRoom();
+
+  // Cloud and frame hub of the presented room. Both change on a warm switch.
+  TRTCCloud* activeCloud() const;
+  TRTCVideoFrameHub* activeHub() const;
+
+  /**
+   * Latest frame of `key` for `consumer`. Right after a switch, while the new room has no frame yet, the consumer's
+   * last frame is returned instead so that the screen does not go black.
+   * @param sequence Per-consumer counter that changes whenever the returned frame does.
+   */
+  std::shared_ptr<const TRTCFrameBuffer> latestFrame(const void* consumer, const TRTCStreamKey& key,
+                                                     uint64_t* sequence);
+  void setDisplaySize(const TRTCStreamKey& key, const void* consumer, uint32_t width, uint32_t height);
+  void removeConsumer(const void* consumer);
+
+ private:
+  class SlotCallback;
+  struct Room;
+  struct Slot;
+  struct HeldFrame {
+    std::shared_ptr<const TRTCFrameBuffer> frame;
+    uint64_t sequence = 0;
+  };
+
+  enum class SlotEvent { Error, EnterRoom, UserEnter, UserLeave, VideoAvailable, FirstVideo, FirstAudio };
+
+  Slot& active() const;
+  Slot& standby() const;
+  void enterSlot(Slot& slot, const std::shared_ptr<Room>& room, bool presented);
+  void leaveSlot(Slot& slot);
+  void restoreSlot(Slot& slot, bool presented);
+  void resetSlotStreams(Slot& slot);
+  void present(Slot& slot);
+  void withdraw(Slot& slot);
+  void predictNext();
+  int ringIndexOf(const std::string& key) const;
+  void finishSwitch();
+  void abortSwitch(TXLiteAVError errCode);
+  void handleEvent(int slotIndex, uint32_t generation, SlotEvent event, const std::string& text, int value);
+  double elapsedMs() const;
+
+  TRTCCloud* main_cloud_ = nullptr;
+  TRTCAppScene scene_;
+  TRTCRoomManagerCallback* callback_ = nullptr;
+  std::unique_ptr<Slot> slots_[2];
+  int active_index_ = 0;
+  std::vector<std::shared_ptr<Room>> ring_;
+  int ring_direction_ = 1;
+  double switch_started_ = 0;
+  bool switch_pending_ = false;
+  // Room presented before the pending switch, restored if the new room cannot be entered.
+  std::shared_ptr<Room> previous_room_;
+  TRTCRoomSwitchStats stats_;
+  std::map<const void*, HeldFrame> held_frames_;
+  // Expires when the manager is destroyed; SDK events marshalled to the game thread check it before running.
+  std::shared_ptr<bool> alive_;
+};
+
+}  // namespace ue
+}  // namespace liteav
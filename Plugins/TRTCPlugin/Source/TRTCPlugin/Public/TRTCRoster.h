@@ -0,0 +1,190 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "TRTCCloudHeaderBase.h"
+
+namespace liteav {
+namespace ue {
+
+//
+// Stable reference to one remote user in a `TRTCRoster`. A handle stays valid while the user is in the room; once the
+// user leaves, the slot is recycled under a new generation, so stale handles never alias a newer user.
+//
+using TRTCUserHandle = uint32_t;
+constexpr TRTCUserHandle kTRTCInvalidUserHandle = 0xFFFFFFFFu;
+constexpr uint32_t kTRTCInvalidSlot = 0xFFFFFFFFu;
+
+enum TRTCUserFlag : uint8_t {
+  TRTCUserFlag_AudioAvailable = 1 << 0,
+  TRTCUserFlag_VideoAvailable = 1 << 1,
+  TRTCUserFlag_SubStreamAvailable = 1 << 2,
+  // Volume at or above the speaking threshold in the latest `onUserVoiceVolume` report.
+  TRTCUserFlag_Speaking = 1 << 3,
+  // The user publishes at least one stream, i.e. is an anchor rather than audience.
+  TRTCUserFlag_Anchor = 1 << 4,
+};
+
+//
+// Changes applied by one `TRTCRoster::tick`. Users that entered and left within the same tick are not reported.
+// Handles in `left` are still readable during the notification and recycled right after it.
+//
+struct TRTCRosterChanges {
+  const std::vector<TRTCUserHandle>& entered;
+  const std::vector<TRTCUserHandle>& left;
+  // Users whose flags changed; volume changes alone are not reported.
+  const std::vector<TRTCUserHandle>& updated;
+};
+
+class TRTCRosterListener {
+ public:
+  virtual ~TRTCRosterListener() {}
+  virtual void onRosterChanged(const TRTCRosterChanges& changes) = 0;
+};
+
+//
+// Remote-user table for rooms with thousands of members.
+//
+// Users live in structure-of-arrays columns indexed by slot, found through an open-addressing (linear probing) hash
+// over their interned IDs, and recycled through a free list. Slots keep their ID buffers when recycled, so enter and
+// leave storms do not allocate once the table has grown to the room size.
+//
+// Add the roster as a callback of a `TRTCCloud`; SDK events are queued and applied in one batch by `tick()` on the
+// game thread, which then notifies the listener once. All queries are game-thread only and lock free. Speaking flags
+// require `enableAudioVolumeEvaluation`.
+//
+class TRTCPLUGIN_API TRTCRoster : public ITRTCCloudCallback {
+ public:
+  TRTCRoster();
+  TRTCRoster(const TRTCRoster&) = delete;
+  TRTCRoster& operator=(const TRTCRoster&) = delete;
+  ~TRTCRoster() override;
+
+  void setListener(TRTCRosterListener* listener);
+  // Volume (0 - 100) from which a user counts as speaking; 10 by default.
+  void setSpeakingThreshold(uint32_t volume);
+
+  // Apply the events queued since the last tick and notify the listener.
+  void tick();
+
+  uint32_t size() const { return count_; }
+  // Changes whenever users enter or leave, so that lists built with `forEachUser` can be kept between ticks.
+  uint64_t membershipRevision() const { return membership_revision_; }
+  // Number of slots, occupied or not; slot indices are below it.
+  uint32_t slotCount() const { return static_cast<uint32_t>(states_.size()); }
+  TRTCUserHandle find(const char* userId) const;
+  bool isValid(TRTCUserHandle handle) const;
+  // Slot of the user, stable while it is in the room, for per-slot tables such as material data; kTRTCInvalidSlot if
+  // the handle is stale.
+  uint32_t slot(TRTCUserHandle handle) const { return slotOf(handle); }
+  // Interned ID; valid while the user is in the room.
+  const char* userId(TRTCUserHandle handle) const;
+  uint8_t flags(TRTCUserHandle handle) const;
+  uint32_t volume(TRTCUserHandle handle) const;
+  // Number of users that have all bits of `mask` set.
+  uint32_t countWithFlags(uint8_t mask) const;
+
+  // Call `fn(handle)` for every user in the room, in slot order.
+  template <typename Fn>
+  void forEachUser(const Fn& fn) const {
+    for (uint32_t slot = 0; slot < static_cast<uint32_t>(states_.size()); ++slot) {
+      if (states_[slot] == SlotState::Present) {
+        fn(makeHandle(slot));
+      }
+    }
+  }
+
+  // ITRTCCloudCallback
+  void onError(TXLiteAVError errCode, const char* errMsg, void* extraInfo) override {}
+  void onWarning(TXLiteAVWarning warningCode, const char* warningMsg, void* extraInfo) override {}
+  void onEnterRoom(int result) override {}
+  void onExitRoom(int reason) override;
+  void onRemoteUserEnterRoom(const char* userId) override;
+  void onRemoteUserLeaveRoom(const char* userId, int reason) override;
+  void onUserVideoAvailable(const char* userId, bool available) override;
+  void onUserSubStreamAvailable(const char* userId, bool available) override;
+  void onUserAudioAvailable(const char* userId, bool available) override;
+  void onUserVoiceVolume(TRTCVolumeInfo* userVolumes, uint32_t userVolumesCount, uint32_t totalVolume) override;
+
+ private:
+  enum class SlotState : uint8_t { Free, Present, Leaving };
+  enum class EventType : uint8_t { Enter, Leave, Flag, VolumeReport, Volume, Clear };
+
+  struct PendingEvent {
+    EventType type;
+    uint8_t flag;
+    uint8_t value;
+    uint32_t textOffset;
+    uint32_t textLength;
+  };
+
+  // Events and their user IDs in one character arena; both keep their capacity between ticks.
+  struct EventQueue {
+    std::vector<PendingEvent> events;
+    std::vector<char> text;
+  };
+
+  struct Touched {
+    uint32_t slot;
+    uint8_t flags;
+  };
+
+  static constexpr uint32_t kIndexBits = 20;
+  static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1;
+  static constexpr uint32_t kEmptyBucket = 0xFFFFFFFFu;
+
+  static uint32_t hashId(const char* id, size_t length);
+
+  TRTCUserHandle makeHandle(uint32_t slot) const { return (generations_[slot] << kIndexBits) | slot; }
+  uint32_t slotOf(TRTCUserHandle handle) const;
+  uint32_t findSlot(const char* id, size_t length, uint32_t hash) const;
+  void insertBucket(uint32_t slot);
+  void eraseBucket(uint32_t slot);
+  void growTable();
+
+  void push(EventType type, const char* userId, uint8_t flag, uint8_t value);
+  void apply(const PendingEvent& event, const char* text);
+  uint32_t enter(const char* id, size_t length, uint32_t hash);
+  void leave(uint32_t slot);
+  void setFlag(uint32_t slot, uint8_t flag, bool on);
+  void touch(uint32_t slot);
+  void publishChanges();
+
+  TRTCRosterListener* listener_ = nullptr;
+  uint32_t speaking_threshold_ = 10;
+
+  // Slot columns.
+  std::vector<std::string> ids_;
+  std::vector<uint32_t> hashes_;
+  std::vector<uint32_t> generations_;
+  std::vector<uint8_t> flags_;
+  std::vector<uint8_t> volumes_;
+  std::vector<SlotState> states_;
+  std::vector<uint8_t> entered_this_tick_;
+  std::vector<uint8_t> touched_this_tick_;
+  std::vector<uint32_t> free_slots_;
+  uint32_t count_ = 0;
+  uint64_t membership_revision_ = 0;
+
+  // Power-of-two bucket array of slot indices, at most half full.
+  std::vector<uint32_t> buckets_;
+
+  std::vector<uint32_t> speakers_;
+  std::vector<Touched> touched_;
+  std::vector<TRTCUserHandle> entered_;
+  std::vector<TRTCUserHandle> left_;
+  std::vector<TRTCUserHandle> updated_;
+  std::vector<uint32_t> released_;
+
+  FCriticalSection queue_mutex_;
+  EventQueue incoming_;
+  EventQueue draining_;
+};
+
+}  // namespace ue
+}  // namespace liteav
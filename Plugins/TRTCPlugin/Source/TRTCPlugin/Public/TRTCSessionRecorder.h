@@ -0,0 +1,124 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "TRTCAudioFrameHub.h"
+#include "TRTCFrameBuffer.h"
+#include "TRTCMpscQueue.h"
+#include "TRTCVideoFrameHub.h"
+
+namespace liteav {
+namespace ue {
+
+struct TRTCSessionRecorderConfig {
+  bool recordVideo = true;
+  bool recordAudio = true;
+  // Nominal frame rate written to the Y4M headers; the capture time of every frame is kept in its frame header.
+  uint32_t videoFrameRate = 15;
+  // Frame and audio blocks that can wait for the I/O thread, and the bytes they may hold in total. Video is dropped
+  // once half of the byte budget is in use so that audio, which is small but cannot be skipped without a gap, still
+  // gets through.
+  uint32_t maxQueuedJobs = 512;
+  uint64_t maxQueuedBytes = 64 * 1024 * 1024;
+  // Data collected per file before it is written in one sequential write.
+  uint32_t writeChunkBytes = 1024 * 1024;
+};
+
+struct TRTCSessionRecorderStats {
+  uint64_t videoFrames = 0;
+  uint64_t audioFrames = 0;
+  uint64_t droppedVideoFrames = 0;
+  uint64_t droppedAudioFrames = 0;
+  uint64_t bytesWritten = 0;
+};
+
+//
+// Records every remote user to raw files that any tool can read: one `.y4m` (I420) file per video stream and one
+// `.wav` (16-bit PCM) file per audio stream.
+//
+// The recorder taps the frames of a `TRTCVideoFrameHub` and is added to the cloud's `TRTCAudioFrameHub` with
+// `consumerOptions()`. Callbacks only copy the data into pooled buffers and queue them; a dedicated thread
+// converts video to I420 and writes each file in large sequential chunks. When the disk falls behind, callbacks drop
+// frames instead of waiting, and the drops are reported in `stats`. A new numbered file is started when a stream
+// changes resolution or audio format.
+//
+// Only the plugin's thread and file abstractions are used, so recording works on every platform the plugin supports.
+//
+class TRTCPLUGIN_API TRTCSessionRecorder : public TRTCVideoFrameTap, public TRTCAudioFrameConsumer {
+ public:
+  static constexpr uint32_t kMaxUserIdBytes = 64;
+  // PCM one queued job holds: 20 ms of 48 kHz stereo. Longer blocks are split across several jobs.
+  static constexpr uint32_t kMaxAudioJobBytes = 48000 / 50 * 2 * 2;
+
+  explicit TRTCSessionRecorder(const TRTCSessionRecorderConfig& config);
+  TRTCSessionRecorder(const TRTCSessionRecorder&) = delete;
+  TRTCSessionRecorder& operator=(const TRTCSessionRecorder&) = delete;
+  ~TRTCSessionRecorder() override;
+
+  /**
+   * Start recording into `directory`, which is created if needed; recordings already in it are overwritten.
+   */
+  void start(const FString& directory);
+
+  /**
+   * Stop accepting frames, write everything already queued and close the files. Blocks until the files are complete.
+   */
+  void stop();
+
+  bool isRecording() const { return recording_.load(std::memory_order_relaxed); }
+
+  TRTCSessionRecorderStats stats() const;
+
+  // TRTCVideoFrameTap
+  void onFrame(const TRTCStreamKey& key, const TRTCFrameView& frame) override;
+
+  /**
+   * Options to add the recorder to a `TRTCAudioFrameHub` with: remote audio as delivered, on the hub's queue thread so
+   * that copying blocks never runs on the SDK audio thread. Blocks are kept until the queue overflows rather than
+   * skipping part of the backlog.
+   */
+  static TRTCAudioConsumerOptions consumerOptions();
+
+  // TRTCAudioFrameConsumer
+  void onAudioBlock(const TRTCAudioBlock& block) override;
+
+ private:
+  class Worker;
+
+  struct Job {
+    uint32_t session = 0;
+    bool video = false;
+    TRTCVideoStreamType streamType = TRTCVideoStreamTypeBig;
+    char userId[kMaxUserIdBytes];
+    size_t bytes = 0;
+    std::shared_ptr<TRTCFrameBuffer> frame;
+    // Audio is copied into the cell itself, so queueing a block never allocates.
+    uint8_t pcm[kMaxAudioJobBytes];
+    uint32_t sampleRate = 0;
+    uint32_t channels = 0;
+  };
+
+  bool reserve(size_t bytes, bool video);
+
+  const TRTCSessionRecorderConfig config_;
+  TRTCMpscQueue<Job> queue_;
+  TRTCFrameBufferPool pool_;
+  std::atomic<bool> recording_{false};
+  std::atomic<uint32_t> session_{0};
+  std::atomic<uint64_t> queued_bytes_{0};
+  std::atomic<uint64_t> video_frames_{0};
+  std::atomic<uint64_t> audio_frames_{0};
+  std::atomic<uint64_t> dropped_video_{0};
+  std::atomic<uint64_t> dropped_audio_{0};
+  std::atomic<uint64_t> bytes_written_{0};
+  std::unique_ptr<Worker> worker_;
+};
+
+}  // namespace ue
+}  // namespace liteav
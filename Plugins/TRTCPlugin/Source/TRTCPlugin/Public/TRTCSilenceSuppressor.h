@@ -0,0 +1,107 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "CoreMinimal.h"
+#include "TRTCAudioFrameHub.h"
+#include "TRTCCloud.h"
+
+namespace liteav {
+namespace ue {
+
+struct TRTCSilenceSuppressorConfig {
+  // Continuous silence after which the microphone is muted.
+  uint32_t silenceHoldMs = 1500;
+  // Delay applied to all captured audio so the start of a word is still in the pipeline when the unmute takes effect.
+  // It adds the same latency to the published voice; zero disables it. At most 200 ms.
+  uint32_t preRollMs = 60;
+  // Speech is a frame louder than the tracked noise floor by this margin, and louder than `minSpeechDb` (dBFS).
+  float onsetMarginDb = 12.f;
+  float minSpeechDb = -55.f;
+  // How fast the noise floor follows a rising background level.
+  float floorRiseDbPerSecond = 2.f;
+};
+
+struct TRTCSilenceSuppressorStats {
+  bool speaking = false;
+  // Microphone muted by the suppressor itself, not counting `setUserMuted`.
+  bool suppressed = false;
+  uint64_t mutes = 0;
+  uint64_t unmutes = 0;
+  double suppressedSeconds = 0;
+  float noiseFloorDb = 0.f;
+};
+
+//
+// Mutes the local microphone after sustained silence so that silent members of large voice rooms stop sending audio,
+// which saves their uplink and the server's fan-out to every listener.
+//
+// Install it with `TRTCAudioFrameHub::setCaptureProcessor`. Detection runs on each captured frame against an adaptive
+// noise floor: a single loud frame counts as speech onset, while muting waits for `silenceHoldMs` without one. The
+// capture thread only flips a flag; a worker thread makes the `muteLocalAudio` calls, which leave the SDK sending its
+// low-rate mute packets. Because unmuting takes effect a little after onset, the captured audio is delayed by
+// `preRollMs`, in place, so the first syllable reaches the encoder only once the microphone is open again.
+//
+// Remote users see the muted periods as `onUserAudioAvailable(false)`. The application's own microphone mute has to go
+// through `setUserMuted`, otherwise the suppressor would undo it at the next onset.
+//
+class TRTCPLUGIN_API TRTCSilenceSuppressor : public TRTCAudioFrameProcessor {
+ public:
+  /**
+   * `inner`, typically a `TRTCVoiceProcessor`, runs on each frame before detection so that detection sees the
+   * processed voice. It must outlive the suppressor.
+   */
+  TRTCSilenceSuppressor(TRTCCloud& cloud,
+                        const TRTCSilenceSuppressorConfig& config = TRTCSilenceSuppressorConfig(),
+                        TRTCAudioFrameProcessor* inner = nullptr);
+  TRTCSilenceSuppressor(const TRTCSilenceSuppressor&) = delete;
+  TRTCSilenceSuppressor& operator=(const TRTCSilenceSuppressor&) = delete;
+  // Unmutes the microphone unless the user muted it.
+  ~TRTCSilenceSuppressor() override;
+
+  // When disabled the microphone follows `setUserMuted` only; the pre-roll delay stays in place to avoid a jump.
+  void setEnabled(bool enabled);
+  void setUserMuted(bool muted);
+
+  TRTCSilenceSuppressorStats stats() const;
+
+  // TRTCAudioFrameProcessor
+  void processCapturedAudio(int16_t* pcm, uint32_t frames, uint32_t channels, uint32_t sampleRate) override;
+
+ private:
+  class Worker;
+
+  static constexpr uint32_t kMaxPreRollMs = 200;
+  static constexpr uint32_t kMaxSampleRate = 48000;
+  static constexpr uint32_t kMaxChannels = 2;
+
+  void delay(int16_t* pcm, uint32_t frames, uint32_t channels, uint32_t sampleRate);
+  void detect(const int16_t* pcm, uint32_t frames, uint32_t channels, uint32_t sampleRate);
+
+  TRTCCloud& cloud_;
+  const TRTCSilenceSuppressorConfig config_;
+  TRTCAudioFrameProcessor* const inner_;
+
+  // Capture thread state. The delay line holds interleaved samples of the current format.
+  std::unique_ptr<int16_t[]> delay_line_;
+  uint32_t delay_samples_ = 0;
+  uint32_t delay_position_ = 0;
+  uint32_t sample_rate_ = 0;
+  uint32_t channels_ = 0;
+  float noise_floor_db_ = -60.f;
+  uint64_t silent_samples_ = 0;
+
+  std::atomic<bool> speaking_{false};
+  std::atomic<bool> enabled_{true};
+  std::atomic<bool> user_muted_{false};
+  std::atomic<float> noise_floor_{0.f};
+
+  std::unique_ptr<Worker> worker_;
+};
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,47 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TRTCVideoFrameHub.h"
+
+namespace liteav {
+namespace ue {
+
+enum class TRTCSnapshotFormat : uint8_t {
+  PNG,
+  JPEG,
+};
+
+struct TRTCSnapshot {
+  bool success = false;
+  TRTCStreamKey key;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  // Capture timestamp of the frame in ms.
+  uint64_t timestamp = 0;
+  // Encoded PNG or JPEG file contents.
+  TArray64<uint8> encoded;
+};
+
+DECLARE_DELEGATE_OneParam(FTRTCSnapshotDelegate, const TRTCSnapshot&);
+
+/**
+ * Capture the latest frame `hub` holds for `key` and encode it as a PNG or JPEG file, on every platform.
+ *
+ * The calling (game) thread only takes a reference to the frame buffer and queues a background task; the copy, any
+ * pixel conversion and the encoding happen on the task graph's background workers. The frame has the resolution the
+ * hub keeps for the stream, which is the source resolution as long as one consumer reports a zero display size.
+ *
+ * @param quality JPEG quality from 1 to 100; ignored for PNG.
+ * @param onComplete Executed on the game thread with the result, also when encoding fails.
+ * @return false if the stream has no frame; `onComplete` is not executed then.
+ */
+TRTCPLUGIN_API bool requestSnapshot(const TRTCVideoFrameHub& hub,
+                                    const TRTCStreamKey& key,
+                                    TRTCSnapshotFormat format,
+                                    FTRTCSnapshotDelegate onComplete,
+                                    int32 quality = 90);
+
+}  // namespace ue
+}  // namespace liteav
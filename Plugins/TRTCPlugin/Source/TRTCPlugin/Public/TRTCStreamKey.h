@@ -0,0 +1,34 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <string>
+
+#include "CoreMinimal.h"
+#include "TRTCCloudHeaderBase.h"
+
+namespace liteav {
+namespace ue {
+
+//
+// Identifies one video stream routed through the plugin. The local camera preview uses an empty `userId`.
+//
+struct TRTCPLUGIN_API TRTCStreamKey {
+  std::string userId;
+  TRTCVideoStreamType streamType = TRTCVideoStreamTypeBig;
+
+  TRTCStreamKey() = default;
+  TRTCStreamKey(const char* user, TRTCVideoStreamType type) : userId(user ? user : ""), streamType(type) {}
+
+  bool isLocal() const { return userId.empty(); }
+
+  bool operator<(const TRTCStreamKey& other) const {
+    return streamType != other.streamType ? streamType < other.streamType : userId < other.userId;
+  }
+  bool operator==(const TRTCStreamKey& other) const {
+    return streamType == other.streamType && userId == other.userId;
+  }
+};
+
+}  // namespace ue
+}  // namespace liteav
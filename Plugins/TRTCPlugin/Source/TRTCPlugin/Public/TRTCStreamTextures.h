@@ -0,0 +1,96 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "TRTCStreamKey.h"
+#include "TRTCVideoFrameHub.h"
+#include "UObject/GCObject.h"
+
+class UTexture2D;
+struct FUpdateTextureRegion2D;
+
+namespace liteav {
+namespace ue {
+
+class TRTCStreamTextures;
+
+//
+// One consumer's share of a stream texture from `TRTCStreamTextures`. Copies of a handle are the same consumer; the
+// stream stops being uploaded and its texture is released once no handle of any consumer is left.
+//
+class TRTCPLUGIN_API TRTCStreamTextureHandle {
+ public:
+  TRTCStreamTextureHandle() = default;
+
+  /**
+   * Texture holding the latest frame, or nullptr until the first one arrived. It is recreated when the frame size
+   * changes, so consumers fetch it every tick and rebind their brush or material parameter when it differs.
+   */
+  UTexture2D* texture() const;
+
+  // Pixel size this consumer shows the stream at; see `TRTCVideoFrameHub::setDisplaySize`.
+  void setDisplaySize(uint32_t width, uint32_t height);
+
+  explicit operator bool() const { return consumer_ != nullptr; }
+  void reset() { consumer_.reset(); }
+
+ private:
+  friend class TRTCStreamTextures;
+  struct Consumer;
+
+  std::shared_ptr<Consumer> consumer_;
+};
+
+//
+// Owns exactly one texture per (user, stream type) and shares it between every widget, material and actor showing
+// that stream.
+//
+// The frame hub already keeps one downscaled copy of each stream at the largest size any consumer reported, so each
+// stream is copied once; this class makes it uploaded once as well, into a texture of that size, no matter how many
+// places show it. Screen-share streams (`TRTCVideoStreamTypeSub`) only upload the tiles that changed since the previous
+// frame, see `TRTCDirtyTiles`. A stream with no consumer left is dropped and its texture left to the garbage collector.
+//
+// Game thread only. The service must outlive its handles and `tick` once per frame, before the consumers read their
+// textures.
+//
+class TRTCPLUGIN_API TRTCStreamTextures : public FGCObject {
+ public:
+  explicit TRTCStreamTextures(TRTCVideoFrameHub& hub);
+  TRTCStreamTextures(const TRTCStreamTextures&) = delete;
+  TRTCStreamTextures& operator=(const TRTCStreamTextures&) = delete;
+  ~TRTCStreamTextures() override;
+
+  // A new consumer of `key`. Remote users still have to be attached to the hub and their video started.
+  TRTCStreamTextureHandle acquire(const TRTCStreamKey& key);
+
+  // Upload the frames that arrived since the last tick.
+  void tick();
+
+  // Streams with at least one consumer, and uploads issued so far with the pixel bytes they copied.
+  uint32_t streamCount() const;
+  uint64_t uploadCount() const { return uploads_; }
+  uint64_t uploadBytes() const { return upload_bytes_; }
+
+  // FGCObject
+  void AddReferencedObjects(FReferenceCollector& collector) override;
+  FString GetReferencerName() const override;
+
+ private:
+  friend class TRTCStreamTextureHandle;
+  struct Stream;
+
+  TRTCVideoFrameHub& hub_;
+  std::map<TRTCStreamKey, std::weak_ptr<Stream>> streams_;
+  uint64_t uploads_ = 0;
+  uint64_t upload_bytes_ = 0;
+  std::vector<FUpdateTextureRegion2D> regions_;
+};
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,130 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "AudioDevice.h"
+#include "CoreMinimal.h"
+#include "TRTCCloud.h"
+#include "TRTCMediaClock.h"
+
+class USoundSubmix;
+
+namespace liteav {
+namespace ue {
+
+struct TRTCSubmixBridgeConfig {
+  // Channels sent to the SDK, 1 or 2. Surround submixes contribute their front left and right channels.
+  uint32_t channels = 2;
+  // Duration of each frame handed to `mixExternalAudioFrame`, 5 to 100 ms.
+  uint32_t frameMs = 20;
+  // Audio the bridge keeps queued in the SDK's mixing buffer; the SDK recommends staying at or above 100 ms.
+  uint32_t targetBufferedMs = 100;
+  // Frames converted ahead of delivery. When the SDK stops taking frames the oldest ones are discarded.
+  uint32_t poolFrames = 16;
+  // Where the game audio is heard, as in `enableMixExternalAudioFrame`.
+  bool publish = true;
+  bool playout = false;
+  // When set, frames are stamped with the audio clock time the engine rendered them at, mapped by this clock, instead
+  // of the time they are handed to the SDK. Must outlive the bridge.
+  TRTCMediaClock* clock = nullptr;
+};
+
+struct TRTCSubmixBridgeStats {
+  uint64_t sentFrames = 0;
+  // Times the SDK buffer ran dry with no game audio ready, i.e. remote listeners heard a gap.
+  uint64_t underruns = 0;
+  // Times game audio was discarded because the bridge was too far behind: the submix ring or the frame pool was full.
+  uint64_t overruns = 0;
+  // Frames the SDK refused, typically because external mixing is disabled.
+  uint64_t rejectedFrames = 0;
+  // SDK buffer level reported by the latest delivery.
+  int32_t bufferedMs = 0;
+};
+
+//
+// Mixes the output of a UE submix into the audio sent to remote users.
+//
+// The audio render thread only copies the submix buffer, mapped to the output channels, into a pre-allocated
+// lock-free ring. A dedicated thread cuts the ring into frames held in a pool allocated up front, converts them to
+// 16-bit PCM, and hands them to `mixExternalAudioFrame` whenever the SDK's buffer level, as returned by that call and
+// counted down in real time, drops below `targetBufferedMs`. Delivery therefore follows the SDK's consumption instead
+// of the engine's audio callback cadence, and nothing allocates after construction.
+//
+// The submix sample rate is used as is; it must be one the SDK accepts (16, 24, 32, 44.1 or 48 kHz).
+//
+class TRTCPLUGIN_API TRTCSubmixBridge : public ISubmixBufferListener {
+ public:
+  TRTCSubmixBridge(TRTCCloud& cloud, const TRTCSubmixBridgeConfig& config = TRTCSubmixBridgeConfig());
+  TRTCSubmixBridge(const TRTCSubmixBridge&) = delete;
+  TRTCSubmixBridge& operator=(const TRTCSubmixBridge&) = delete;
+  ~TRTCSubmixBridge() override;
+
+  /**
+   * Enable external audio mixing and start tapping `submix` of `device` (the master submix if null). Both must stay
+   * alive until `stop`.
+   */
+  void start(FAudioDevice* device, USoundSubmix* submix = nullptr);
+
+  // Stop tapping and disable external audio mixing. Waits until the audio render thread no longer calls the bridge.
+  void stop();
+
+  bool isRunning() const { return device_ != nullptr; }
+
+  TRTCSubmixBridgeStats stats() const;
+
+  // ISubmixBufferListener, on the audio render thread.
+  void OnNewSubmixBuffer(const USoundSubmix* OwningSubmix,
+                         float* AudioData,
+                         int32 NumSamples,
+                         int32 NumChannels,
+                         const int32 SampleRate,
+                         double AudioClock) override;
+
+ private:
+  class Worker;
+
+  static constexpr uint32_t kMaxSampleRate = 48000;
+  static constexpr uint32_t kClockAnchors = 32;
+
+  // Audio clock reading of one submix buffer, taken on the audio render thread and fed to the clock by the worker,
+  // since the clock takes a lock.
+  struct ClockAnchor {
+    uint64_t writePosition;
+    double audioClock;
+    double platformSeconds;
+    uint32_t sampleRate;
+  };
+
+  TRTCCloud& cloud_;
+  const TRTCSubmixBridgeConfig config_;
+  FAudioDevice* device_ = nullptr;
+  USoundSubmix* submix_ = nullptr;
+
+  // Single-producer single-consumer ring of interleaved output samples, audio render thread to worker.
+  std::unique_ptr<float[]> ring_;
+  uint64_t ring_mask_ = 0;
+  std::atomic<uint64_t> ring_write_{0};
+  std::atomic<uint64_t> ring_read_{0};
+  std::atomic<uint32_t> sample_rate_{0};
+  // Single-producer single-consumer ring of clock readings, only used with a clock. A full ring skips readings.
+  ClockAnchor anchors_[kClockAnchors];
+  std::atomic<uint64_t> anchor_write_{0};
+  std::atomic<uint64_t> anchor_read_{0};
+  std::atomic<bool> tapping_{false};
+
+  std::atomic<uint64_t> sent_frames_{0};
+  std::atomic<uint64_t> underruns_{0};
+  std::atomic<uint64_t> overruns_{0};
+  std::atomic<uint64_t> rejected_frames_{0};
+  std::atomic<int32_t> buffered_ms_{0};
+
+  std::unique_ptr<Worker> worker_;
+};
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,188 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+
+#include "CoreMinimal.h"
+#include "TRTCCloud.h"
+
+namespace liteav {
+namespace ue {
+
+// Traffic sharing the uplink, in the order the budget is reserved for them.
+enum class TRTCUplinkChannel : uint8_t {
+  Audio,
+  Messages,
+  MainVideo,
+  SubStream,
+  Count,
+};
+
+constexpr uint32_t kTRTCUplinkChannelCount = static_cast<uint32_t>(TRTCUplinkChannel::Count);
+
+struct TRTCUplinkPolicy {
+  // Fixed uplink budget; zero estimates it from `onStatistics` and `onNetworkQuality`, starting at
+  // `initialBudgetKbps` and staying within [`minBudgetKbps`, `maxBudgetKbps`].
+  uint32_t budgetKbps = 0;
+  uint32_t initialBudgetKbps = 1500;
+  uint32_t minBudgetKbps = 200;
+  uint32_t maxBudgetKbps = 8000;
+
+  // Share kept for `sendCustomCmdMsg` and `sendSEIMsg`; the SDK itself allows at most 8 KB per second.
+  uint32_t messageKbps = 16;
+  uint32_t maxMessagesPerSecond = 30;
+
+  // Screen sharing is served first and the camera gets what is left; otherwise the other way round.
+  bool preferSubStream = true;
+  // Cap of the camera while the sub stream is on and preferred, applied over what the application asked for.
+  TRTCVideoEncParam mainWhileSharing = sharingCap();
+  // Bitrates no video channel is pushed below, however short the budget; the SDK degrades further on its own.
+  uint32_t mainMinKbps = 300;
+  uint32_t subMinKbps = 300;
+  // Frame rate the camera falls back to once it gets less than three quarters of its bitrate.
+  uint32_t reducedFps = 15;
+  // Lowest frame rate of the sub stream, which keeps its resolution and drops frames instead so text stays legible.
+  uint32_t subMinFps = 5;
+
+  // Encoder settings are raised at most once per `minUpgradeSeconds` per channel; lowering them is immediate.
+  // Bitrate changes under `bitrateTolerance` of the current one are not applied.
+  double minUpgradeSeconds = 5.0;
+  float bitrateTolerance = 0.1f;
+
+ private:
+  static TRTCVideoEncParam sharingCap() {
+    TRTCVideoEncParam param;
+    param.videoResolution = TRTCVideoResolution_640_360;
+    param.videoFps = 15;
+    param.videoBitrate = 400;
+    return param;
+  }
+};
+
+struct TRTCUplinkStats {
+  uint32_t budgetKbps = 0;
+  // Send rate from the latest statistics, and the loss it reported.
+  uint32_t measuredKbps = 0;
+  uint32_t upLoss = 0;
+  // Bitrate given to each channel by the latest rebalance.
+  uint32_t allocatedKbps[kTRTCUplinkChannelCount] = {};
+  uint64_t rebalances = 0;
+  uint64_t encoderUpdates = 0;
+  // Messages refused because the message share or rate was used up.
+  uint64_t messagesRefused = 0;
+};
+
+//
+// Splits one measured uplink budget between audio, custom messages, the main video and the sub stream, so that
+// `setVideoEncoderParam` and `setSubStreamEncoderParam` stop oversubscribing the uplink when an anchor shares the
+// screen while on camera.
+//
+// Audio and the message share are reserved first; the preferred video channel then gets up to what the application
+// asked for while leaving the other one its minimum, and the other one gets the rest. The camera is scaled down the
+// resolution ladder and to `reducedFps` as its share shrinks, while the sub stream keeps its resolution and lowers its
+// frame rate. The split is rebalanced on every statistics report and whenever a channel changes, and encoder settings
+// are only pushed to the SDK when they moved enough.
+//
+// The application sets the channels here instead of on the cloud, still starts and stops capture itself, and sends
+// custom messages through the arbiter. Add it as a callback of the cloud and `tick` it on the game thread.
+//
+class TRTCPLUGIN_API TRTCUplinkArbiter : public ITRTCCloudCallback {
+ public:
+  explicit TRTCUplinkArbiter(TRTCCloud& cloud, const TRTCUplinkPolicy& policy = TRTCUplinkPolicy());
+  TRTCUplinkArbiter(const TRTCUplinkArbiter&) = delete;
+  TRTCUplinkArbiter& operator=(const TRTCUplinkArbiter&) = delete;
+  ~TRTCUplinkArbiter() override;
+
+  /**
+   * What the application wants from each video channel; the arbiter never exceeds it. Disabled channels take no
+   * share. Pass `subStreamParam()` to `startScreenCapture`, which is applied right away.
+   */
+  void setMainVideo(bool enabled, const TRTCVideoEncParam& wanted);
+  void setSubStream(bool enabled, const TRTCVideoEncParam& wanted);
+  // Audio quality passed to `startLocalAudio`, reserved until the statistics report the actual bitrate.
+  void setAudio(bool enabled, TRTCAudioQuality quality);
+  // Fix the budget, or go back to estimating it with zero.
+  void setBudgetKbps(uint32_t kbps);
+
+  void tick();
+
+  // Encoder settings currently applied to each video channel.
+  TRTCVideoEncParam mainVideoParam() const { return applied_[0].param; }
+  TRTCVideoEncParam subStreamParam() const { return applied_[1].param; }
+
+  /**
+   * `TRTCCloud::sendCustomCmdMsg` and `sendSEIMsg` within the message share, callable from any thread. Returns false
+   * without sending when the share or the message rate is used up, so the caller can drop or retry the message.
+   */
+  bool sendCustomCmdMsg(uint32_t cmdId, const uint8_t* data, uint32_t dataSize, bool reliable, bool ordered);
+  bool sendSEIMsg(const uint8_t* data, uint32_t dataSize, int32_t repeatCount);
+
+  TRTCUplinkStats stats() const;
+
+  // ITRTCCloudCallback
+  void onError(TXLiteAVError /*errCode*/, const char* /*errMsg*/, void* /*extraInfo*/) override {}
+  void onWarning(TXLiteAVWarning /*warningCode*/, const char* /*warningMsg*/, void* /*extraInfo*/) override {}
+  void onEnterRoom(int /*result*/) override {}
+  void onExitRoom(int /*reason*/) override {}
+  void onNetworkQuality(TRTCQualityInfo localQuality,
+                        TRTCQualityInfo* remoteQuality,
+                        uint32_t remoteQualityCount) override;
+  void onStatistics(const TRTCStatistics& statistics) override;
+
+ private:
+  struct Video {
+    bool enabled = false;
+    TRTCVideoEncParam wanted;
+  };
+
+  struct Applied {
+    bool valid = false;
+    TRTCVideoEncParam param;
+    double lastChange = -1e9;
+  };
+
+  struct PendingStatistics {
+    bool fresh = false;
+    uint64_t sentBytes = 0;
+    uint32_t upLoss = 0;
+    uint32_t audioKbps = 0;
+    double time = 0;
+  };
+
+  bool takeMessage(uint32_t bytes);
+  void updateBudget();
+  void rebalance(double now);
+  TRTCVideoEncParam shapeMain(const TRTCVideoEncParam& wanted, uint32_t kbps) const;
+  TRTCVideoEncParam shapeSub(const TRTCVideoEncParam& wanted, uint32_t kbps) const;
+  bool applyVideo(uint32_t index, const TRTCVideoEncParam& param, double now);
+
+  TRTCCloud& cloud_;
+  const TRTCUplinkPolicy policy_;
+
+  // Main video, then sub stream.
+  Video videos_[2];
+  Applied applied_[2];
+  bool audio_enabled_ = false;
+  TRTCAudioQuality audio_quality_ = TRTCAudioQualityDefault;
+  float audio_kbps_ = 0;
+  bool dirty_ = true;
+  uint32_t fixed_budget_kbps_ = 0;
+  float budget_kbps_ = 0;
+  float measured_kbps_ = 0;
+  uint64_t last_sent_bytes_ = 0;
+  double last_statistics_time_ = 0;
+
+  mutable FCriticalSection mutex_;
+  PendingStatistics incoming_;
+  TRTCQuality quality_ = TRTCQuality_Unknown;
+  // Message token buckets, in bytes and messages, refilled from `message_refill_time_`.
+  float message_bytes_ = 0;
+  float message_count_ = 0;
+  double message_refill_time_ = 0;
+  // Written under `mutex_`: the game thread updates most fields, any sending thread `messagesRefused`.
+  TRTCUplinkStats stats_;
+};
+
+}  // namespace ue
+}  // namespace liteav
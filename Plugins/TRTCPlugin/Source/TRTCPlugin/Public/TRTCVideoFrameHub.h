@@ -0,0 +1,148 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+#include "TRTCCloud.h"
+#include "TRTCFrameBuffer.h"
+#include "TRTCFrameScaler.h"
+#include "TRTCLastFrameCache.h"
+#include "TRTCStreamKey.h"
+
+namespace liteav {
+namespace ue {
+
+//
+// Observer of every frame the hub receives, at source resolution and before any downscaling.
+//
+// `onFrame` runs on the SDK render thread and `frame` is only valid during the call; implementations copy what they
+// need and return quickly.
+//
+class TRTCPLUGIN_API TRTCVideoFrameTap {
+ public:
+  virtual ~TRTCVideoFrameTap() = default;
+  virtual void onFrame(const TRTCStreamKey& key, const TRTCFrameView& frame) = 0;
+};
+
+//
+// Receives the custom render callbacks of one `TRTCCloud` and keeps the latest frame of every stream in pooled,
+// stride-aligned buffers.
+//
+// Consumers (widgets, materials) report the pixel size they display a stream at. Frames larger than the largest
+// consumer are downscaled straight out of the SDK buffer instead of being copied at full size, so a 1080p stream shown
+// in a thumbnail only ever costs a thumbnail-sized copy and upload.
+//
+class TRTCPLUGIN_API TRTCVideoFrameHub : public ITRTCVideoRenderCallback {
+ public:
+  explicit TRTCVideoFrameHub(TRTCCloud* cloud);
+  TRTCVideoFrameHub(const TRTCVideoFrameHub&) = delete;
+  TRTCVideoFrameHub& operator=(const TRTCVideoFrameHub&) = delete;
+  ~TRTCVideoFrameHub() override;
+
+  /**
+   * Route the local camera preview (or the remote streams of `userId`) through the hub.
+   *
+   * Frames are requested in `kTRTCNativePixelFormat`. For remote users, `startRemoteView(userId, type, nullptr)` still
+   * has to be called to receive data. Users still attached when the hub is destroyed are detached, and views started
+   * with `acquireRemoteView` are stopped.
+   */
+  void attachLocalStream();
+  void detachLocalStream();
+  void attachRemoteUser(const char* userId);
+  void detachRemoteUser(const char* userId);
+
+  /**
+   * Reference-counted subscription of the video of `userId`, for components that subscribe on their own (gallery,
+   * view subscriber) and may show the same user at the same time. The first holder attaches the user and starts the
+   * remote view; the view receives the big stream while any holder wants it, the small stream otherwise. Acquiring
+   * again updates the holder's stream type. Once the last holder releases, the view is stopped, the user detached and
+   * its streams cleared. Game thread only.
+   */
+  void acquireRemoteView(const char* userId, const void* holder, TRTCVideoStreamType type);
+  void releaseRemoteView(const char* userId, const void* holder);
+
+  // How oversized frames are reduced; `TRTCDownscaleMode::PowerOfTwo` by default.
+  void setDownscaleMode(TRTCDownscaleMode mode);
+
+  /**
+   * Report the on-screen pixel size `consumer` shows `key` at. The stream is kept at the largest size reported by any
+   * consumer; a zero size means the consumer needs full resolution.
+   */
+  void setDisplaySize(const TRTCStreamKey& key, const void* consumer, uint32_t width, uint32_t height);
+  void removeConsumer(const TRTCStreamKey& key, const void* consumer);
+
+  /**
+   * Latest frame of `key`, or nullptr if none arrived since the stream was attached or cleared.
+   *
+   * The buffer is immutable and stays valid for as long as the caller holds it; hold it until any texture upload that
+   * reads it has completed.
+   * @param sequence Receives a counter that increases with every delivered frame, to skip redundant uploads.
+   */
+  std::shared_ptr<const TRTCFrameBuffer> latestFrame(const TRTCStreamKey& key, uint64_t* sequence = nullptr) const;
+
+  // Drop the latest frame of `key` (for example when its video becomes unavailable), keeping a small copy of it in
+  // the last-frame cache.
+  void clearStream(const TRTCStreamKey& key);
+  // Drop the latest frame of every stream, for example after leaving the room. The last-frame cache is emptied too.
+  void clearAllStreams();
+
+  /**
+   * Downscaled last frame of a cleared stream, to show while the stream resumes and until `latestFrame` returns a
+   * frame again; nullptr if none is cached.
+   */
+  std::shared_ptr<const TRTCFrameBuffer> cachedFrame(const TRTCStreamKey& key) { return last_frames_.find(key); }
+
+  // Size and memory limits of the cached last frames.
+  TRTCLastFrameCache& lastFrameCache() { return last_frames_; }
+
+  /**
+   * Register `tap` for the frames of every stream. `removeFrameTap` waits for calls in progress to return, so the tap
+   * can be destroyed right after it.
+   */
+  void addFrameTap(TRTCVideoFrameTap* tap);
+  void removeFrameTap(TRTCVideoFrameTap* tap);
+
+  // ITRTCVideoRenderCallback
+  void onRenderVideoFrame(const char* userId, TRTCVideoStreamType streamType, TRTCVideoFrame* frame) override;
+
+ private:
+  class LocalRenderCallback;
+  struct StreamSlot;
+
+  struct RemoteView {
+    std::map<const void*, TRTCVideoStreamType> holders;
+    // Type the view was started with, which `stopRemoteView` expects, and the type currently received.
+    TRTCVideoStreamType startedType = TRTCVideoStreamTypeBig;
+    TRTCVideoStreamType type = TRTCVideoStreamTypeBig;
+
+    TRTCVideoStreamType wantedType() const;
+  };
+
+  std::shared_ptr<StreamSlot> findSlot(const TRTCStreamKey& key, bool create) const;
+  void deliverFrame(const TRTCStreamKey& key, const TRTCVideoFrame& frame);
+
+  TRTCCloud* cloud_ = nullptr;
+  std::unique_ptr<LocalRenderCallback> local_callback_;
+  std::atomic<TRTCDownscaleMode> downscale_mode_{TRTCDownscaleMode::PowerOfTwo};
+  mutable FCriticalSection slots_mutex_;
+  mutable std::map<TRTCStreamKey, std::shared_ptr<StreamSlot>> slots_;
+  // Remote users routed to the hub, whether or not a frame or consumer created a slot for them yet. Under slots_mutex_.
+  std::set<std::string> attached_users_;
+  TRTCFrameBufferPool pool_;
+  TRTCLastFrameCache last_frames_;
+  std::map<std::string, RemoteView> remote_views_;
+  FRWLock taps_lock_;
+  std::vector<TRTCVideoFrameTap*> taps_;
+};
+
+}  // namespace ue
+}  // namespace liteav
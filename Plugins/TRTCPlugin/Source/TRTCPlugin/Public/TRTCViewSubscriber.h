@@ -0,0 +1,156 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "TRTCCloud.h"
+#include "TRTCRoster.h"
+#include "TRTCVideoFrameHub.h"
+
+namespace liteav {
+namespace ue {
+
+struct TRTCViewSubscriberConfig {
+  // How far ahead camera and participant motion are extrapolated; about the time a subscription takes to show video.
+  float lookaheadSeconds = 0.3f;
+  // Points in time, spread evenly up to `lookaheadSeconds`, where the predicted view is tested.
+  uint32_t lookaheadSteps = 3;
+  // Radius of the sphere bounding a participant, in world units.
+  float boundsRadius = 60.f;
+  // Participants at least this many pixels tall on screen subscribe the big stream; smaller ones the small stream.
+  float bigStreamMinHeight = 360.f;
+  // Seconds a participant stays subscribed after leaving the view, so that looking back and forth does not churn.
+  float unsubscribeDelay = 1.f;
+  // Most participants subscribed ahead of becoming visible at any time, soonest first.
+  uint32_t maxPredicted = 4;
+  // Weight of the newest sample in the smoothed camera and participant velocities.
+  float velocitySmoothing = 0.5f;
+};
+
+struct TRTCViewSubscriberStats {
+  uint32_t visible = 0;
+  uint32_t predicted = 0;
+  uint32_t subscribed = 0;
+  // Predicted subscriptions whose participant became visible, and those that expired without.
+  uint64_t predictionHits = 0;
+  uint64_t predictionMisses = 0;
+};
+
+//
+// Subscribes the video of participants placed in the world as they come into the camera's view.
+//
+// Visibility is a bounding sphere against the view frustum. On top of it, the camera's rotation and location and each
+// participant's position are extrapolated `lookaheadSeconds` ahead from their smoothed velocities, and participants
+// about to enter the view are subscribed to the small stream beforehand, up to `maxPredicted` of them, soonest first.
+// Their video then arrives at about the moment they become visible instead of starting from a placeholder plus the
+// keyframe delay, without subscribing the whole room. Visible participants get the big stream once they are shown
+// `bigStreamMinHeight` pixels tall, and everybody is unsubscribed `unsubscribeDelay` seconds after leaving the view,
+// like the gallery does.
+//
+// Subscriptions go through the hub's shared remote views, so participants also shown elsewhere (e.g. in a gallery on
+// the same hub) keep their video when the subscriber lets go of them.
+//
+// Game thread only. Call `setParticipant` for every participant that has moved, then `tick` once per frame with the
+// view of the player's camera. The hub and roster must outlive the subscriber.
+//
+class TRTCPLUGIN_API TRTCViewSubscriber {
+ public:
+  TRTCViewSubscriber(TRTCVideoFrameHub& hub,
+                     const TRTCRoster& roster,
+                     const TRTCViewSubscriberConfig& config = TRTCViewSubscriberConfig());
+  TRTCViewSubscriber(const TRTCViewSubscriber&) = delete;
+  TRTCViewSubscriber& operator=(const TRTCViewSubscriber&) = delete;
+  // Stops every subscription.
+  ~TRTCViewSubscriber();
+
+  // World location of the participant's video, typically the head of the actor representing them.
+  void setParticipant(TRTCUserHandle handle, const FVector& location);
+  void removeParticipant(TRTCUserHandle handle);
+
+  /**
+   * Update subscriptions for a camera at `location` looking along `rotation`, with a horizontal field of view of
+   * `fovDegrees` and a viewport of `viewportWidth` by `viewportHeight` pixels.
+   */
+  void tick(const FVector& location,
+            const FRotator& rotation,
+            float fovDegrees,
+            float viewportWidth,
+            float viewportHeight);
+
+  // Stream type the participant is subscribed to; false when not subscribed.
+  bool subscribedType(TRTCUserHandle handle, TRTCVideoStreamType* type) const;
+
+  TRTCViewSubscriberStats stats() const { return stats_; }
+
+ private:
+  struct Participant {
+    TRTCUserHandle handle = kTRTCInvalidUserHandle;
+    std::string userId;
+    FVector location = FVector::ZeroVector;
+    FVector velocity = FVector::ZeroVector;
+    double lastMoved = 0;
+    // Location and time the velocity was last measured from; updates closer than the minimum interval only move
+    // `location`.
+    FVector sampledLocation = FVector::ZeroVector;
+    double sampledAt = 0;
+    bool placed = false;
+  };
+
+  struct Subscription {
+    TRTCVideoStreamType type = TRTCVideoStreamTypeSmall;
+    double lastWanted = 0;
+    // Subscribed ahead of time and not visible yet.
+    bool predicted = false;
+  };
+
+  struct View {
+    FVector location;
+    FVector forward;
+    FVector right;
+    FVector up;
+    float tanHalfX;
+    float tanHalfY;
+    float viewportHeight;
+  };
+
+  static View makeView(const FVector& location,
+                       const FRotator& rotation,
+                       float fovDegrees,
+                       float aspect,
+                       float viewportHeight);
+  // Pixel height of a participant at `location` in `view`, or a negative value when outside it.
+  float projectedHeight(const View& view, const FVector& location) const;
+  void want(const std::string& userId, TRTCVideoStreamType type, bool predicted, double now);
+  void expire(double now, bool all);
+
+  TRTCVideoFrameHub& hub_;
+  const TRTCRoster& roster_;
+  const TRTCViewSubscriberConfig config_;
+
+  // Indexed by roster slot.
+  std::vector<Participant> participants_;
+  std::map<std::string, Subscription> subscriptions_;
+  // Scratch list of (time until visible, slot) of the participants predicted to come into view.
+  std::vector<std::pair<float, uint32_t>> upcoming_;
+  // Predicted views at each lookahead step.
+  std::vector<View> predicted_views_;
+
+  bool has_camera_ = false;
+  double last_tick_ = 0;
+  FVector camera_location_ = FVector::ZeroVector;
+  FRotator camera_rotation_ = FRotator::ZeroRotator;
+  FVector camera_velocity_ = FVector::ZeroVector;
+  // Yaw and pitch rates in degrees per second.
+  float yaw_rate_ = 0;
+  float pitch_rate_ = 0;
+
+  TRTCViewSubscriberStats stats_;
+};
+
+}  // namespace ue
+}  // namespace liteav
@@ -0,0 +1,153 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "TRTCAudioFrameHub.h"
+
+namespace Audio {
+class IFFTAlgorithm;
+}
+
+namespace liteav {
+namespace ue {
+
+// Voice bands of `TRTCVisemeFeatures::bands`: 80-300 Hz, 300-1000 Hz, 1000-2500 Hz and 2500-8000 Hz.
+constexpr uint32_t kTRTCVisemeBands = 4;
+
+// Mouth shapes, coarse enough to be told apart from the spectrum alone.
+enum class TRTCViseme : uint8_t {
+  Silence,
+  // M, B, P: lips closed on quiet voicing.
+  Closed,
+  // A: jaw open, energy around the first formant.
+  Open,
+  // O, U: rounded lips, energy low in the spectrum.
+  Round,
+  // E, I: spread lips, energy around the second formant.
+  Spread,
+  // S, F, TH: narrow opening, energy above the voice.
+  Fricative,
+  Count,
+};
+
+constexpr uint32_t kTRTCVisemeCount = static_cast<uint32_t>(TRTCViseme::Count);
+
+struct TRTCVisemeConfig {
+  // Hop levels that count as silence and as full voice; weights and mouth opening scale in between.
+  float silenceDb = -55.f;
+  float speechDb = -25.f;
+  // Fraction of the way to a new value covered per 10 ms hop when the value rises and when it falls.
+  float attack = 0.6f;
+  float release = 0.25f;
+  // Results older than this read as silence, so mouths close when a user's audio stops arriving.
+  double staleSeconds = 0.2;
+  // Users whose audio stopped this long ago are forgotten.
+  double forgetSeconds = 10.0;
+  // Blocks the hub may queue for the analyzer before it skips ahead.
+  uint32_t queueBlocks = 64;
+};
+
+struct TRTCVisemeFeatures {
+  // Level of the latest 10 ms hop, in dBFS.
+  float energyDb = -100.f;
+  // Share of the voice energy in each band, summing to 1 while anything is heard.
+  float bands[kTRTCVisemeBands] = {};
+  float centroidHz = 0.f;
+  // Smoothed jaw opening, from 0 (closed) to 1.
+  float mouthOpen = 0.f;
+  // Smoothed weight of each `TRTCViseme`, summing to about 1; meant to drive morph targets directly.
+  float weights[kTRTCVisemeCount] = {1.f};
+  // Viseme with the largest weight.
+  TRTCViseme viseme = TRTCViseme::Silence;
+  // Hops analysed for the user, so readers can tell whether anything changed since the last tick.
+  uint32_t sequence = 0;
+};
+
+struct TRTCVisemeResult {
+  std::string userId;
+  TRTCVisemeFeatures features;
+};
+
+struct TRTCVisemeStats {
+  uint64_t hops = 0;
+  // Analysis cost per 10 ms hop of one user, averaged over the analyzer's life.
+  double averageHopMicroseconds = 0;
+  uint32_t speakers = 0;
+};
+
+//
+// Lip-sync features of every remote speaker, for avatar mouth animation.
+//
+// Add it to the cloud's `TRTCAudioFrameHub` with `consumerOptions()`: the hub resamples remote audio to 16 kHz mono
+// once and delivers it on the analyzer's own queue thread, so analysis never runs on SDK or game threads. Every 10 ms
+// of a user's audio is analysed over a 16 ms Hann window with the engine's FFT (vectorised on every platform): hop
+// energy, the share of energy in four voice bands and the spectral centroid, from which a viseme is estimated. The
+// estimate is a heuristic on formant regions, which is enough to make mouths move plausibly; it is not phoneme
+// recognition. One hop costs a few microseconds per user.
+//
+// Game-thread readers fetch the latest results once per tick with `latest` or `snapshot`.
+//
+class TRTCPLUGIN_API TRTCVisemeAnalyzer : public TRTCAudioFrameConsumer {
+ public:
+  static constexpr uint32_t kSampleRate = 16000;
+  static constexpr uint32_t kHopFrames = kSampleRate / 100;
+  static constexpr uint32_t kWindowFrames = 256;
+
+  explicit TRTCVisemeAnalyzer(const TRTCVisemeConfig& config = TRTCVisemeConfig());
+  TRTCVisemeAnalyzer(const TRTCVisemeAnalyzer&) = delete;
+  TRTCVisemeAnalyzer& operator=(const TRTCVisemeAnalyzer&) = delete;
+  ~TRTCVisemeAnalyzer() override;
+
+  // Options to add the analyzer to a `TRTCAudioFrameHub` with.
+  TRTCAudioConsumerOptions consumerOptions() const;
+
+  // Latest features of `userId`. Returns false if nothing was heard from the user recently enough to be remembered.
+  bool latest(const char* userId, TRTCVisemeFeatures& features) const;
+
+  // Latest features of every known user. `results` is reused, so calling this every tick does not allocate.
+  void snapshot(std::vector<TRTCVisemeResult>& results) const;
+
+  TRTCVisemeStats stats() const;
+
+  // TRTCAudioFrameConsumer
+  void onAudioBlock(const TRTCAudioBlock& block) override;
+
+ private:
+  struct Speaker;
+  struct Published {
+    TRTCVisemeFeatures features;
+    double updated = 0;
+  };
+
+  void analyze(Speaker& speaker);
+  void forgetIdle(double now);
+  TRTCVisemeFeatures current(const Published& published, double now) const;
+
+  const TRTCVisemeConfig config_;
+
+  // Analysis state, only touched by the hub's delivery thread of the analyzer.
+  TUniquePtr<Audio::IFFTAlgorithm> fft_;
+  std::vector<float> window_;
+  std::vector<float> windowed_;
+  std::vector<float> spectrum_;
+  std::map<std::string, std::unique_ptr<Speaker>, std::less<>> speakers_;
+  double last_sweep_ = 0;
+
+  mutable FCriticalSection mutex_;
+  // Written by the delivery thread, read by game-thread readers. Entries are only erased by the delivery thread.
+  std::map<std::string, Published, std::less<>> published_;
+
+  std::atomic<uint64_t> hops_{0};
+  std::atomic<uint64_t> analysis_cycles_{0};
+};
+
+}  // namespace ue
+}  // namespace liteav
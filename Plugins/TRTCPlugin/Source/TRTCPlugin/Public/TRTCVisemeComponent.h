@@ -0,0 +1,92 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <string>
+
+#include "Components/ActorComponent.h"
+#include "CoreMinimal.h"
+#include "TRTCVisemeAnalyzer.h"
+
+#include "TRTCVisemeComponent.generated.h"
+
+// Blueprint mirror of `liteav::ue::TRTCViseme`.
+UENUM(BlueprintType)
+enum class ETRTCViseme : uint8 {
+  Silence,
+  Closed,
+  Open,
+  Round,
+  Spread,
+  Fricative,
+};
+
+static_assert(static_cast<uint32>(ETRTCViseme::Fricative) + 1 == liteav::ue::kTRTCVisemeCount,
+              "ETRTCViseme must list the visemes of TRTCViseme in the same order");
+
+// Lip-sync state of one speaker for the current frame.
+USTRUCT(BlueprintType)
+struct FTRTCVisemeFrame {
+  GENERATED_BODY()
+
+  UPROPERTY(BlueprintReadOnly, Category = "TRTC")
+  ETRTCViseme Viseme = ETRTCViseme::Silence;
+
+  // Smoothed jaw opening, from 0 to 1.
+  UPROPERTY(BlueprintReadOnly, Category = "TRTC")
+  float MouthOpen = 0.f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "TRTC")
+  float EnergyDb = -100.f;
+
+  // Smoothed weights of the mouth shapes, for morph targets.
+  UPROPERTY(BlueprintReadOnly, Category = "TRTC")
+  float Closed = 0.f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "TRTC")
+  float Open = 0.f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "TRTC")
+  float Round = 0.f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "TRTC")
+  float Spread = 0.f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "TRTC")
+  float Fricative = 0.f;
+};
+
+/**
+ * Exposes the lip-sync features of one remote user to animation blueprints.
+ *
+ * Pulls the latest result from a `TRTCVisemeAnalyzer` once per tick, before animation is evaluated, so the blueprint
+ * reads a plain struct and never touches audio data.
+ */
+UCLASS(ClassGroup = (TRTC), meta = (BlueprintSpawnableComponent))
+class TRTCPLUGIN_API UTRTCVisemeComponent : public UActorComponent {
+  GENERATED_BODY()
+
+ public:
+  UTRTCVisemeComponent(const FObjectInitializer& ObjectInitializer);
+
+  /**
+   * Follow `UserId` in `InAnalyzer`. A null analyzer or empty id leaves the mouth closed. The analyzer must outlive
+   * the component or be reset with nullptr.
+   */
+  void SetSource(liteav::ue::TRTCVisemeAnalyzer* InAnalyzer, const FString& UserId);
+
+  UFUNCTION(BlueprintPure, Category = "TRTC")
+  FTRTCVisemeFrame GetVisemeFrame() const { return Frame; }
+
+  UFUNCTION(BlueprintPure, Category = "TRTC")
+  bool IsSpeaking() const { return Frame.Viseme != ETRTCViseme::Silence; }
+
+  void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+ private:
+  UPROPERTY()
+  FTRTCVisemeFrame Frame;
+
+  liteav::ue::TRTCVisemeAnalyzer* Analyzer = nullptr;
+  std::string SourceUserId;
+};
@@ -0,0 +1,57 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Components/SynthComponent.h"
+#include "CoreMinimal.h"
+#include "TRTCAudioJitterBuffer.h"
+#include "TRTCVoiceRouter.h"
+
+#include "TRTCVoiceComponent.generated.h"
+
+/**
+ * Plays the voice of one remote user as a spatialized sound source.
+ *
+ * Attached to the actor representing the user, the voice goes through the engine's attenuation, occlusion, reverb and
+ * submix routing like any other sound. Audio arrives from a `TRTCVoiceRouter` through a lock-free jitter buffer, so the
+ * audio render thread never waits on the SDK; any number of components (32 and more) can play concurrently.
+ *
+ * Mute the SDK's own playout (`setAudioPlayoutVolume(0)`) so that voices are not heard twice.
+ */
+UCLASS(ClassGroup = (TRTC), meta = (BlueprintSpawnableComponent))
+class TRTCPLUGIN_API UTRTCVoiceComponent : public USynthComponent {
+  GENERATED_BODY()
+
+ public:
+  UTRTCVoiceComponent(const FObjectInitializer& ObjectInitializer);
+
+  /**
+   * Play the audio `Router` receives for `UserId`. An empty `UserId` or null `Router` stops receiving. Whatever was
+   * buffered for the previous user is discarded.
+   */
+  void SetSource(liteav::ue::TRTCVoiceRouter* InRouter, const FString& UserId);
+
+  // Create a started voice component for `UserId`, attached to the root component of `Owner`.
+  static UTRTCVoiceComponent* CreateForActor(AActor* Owner,
+                                             liteav::ue::TRTCVoiceRouter* InRouter,
+                                             const FString& UserId);
+
+  liteav::ue::TRTCAudioJitterStats GetJitterStats() const { return Buffer->stats(); }
+
+ protected:
+  bool Init(int32& SampleRate) override;
+  int32 OnGenerateAudio(float* OutAudio, int32 NumSamples) override;
+  void OnUnregister() override;
+
+ private:
+  // Created once and never replaced, so the audio render thread can use it without synchronisation; the router holds
+  // a reference too, so a late SDK callback never writes into a destroyed buffer.
+  std::shared_ptr<liteav::ue::TRTCAudioJitterBuffer> Buffer;
+  liteav::ue::TRTCVoiceRouter* Router = nullptr;
+  std::string RoutedUserId;
+  // Written in Init, before the audio render thread generates audio.
+  int32 OutputSampleRate = 48000;
+};
@@ -0,0 +1,148 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "CoreMinimal.h"
+#include "TRTCAudioFrameHub.h"
+
+namespace liteav {
+namespace ue {
+
+constexpr uint32_t kTRTCVoiceEqBands = 3;
+
+// Peaking equalizer band.
+struct TRTCVoiceEqBand {
+  float frequencyHz = 1000.f;
+  float gainDb = 0.f;
+  float q = 1.f;
+};
+
+struct TRTCVoiceProcessorParams {
+  // Second-order high-pass removing rumble and handling noise.
+  bool highPassEnabled = true;
+  float highPassHz = 80.f;
+
+  bool eqEnabled = false;
+  TRTCVoiceEqBand eq[kTRTCVoiceEqBands] = {{250.f, 0.f, 0.7f}, {1500.f, 0.f, 1.f}, {5000.f, 0.f, 0.7f}};
+
+  // Noise gate: attenuates by `gateRangeDb` once the level stays under the threshold for the hold time.
+  bool gateEnabled = true;
+  float gateThresholdDb = -50.f;
+  float gateRangeDb = 30.f;
+  float gateHoldMs = 120.f;
+
+  // Downward compressor on the envelope.
+  bool compressorEnabled = true;
+  float compressorThresholdDb = -18.f;
+  float compressorRatio = 3.f;
+
+  // Slow gain that brings speech towards `agcTargetDb`; only adapts while the gate is open.
+  bool agcEnabled = true;
+  float agcTargetDb = -20.f;
+  float agcMaxGainDb = 12.f;
+
+  // Processing time allowed per captured frame. Frames over it three times in a row bypass the chain for two
+  // seconds, so a starved device degrades to unprocessed audio instead of capture glitches. Zero disables the check.
+  float cpuBudgetMicroseconds = 1000.f;
+};
+
+struct TRTCVoiceProcessorStats {
+  uint64_t processedFrames = 0;
+  uint64_t bypassedFrames = 0;
+  // Times the CPU budget made the chain bypass itself.
+  uint64_t budgetBypasses = 0;
+  float lastMicroseconds = 0.f;
+  bool gateOpen = false;
+  float agcGainDb = 0.f;
+};
+
+//
+// Voice processing chain run in place on the captured microphone audio: high-pass, equalizer, noise gate, compressor
+// and automatic gain control, each enabled separately.
+//
+// Install it with `TRTCAudioFrameHub::setCaptureProcessor`. The filters run as one four-section biquad cascade whose
+// sections occupy the lanes of a SIMD register, one sample apart, so a frame costs one vector step per sample and
+// channel (with three samples of latency); gate, compressor and AGC share one stereo-linked envelope and compute their
+// gain at a control rate of 32 samples. Nothing allocates or locks on the capture thread: parameters are published by
+// `setParams` through a triple buffer and picked up at the next frame, which also recomputes the coefficients.
+//
+class TRTCPLUGIN_API TRTCVoiceProcessor : public TRTCAudioFrameProcessor {
+ public:
+  TRTCVoiceProcessor();
+  TRTCVoiceProcessor(const TRTCVoiceProcessor&) = delete;
+  TRTCVoiceProcessor& operator=(const TRTCVoiceProcessor&) = delete;
+
+  // Publish new parameters. Calls must not overlap, typically they all come from the game thread.
+  void setParams(const TRTCVoiceProcessorParams& params);
+
+  TRTCVoiceProcessorStats stats() const;
+
+  // TRTCAudioFrameProcessor
+  void processCapturedAudio(int16_t* pcm, uint32_t frames, uint32_t channels, uint32_t sampleRate) override;
+
+ private:
+  static constexpr uint32_t kMaxChannels = 2;
+  static constexpr uint32_t kFresh = 4;
+  static constexpr uint32_t kSlotMask = 3;
+
+  // Biquad cascade state of one channel. `lanes[0]` is the input sample, `lanes[1..4]` the section outputs.
+  struct alignas(16) Channel {
+    VectorRegister4Float s1;
+    VectorRegister4Float s2;
+    float lanes[8];
+  };
+
+  void configure(const TRTCVoiceProcessorParams& params, uint32_t sampleRate);
+  void resetState();
+  void updateDynamics();
+  void run(int16_t* pcm, uint32_t frames, uint32_t channels);
+
+  // Triple buffer: the writer fills `params_[back_]`, the reader uses `params_[front_]`, and `middle_` swaps between
+  // them with `kFresh` set when it holds parameters the reader has not seen.
+  TRTCVoiceProcessorParams params_[3];
+  std::atomic<uint32_t> middle_{1};
+  uint32_t back_ = 2;
+  uint32_t front_ = 0;
+
+  // Capture thread state.
+  TRTCVoiceProcessorParams active_;
+  uint32_t sample_rate_ = 0;
+  bool filtering_ = false;
+  VectorRegister4Float b0_;
+  VectorRegister4Float b1_;
+  VectorRegister4Float b2_;
+  VectorRegister4Float a1_;
+  VectorRegister4Float a2_;
+  Channel channels_[kMaxChannels];
+  float envelope_ = 0.f;
+  float envelope_attack_ = 0.f;
+  float envelope_release_ = 0.f;
+  float gate_open_level_ = 0.f;
+  float gate_floor_ = 1.f;
+  float gate_gain_ = 1.f;
+  float gate_attack_ = 1.f;
+  float gate_release_ = 1.f;
+  uint32_t gate_hold_samples_ = 0;
+  uint32_t gate_hold_ = 0;
+  float dynamics_gain_ = 1.f;
+  float dynamics_target_ = 1.f;
+  float dynamics_smoothing_ = 1.f;
+  float agc_gain_db_ = 0.f;
+  float agc_step_db_ = 0.f;
+  uint32_t control_phase_ = 0;
+  uint32_t over_budget_ = 0;
+  double bypass_until_ = 0;
+
+  std::atomic<uint64_t> processed_frames_{0};
+  std::atomic<uint64_t> bypassed_frames_{0};
+  std::atomic<uint64_t> budget_bypasses_{0};
+  std::atomic<float> last_microseconds_{0.f};
+  std::atomic<bool> gate_open_{false};
+  std::atomic<float> agc_gain_{0.f};
+};
+
+}  // namespace ue
+}  // namespace liteav
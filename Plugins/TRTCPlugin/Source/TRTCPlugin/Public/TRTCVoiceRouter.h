@@ -0,0 +1,52 @@
+// Copyright (c) 2022 Tencent. All rights reserved.
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+#include "TRTCAudioFrameHub.h"
+#include "TRTCAudioJitterBuffer.h"
+
+namespace liteav {
+namespace ue {
+
+//
+// Delivers the decoded audio of every remote user to the jitter buffer routed for that user, typically the one of a
+// `UTRTCVoiceComponent` attached to the user's actor.
+//
+// Add it to the cloud's `TRTCAudioFrameHub` with `consumerOptions()`; the hub hands it mono float blocks inline, so
+// voices reach their buffers without another copy or thread hop. Routes change on the game thread under a
+// reader-writer lock that SDK threads only share for reading; the audio render threads only ever touch the jitter
+// buffers, which are lock-free.
+//
+class TRTCPLUGIN_API TRTCVoiceRouter : public TRTCAudioFrameConsumer {
+ public:
+  TRTCVoiceRouter() = default;
+  TRTCVoiceRouter(const TRTCVoiceRouter&) = delete;
+  TRTCVoiceRouter& operator=(const TRTCVoiceRouter&) = delete;
+
+  // Send the audio of `userId` to `buffer`, replacing an earlier route of that user.
+  void route(const char* userId, std::shared_ptr<TRTCAudioJitterBuffer> buffer);
+
+  // Stop routing `userId`; with `buffer` set, only if the user is still routed to that buffer.
+  void unroute(const char* userId, const TRTCAudioJitterBuffer* buffer = nullptr);
+
+  // Options to register the router with: remote audio as mono float at the delivered rate, inline.
+  static TRTCAudioConsumerOptions consumerOptions();
+
+  // TRTCAudioFrameConsumer
+  void onAudioBlock(const TRTCAudioBlock& block) override;
+
+ private:
+  FRWLock lock_;
+  // Transparent comparator, so SDK threads look user ids up without building a std::string.
+  std::map<std::string, std::shared_ptr<TRTCAudioJitterBuffer>, std::less<>> routes_;
+};
+
+}  // namespace ue
+}  // namespace liteav
@@ -25,6 +25,10 @@ public class TRTCPlugin : ModuleRules
 			new string[]
 			{
 				"Core",
+				"CoreUObject",
+				"Engine",
+				"UMG",
+				"AudioMixer",
 				"TRTCSDK",
 
 				// Test Only
@@ -35,10 +39,10 @@ public class TRTCPlugin : ModuleRules
 		PrivateDependencyModuleNames.AddRange(
 			new string[]
 			{
-				"CoreUObject",
-				"Engine",
 				"Slate",
 				"SlateCore",
+				"ImageWrapper",
+				"SignalProcessing",
 			}
 			);
 
@@ -21,6 +21,7 @@ void UBtnTRTCUserWidget::NativeConstruct() {
   pTRTCCloud = liteav::ue::TRTCCloud::getSharedInstance();
 #endif
   pTRTCCloud->addCallback(this);
+  videoHub = std::make_unique<trtc::ue::TRTCVideoFrameHub>(pTRTCCloud);
   std::string version = pTRTCCloud->getSDKVersion();
   BtnEnterRoom->OnClicked.AddDynamic(this, &UBtnTRTCUserWidget::OnEnterRoom_Click);
   BtnExitRoom->OnClicked.AddDynamic(this, &UBtnTRTCUserWidget::OnExitRoom_Click);
@@ -43,13 +44,10 @@ void UBtnTRTCUserWidget::NativeDestruct() {
   if (pTRTCCloud != nullptr) {
     pTRTCCloud->exitRoom();
     pTRTCCloud->removeCallback(this);
+    videoHub.reset();
     pTRTCCloud->destroySharedInstance();
     pTRTCCloud = nullptr;
   }
-  delete[] localBuffer;
-  delete localUpdateTextureRegion;
-  delete[] remoteBuffer;
-  delete remoteUpdateTextureRegion;
 }
 
 void UBtnTRTCUserWidget::OnEnterRoom_Click() {
@@ -86,230 +84,73 @@ void UBtnTRTCUserWidget::OnStartLocalPreview_Click() {
 #else
   pTRTCCloud->startLocalPreview(nullptr);
 #endif
-#if PLATFORM_ANDROID
-  pTRTCCloud->setLocalVideoRenderCallback(trtc::TRTCVideoPixelFormat_RGBA32, trtc::TRTCVideoBufferType_Buffer, this);
-#else
-  pTRTCCloud->setLocalVideoRenderCallback(trtc::TRTCVideoPixelFormat_BGRA32, trtc::TRTCVideoBufferType_Buffer, this);
-#endif
+  videoHub->attachLocalStream();
+  localPreviewStarted = true;
+  // Refresh once so the cached last frame shows until the camera delivers
+  localFrameSequence = ~0ull;
   writeLblLog("end OnStartLocalPreview_Click");
 }
 
 void UBtnTRTCUserWidget::OnStopLocalPreview_Click() {
   writeLblLog("start OnStopLocalPreview_Click");
   pTRTCCloud->stopLocalPreview();
-  ResetBuffer(true);
-  if (localBuffer) {
-    localRenderTargetTexture->UpdateTextureRegions(0, 1, localUpdateTextureRegion, localWidth * 4, (uint32)4,
-                                                   localBuffer);
+  localPreviewStarted = false;
+  videoHub->clearStream(trtc::ue::TRTCStreamKey(nullptr, trtc::TRTCVideoStreamTypeBig));
+}
+
+void UBtnTRTCUserWidget::RefreshView(const trtc::ue::TRTCStreamKey& key,
+                                     UImage* image,
+                                     UTexture2D*& texture,
+                                     FSlateBrush& brush,
+                                     uint64& sequence,
+                                     bool available) {
+  if (!image || !videoHub) {
+    return;
   }
-}
-
-void UBtnTRTCUserWidget::onRenderVideoFrame(const char* userId,
-                                            trtc::TRTCVideoStreamType streamType,
-                                            trtc::TRTCVideoFrame* videoFrame) {
-  int frameLength = videoFrame->length;
-  std::string strUserId(TCHAR_TO_UTF8(*fLocalUserId));
-  if (LocalPreviewImage && RemoteImage && frameLength > 1) {
-    bool isLocalUser = ((strcmp(strUserId.c_str(), userId) == 0 || nullptr == userId || strlen(userId) == 0) &&
-                        streamType == trtc::TRTCVideoStreamTypeBig)
-                           ? true
-                           : false;
-    UpdateBuffer(videoFrame->data, videoFrame->width, videoFrame->height, frameLength, isLocalUser);
+  // Let the plugin downscale oversized frames to what the image actually covers on screen
+  FVector2D displaySize = image->GetCachedGeometry().GetAbsoluteSize();
+  videoHub->setDisplaySize(key, image, (uint32)displaySize.X, (uint32)displaySize.Y);
+
+  uint64 latestSequence = 0;
+  std::shared_ptr<const trtc::ue::TRTCFrameBuffer> frame = videoHub->latestFrame(key, &latestSequence);
+  if (latestSequence == sequence) {
+    return;
   }
-}
-
-void UBtnTRTCUserWidget::UpdateBuffer(char* RGBBuffer,
-                                      uint32_t NewWidth,
-                                      uint32_t NewHeight,
-                                      uint32_t NewSize,
-                                      bool isLocal) {
-  if (isLocal) {
-    FScopeLock lock(&localMutex);
-    if (!RGBBuffer) {
-      return;
-    }
-    if (NewHeight != localHeight) {
-      UE_LOG(LogTemp, Warning, TEXT("NewHeight != localHeight ,localHeight=%d, NewHeight=%d"), localHeight, NewHeight);
-    }
-    if (!localRefresh) {
-      // First Local Video Frame
-      UE_LOG(LogTemp, Warning, TEXT("localRefresh==false; NewSize=%d ,NewWidth=%d, NewHeight=%d"), NewSize, NewWidth,
-             NewHeight);
-      localRefresh = true;
-      AsyncTask(ENamedThreads::GameThread, [=]() {
-        localWidth = NewWidth;
-        localHeight = NewHeight;
-#if PLATFORM_ANDROID
-        localRenderTargetTexture = UTexture2D::CreateTransient(localWidth, localHeight, PF_R8G8B8A8);
-#else
-                    localRenderTargetTexture = UTexture2D::CreateTransient(localWidth, localHeight);
-#endif
-        localRenderTargetTexture->UpdateResource();
-        localBufferSize = localWidth * localHeight * 4;
-        localBuffer = new uint8[localBufferSize];
-        for (uint32 i = 0; i < localWidth * localHeight; ++i) {
-          localBuffer[i * 4 + 0] = 0x32;
-          localBuffer[i * 4 + 1] = 0x32;
-          localBuffer[i * 4 + 2] = 0x32;
-          localBuffer[i * 4 + 3] = 0xFF;
-        }
-        localUpdateTextureRegion = new FUpdateTextureRegion2D(0, 0, 0, 0, localWidth, localHeight);
-        localRenderTargetTexture->UpdateTextureRegions(0, 1, localUpdateTextureRegion, localWidth * 4, (uint32)4,
-                                                       localBuffer);
-        localBrush.SetResourceObject(localRenderTargetTexture);
-        LocalPreviewImage->SetBrush(localBrush);
-      });
-      return;
-    }
-    if (localBufferSize == NewSize) {
-      localWidth = NewWidth;
-      localHeight = NewHeight;
-      std::copy(RGBBuffer, RGBBuffer + NewSize, localBuffer);
-    } else {
-      delete[] localBuffer;
-      localBufferSize = NewSize;
-      localWidth = NewWidth;
-      localHeight = NewHeight;
-      localBuffer = new uint8[localBufferSize];
-      std::copy(RGBBuffer, RGBBuffer + NewSize, localBuffer);
-    }
-    localRefresh = true;
-  } else {
-    FScopeLock lock(&remoteMutex);
-    if (!RGBBuffer) {
-      return;
-    }
-    if (NewHeight != remoteHeight) {
-      UE_LOG(LogTemp, Warning, TEXT("NewHeight != remoteHeight ,remoteHeight=%d, NewHeight=%d"), remoteHeight,
-             NewHeight);
-    }
-    if (!remoteRefresh) {
-      // Fist Remote User Video Frame
-      UE_LOG(LogTemp, Warning, TEXT("remoteRefresh==false; NewSize=%d ,NewWidth=%d, NewHeight=%d"), NewSize, NewWidth,
-             NewHeight);
-      remoteRefresh = true;
-      AsyncTask(ENamedThreads::GameThread, [=]() {
-        remoteWidth = NewWidth;
-        remoteHeight = NewHeight;
-#if PLATFORM_ANDROID
-        remoteRenderTargetTexture = UTexture2D::CreateTransient(remoteWidth, remoteHeight, PF_R8G8B8A8);
-#else
-                    remoteRenderTargetTexture = UTexture2D::CreateTransient(remoteWidth, remoteHeight);
-#endif
-        remoteRenderTargetTexture->UpdateResource();
-        remoteBufferSize = remoteWidth * remoteHeight * 4;
-        remoteBuffer = new uint8[remoteBufferSize];
-        for (uint32 i = 0; i < remoteWidth * remoteHeight; ++i) {
-          remoteBuffer[i * 4 + 0] = 0x32;
-          remoteBuffer[i * 4 + 1] = 0x32;
-          remoteBuffer[i * 4 + 2] = 0x32;
-          remoteBuffer[i * 4 + 3] = 0xFF;
-        }
-        remoteUpdateTextureRegion = new FUpdateTextureRegion2D(0, 0, 0, 0, remoteWidth, remoteHeight);
-        remoteRenderTargetTexture->UpdateTextureRegions(0, 1, remoteUpdateTextureRegion, remoteWidth * 4, (uint32)4,
-                                                        remoteBuffer);
-        remoteBrush.SetResourceObject(remoteRenderTargetTexture);
-        RemoteImage->SetBrush(remoteBrush);
-      });
-      return;
-    }
-    if (remoteBufferSize == NewSize) {
-      remoteWidth = NewWidth;
-      remoteHeight = NewHeight;
-      std::copy(RGBBuffer, RGBBuffer + NewSize, remoteBuffer);
-    } else {
-      delete[] remoteBuffer;
-      remoteBufferSize = NewSize;
-      remoteWidth = NewWidth;
-      remoteHeight = NewHeight;
-      remoteBuffer = new uint8[remoteBufferSize];
-      std::copy(RGBBuffer, RGBBuffer + NewSize, remoteBuffer);
-    }
-    remoteRefresh = true;
+  sequence = latestSequence;
+  if (!frame && available) {
+    // Stream resuming: show its last frame from before it stopped instead of grey until the first new frame
+    frame = videoHub->cachedFrame(key);
   }
-}
-
-void UBtnTRTCUserWidget::ResetBuffer(bool isLocal) {
-  if (isLocal && localBuffer) {
-    for (uint32 i = 0; i < localWidth * localHeight; ++i) {
-      localBuffer[i * 4 + 0] = 0x32;
-      localBuffer[i * 4 + 1] = 0x32;
-      localBuffer[i * 4 + 2] = 0x32;
-      localBuffer[i * 4 + 3] = 0xFF;
-    }
-    localRefresh = false;
-  } else if (remoteBuffer) {
-    for (uint32 i = 0; i < remoteWidth * remoteHeight; ++i) {
-      remoteBuffer[i * 4 + 0] = 0x32;
-      remoteBuffer[i * 4 + 1] = 0x32;
-      remoteBuffer[i * 4 + 2] = 0x32;
-      remoteBuffer[i * 4 + 3] = 0xFF;
+  if (!frame) {
+    // Stream stopped, show the grey placeholder
+    if (texture) {
+      auto placeholder = std::make_shared<trtc::ue::TRTCFrameBuffer>(trtc::ue::kTRTCNativePixelFormat,
+                                                                     texture->GetSizeX(), texture->GetSizeY());
+      trtc::ue::fillFramePlaceholder(placeholder->view());
+      trtc::ue::uploadFrame(texture, placeholder->view(), [placeholder]() {});
     }
-    remoteRefresh = false;
+    return;
+  }
+  if (!texture || (uint32)texture->GetSizeX() != frame->width() || (uint32)texture->GetSizeY() != frame->height()) {
+    UE_LOG(LogTemp, Warning, TEXT("frame size changed, userId=%s, width=%d, height=%d"),
+           UTF8_TO_TCHAR(key.userId.c_str()), frame->width(), frame->height());
+    texture = trtc::ue::createFrameTexture(frame->format(), frame->width(), frame->height());
+    brush.SetResourceObject(texture);
+    image->SetBrush(brush);
   }
+  // The frame buffer stays referenced until the render thread has consumed it
+  trtc::ue::uploadFrame(texture, frame->view(), [frame]() {});
 }
 
 void UBtnTRTCUserWidget::NativeTick(const FGeometry& MyGeometry, float DeltaTime) {
   Super::NativeTick(MyGeometry, DeltaTime);
   // Update Local Preview
-  if (localRefresh && localRenderTargetTexture && localBuffer && LocalPreviewImage && localBufferSize > 4) {
-    FScopeLock lock(&localMutex);
-    if (localRenderTargetTexture->GetSizeX() != localWidth || localRenderTargetTexture->GetSizeY() != localHeight) {
-      UE_LOG(LogTemp, Warning,
-             TEXT("localBufferSize=%d ,localWidth=%d, localHeight=%d localRenderTargetTexture->GetSizeX =%d , "
-                  "localRenderTargetTexture->GetSizeY =%d"),
-             localBufferSize, localWidth, localHeight, localRenderTargetTexture->GetSizeX(),
-             localRenderTargetTexture->GetSizeY());
-      auto NewUpdateTextureRegion = new FUpdateTextureRegion2D(0, 0, 0, 0, localWidth, localHeight);
-// PF_R8G8B8A8
-// macos PF_B8G8R8A8 --> TRTCVideoPixelFormat_BGRA32
-#if PLATFORM_ANDROID
-      auto NewRenderTargetTexture = UTexture2D::CreateTransient(localWidth, localHeight, PF_R8G8B8A8);
-#else
-      auto NewRenderTargetTexture = UTexture2D::CreateTransient(localWidth, localHeight);
-#endif
-      NewRenderTargetTexture->UpdateResource();
-      NewRenderTargetTexture->UpdateTextureRegions(0, 1, NewUpdateTextureRegion, localWidth * 4, (uint32)4,
-                                                   localBuffer);
-      localBrush.SetResourceObject(NewRenderTargetTexture);
-      LocalPreviewImage->SetBrush(localBrush);
-      FUpdateTextureRegion2D* TmpUpdateTextureRegion = localUpdateTextureRegion;
-      localRenderTargetTexture = NewRenderTargetTexture;
-      localUpdateTextureRegion = NewUpdateTextureRegion;
-      delete TmpUpdateTextureRegion;
-      return;
-    }
-    localRenderTargetTexture->UpdateTextureRegions(0, 1, localUpdateTextureRegion, localWidth * 4, (uint32)4,
-                                                   localBuffer);
-  }
+  RefreshView(trtc::ue::TRTCStreamKey(nullptr, trtc::TRTCVideoStreamTypeBig), LocalPreviewImage,
+              localRenderTargetTexture, localBrush, localFrameSequence, localPreviewStarted);
   // Update Remote User View
-  if (remoteRefresh && remoteRenderTargetTexture && remoteBuffer && RemoteImage && remoteBufferSize > 4) {
-    FScopeLock lock(&remoteMutex);
-    if (remoteRenderTargetTexture->GetSizeX() != remoteWidth || remoteRenderTargetTexture->GetSizeY() != remoteHeight) {
-      UE_LOG(LogTemp, Warning,
-             TEXT("remoteBufferSize=%d, remoteWidth=%d, remoteHeight=%d  remoteRenderTargetTexture->GetSizeX =%d , "
-                  "remoteRenderTargetTexture->GetSizeY =%d"),
-             remoteBufferSize, remoteWidth, remoteHeight, remoteRenderTargetTexture->GetSizeX(),
-             remoteRenderTargetTexture->GetSizeY());
-      auto NewRMUpdateTextureRegion = new FUpdateTextureRegion2D(0, 0, 0, 0, remoteWidth, remoteHeight);
-#if PLATFORM_ANDROID
-      auto NewRMRenderTargetTexture = UTexture2D::CreateTransient(remoteWidth, remoteHeight, PF_R8G8B8A8);
-#else
-      auto NewRMRenderTargetTexture = UTexture2D::CreateTransient(remoteWidth, remoteHeight);
-#endif
-      NewRMRenderTargetTexture->UpdateResource();
-      NewRMRenderTargetTexture->UpdateTextureRegions(0, 1, NewRMUpdateTextureRegion, remoteWidth * 4, (uint32)4,
-                                                     remoteBuffer);
-      remoteBrush.SetResourceObject(NewRMRenderTargetTexture);
-      RemoteImage->SetBrush(remoteBrush);
-      FUpdateTextureRegion2D* TmpRMUpdateTextureRegion = remoteUpdateTextureRegion;
-      remoteRenderTargetTexture = NewRMRenderTargetTexture;
-      remoteUpdateTextureRegion = NewRMUpdateTextureRegion;
-      delete TmpRMUpdateTextureRegion;
-      return;
-    }
-    remoteRenderTargetTexture->UpdateTextureRegions(0, 1, remoteUpdateTextureRegion, remoteWidth * 4, (uint32)4,
-                                                    remoteBuffer);
+  if (!remoteStreamKey.userId.empty()) {
+    RefreshView(remoteStreamKey, RemoteImage, remoteRenderTargetTexture, remoteBrush, remoteFrameSequence,
+                remoteStreamAvailable);
   }
 }
 
@@ -338,21 +179,22 @@ void UBtnTRTCUserWidget::writeCallbackLog(const char* logStr) {
 void UBtnTRTCUserWidget::onUserVideoAvailable(const char* userId, bool available) {
   writeCallbackLog("onUserVideoAvailable");
   writeCallbackLog(userId);
+  trtc::ue::TRTCStreamKey key(userId, trtc::TRTCVideoStreamTypeBig);
   if (available) {
     pTRTCCloud->startRemoteView(userId, trtc::TRTCVideoStreamTypeBig, nullptr);
-#if PLATFORM_ANDROID
-    pTRTCCloud->setRemoteVideoRenderCallback(userId, trtc::TRTCVideoPixelFormat_RGBA32,
-                                             trtc::TRTCVideoBufferType_Buffer, this);
-#else
-    pTRTCCloud->setRemoteVideoRenderCallback(userId, trtc::TRTCVideoPixelFormat_BGRA32,
-                                             trtc::TRTCVideoBufferType_Buffer, this);
-#endif
+    videoHub->attachRemoteUser(userId);
+    AsyncTask(ENamedThreads::GameThread, [=]() {
+      remoteStreamKey = key;
+      remoteStreamAvailable = true;
+      remoteFrameSequence = ~0ull;
+    });
   } else {
     pTRTCCloud->stopRemoteView(userId, trtc::TRTCVideoStreamTypeBig);
-    ResetBuffer(false);
+    videoHub->clearStream(key);
     AsyncTask(ENamedThreads::GameThread, [=]() {
-      remoteRenderTargetTexture->UpdateTextureRegions(0, 1, remoteUpdateTextureRegion, remoteWidth * 4, (uint32)4,
-                                                      remoteBuffer);
+      if (remoteStreamKey == key) {
+        remoteStreamAvailable = false;
+      }
     });
   }
 }
@@ -360,20 +202,23 @@ void UBtnTRTCUserWidget::onUserVideoAvailable(const char* userId, bool available
 void UBtnTRTCUserWidget::onUserSubStreamAvailable(const char* userId, bool available) {
   writeCallbackLog("onUserSubStreamAvailable");
   writeCallbackLog(userId);
+  trtc::ue::TRTCStreamKey key(userId, trtc::TRTCVideoStreamTypeSub);
   if (available) {
     pTRTCCloud->startRemoteView(userId, trtc::TRTCVideoStreamTypeSub, nullptr);
-#if PLATFORM_ANDROID
-    pTRTCCloud->setRemoteVideoRenderCallback(userId, trtc::TRTCVideoPixelFormat_RGBA32,
-                                             trtc::TRTCVideoBufferType_Buffer, this);
-#else
-    pTRTCCloud->setRemoteVideoRenderCallback(userId, trtc::TRTCVideoPixelFormat_BGRA32,
-                                             trtc::TRTCVideoBufferType_Buffer, this);
-#endif
+    videoHub->attachRemoteUser(userId);
+    AsyncTask(ENamedThreads::GameThread, [=]() {
+      remoteStreamKey = key;
+      remoteStreamAvailable = true;
+      remoteFrameSequence = ~0ull;
+    });
   } else {
     pTRTCCloud->stopRemoteView(userId, trtc::TRTCVideoStreamTypeSub);
-    ResetBuffer(false);
-    remoteRenderTargetTexture->UpdateTextureRegions(0, 1, remoteUpdateTextureRegion, remoteWidth * 4, (uint32)4,
-                                                    remoteBuffer);
+    videoHub->clearStream(key);
+    AsyncTask(ENamedThreads::GameThread, [=]() {
+      if (remoteStreamKey == key) {
+        remoteStreamAvailable = false;
+      }
+    });
   }
 }
 
@@ -22,6 +22,8 @@
 #include <map>
 #include <mutex>
 #include "TRTCCloud.h"
+#include "TRTCFrameUpload.h"
+#include "TRTCVideoFrameHub.h"
 
 #include "BtnTRTCUserWidget.generated.h"
 
@@ -45,7 +47,7 @@ struct VideoTextureFrame {
  *
  */
 UCLASS()
-class UBtnTRTCUserWidget : public UUserWidget, public trtc::ITRTCVideoRenderCallback, public trtc::ITRTCCloudCallback {
+class UBtnTRTCUserWidget : public UUserWidget, public trtc::ITRTCCloudCallback {
   GENERATED_BODY()
  private:
   void onExitRoom(int reason) override;
@@ -100,43 +102,36 @@ class UBtnTRTCUserWidget : public UUserWidget, public trtc::ITRTCVideoRenderCall
 
   UPROPERTY(EditDefaultsOnly)
   UTexture2D* localRenderTargetTexture = nullptr;
-  FUpdateTextureRegion2D* localUpdateTextureRegion = nullptr;
   FSlateBrush localBrush;
-  FCriticalSection localMutex;
-  uint8* localBuffer = nullptr;
-  uint32_t localWidth = 0;
-  uint32_t localHeight = 0;
-  bool localRefresh = false;
-  uint32 localBufferSize = 0;
+  uint64 localFrameSequence = 0;
+  bool localPreviewStarted = false;
 
   UPROPERTY(BlueprintReadOnly, meta = (BindWidget))
   UImage* RemoteImage = nullptr;
 
   UPROPERTY(EditDefaultsOnly)
   UTexture2D* remoteRenderTargetTexture = nullptr;
-  FUpdateTextureRegion2D* remoteUpdateTextureRegion = nullptr;
   FSlateBrush remoteBrush;
-  FCriticalSection remoteMutex;
-  uint8* remoteBuffer = nullptr;
-  uint32_t remoteWidth = 0;
-  uint32_t remoteHeight = 0;
-  bool remoteRefresh = false;
-  uint32 remoteBufferSize = 0;
+  uint64 remoteFrameSequence = 0;
+  // Stream shown in RemoteImage and whether its video is available, only touched on the game thread
+  trtc::ue::TRTCStreamKey remoteStreamKey;
+  bool remoteStreamAvailable = false;
 
-  FString fLocalUserId;
+  // Receives the custom render callbacks and keeps the latest frame of every stream
+  std::unique_ptr<trtc::ue::TRTCVideoFrameHub> videoHub;
 
-  void UpdateBuffer(char* RGBBuffer, uint32_t Width, uint32_t Height, uint32_t Size, bool isLocal);
+  FString fLocalUserId;
 
-  void ResetBuffer(bool isLocal);
+  void RefreshView(const trtc::ue::TRTCStreamKey& key,
+                   UImage* image,
+                   UTexture2D*& texture,
+                   FSlateBrush& brush,
+                   uint64& sequence,
+                   bool available);
 
   void NativeTick(const FGeometry& MyGeometry, float DeltaTime) override;
 
   void NativeConstruct() override;
 
   void NativeDestruct() override;
-
-  // Customize Video Rendering Callback
-  void onRenderVideoFrame(const char* userId,
-                          trtc::TRTCVideoStreamType streamType,
-                          trtc::TRTCVideoFrame* frame) override;
 };